@@ -28,13 +28,15 @@ void free_huffman_tree(HuffmanNode* node) {
 }
 
 // Функция для чтения заголовка в совместимом формате
-int read_compatible_header(FILE* input, BaseHeader* base_header, int* format_type) {
+int read_compatible_header(FILE* input, BaseHeader* base_header, int* format_type, unsigned char* context_model) {
     // Сохраняем текущую позицию
     long start_pos = ftell(input);
+    *context_model = CONTEXT_MODEL_NONE;
     
     // Пытаемся прочитать базовый заголовок нового формата
     if (fread(base_header, sizeof(BaseHeader), 1, input) == 1) {
-        if (memcmp(base_header->signature, SEROSA_SIGNATURE, 6) == 0) {
+        if (memcmp(base_header->signature, SEROSA_SIGNATURE, 6) == 0 &&
+            base_header->version != LEGACY_HUFFMAN_VERSION) {
             *format_type = 1; // Новый формат
             return 0;
         }
@@ -58,7 +60,6 @@ int read_compatible_header(FILE* input, BaseHeader* base_header, int* format_typ
     if (fread(&compression_with_context, 1, 1, input) != 1) return -1;
     if (fread(&error_protection, 1, 1, input) != 1) return -1;
     if (fread(&original_size, sizeof(uint64_t), 1, input) != 1) return -1;
-    if (fread(reserved, 1, 5, input) != 5) return -1;
     
     if (memcmp(signature, SEROSA_SIGNATURE, 6) != 0) {
         return -1;
@@ -70,6 +71,14 @@ int read_compatible_header(FILE* input, BaseHeader* base_header, int* format_typ
     base_header->algorithm = compression_no_context;
     base_header->original_size = original_size;
     
+    if (major_version == LEGACY_HUFFMAN_VERSION) {
+        // Архив huffman.c: поля Хаффмана идут сразу за original_size
+        *context_model = compression_with_context;
+        *format_type = 3;
+        return 0;
+    }
+    
+    if (fread(reserved, 1, 5, input) != 5) return -1;
     *format_type = 2; // Старый формат из Л3.№3
     return 0;
 }
@@ -154,7 +163,7 @@ int decode_huffman(FILE* input, FILE* output, BaseHeader* base_header, int forma
         compressed_size_bits = header.compressed_size_bits;
         tree_leaf_count = header.tree_leaf_count;
     } else {
-        // Старый формат - читаем дополнительные поля
+        // Старый формат и архивы huffman.c - читаем дополнительные поля
         if (fread(&compressed_size_bits, sizeof(uint64_t), 1, input) != 1) return -1;
         if (fread(&tree_leaf_count, sizeof(uint16_t), 1, input) != 1) return -1;
         
@@ -217,13 +226,157 @@ int decode_huffman(FILE* input, FILE* output, BaseHeader* base_header, int forma
     return 0;
 }
 
+// Таблица декодирования контекста: индекс - следующие bits бит потока,
+// элемент - символ в младшем байте и длина кода в старшем
+typedef struct {
+    int bits;
+    uint16_t* entries;
+} ContextDecoder;
+
+// Чтение таблицы одного контекста (формат huffman_context.c) и построение
+// таблицы декодирования по каноническим кодам
+static int read_context_table(FILE* input, ContextDecoder* decoder) {
+    uint8_t present[256] = {0};
+    uint8_t lengths[256] = {0};
+
+    int byte = fgetc(input);
+    if (byte == EOF) return -1;
+    int count = byte + 1;
+
+    if (count <= CONTEXT_SPARSE_LIMIT) {
+        for (int i = 0; i < count; i++) {
+            int symbol = fgetc(input);
+            if (symbol == EOF || present[symbol]) return -1;
+            present[symbol] = 1;
+        }
+    } else {
+        uint8_t bitmap[32];
+        if (fread(bitmap, 1, sizeof(bitmap), input) != sizeof(bitmap)) return -1;
+        int found = 0;
+        for (int i = 0; i < 256; i++) {
+            present[i] = (bitmap[i >> 3] >> (i & 7)) & 1;
+            found += present[i];
+        }
+        if (found != count) return -1;
+    }
+
+    int index = 0;
+    int max_length = 0;
+    int length_count[CONTEXT_MAX_CODE_LENGTH + 1] = {0};
+    for (int i = 0; i < 256; i++) {
+        if (!present[i]) continue;
+        if ((index & 1) == 0) {
+            byte = fgetc(input);
+            if (byte == EOF) return -1;
+            lengths[i] = (uint8_t)(byte >> 4);
+        } else {
+            lengths[i] = (uint8_t)(byte & 0x0F);
+        }
+        index++;
+        if ((lengths[i] == 0) != (count == 1) || lengths[i] > CONTEXT_MAX_CODE_LENGTH) return -1;
+        if (lengths[i] > 0) length_count[lengths[i]]++;
+        if (lengths[i] > max_length) max_length = lengths[i];
+    }
+
+    uint32_t next_code[CONTEXT_MAX_CODE_LENGTH + 1];
+    uint32_t code = 0;
+    for (int length = 1; length <= CONTEXT_MAX_CODE_LENGTH; length++) {
+        code = (code + length_count[length - 1]) << 1;
+        next_code[length] = code;
+    }
+
+    decoder->bits = max_length;
+    decoder->entries = (uint16_t*)calloc((size_t)1 << max_length, sizeof(uint16_t));
+    if (decoder->entries == NULL) return -1;
+
+    for (int i = 0; i < 256; i++) {
+        if (!present[i]) continue;
+        uint32_t first = 0;
+        int shift = max_length - lengths[i];
+        if (lengths[i] > 0) {
+            first = next_code[lengths[i]]++ << shift;
+        }
+        uint32_t last = first + (1u << shift);
+        if (last > (1u << max_length)) return -1; // длины нарушают неравенство Крафта
+        for (uint32_t j = first; j < last; j++) {
+            decoder->entries[j] = (uint16_t)(i | (lengths[i] << 8));
+        }
+    }
+    return 0;
+}
+
+// Декодер Хаффмана с контекстной моделью первого порядка
+int decode_huffman_context(FILE* input, FILE* output, BaseHeader* base_header) {
+    printf("Using algorithm: Huffman coding, order-1 context model\n");
+
+    uint64_t compressed_size_bits;
+    uint16_t context_count;
+    unsigned char reserved[3];
+    uint8_t used[32];
+    if (fread(&compressed_size_bits, sizeof(uint64_t), 1, input) != 1) return -1;
+    if (fread(&context_count, sizeof(uint16_t), 1, input) != 1) return -1;
+    if (fread(reserved, 1, 3, input) != 3) return -1;
+    if (fread(used, 1, sizeof(used), input) != sizeof(used)) return -1;
+
+    printf("Original size: %lu bytes\n", (unsigned long)base_header->original_size);
+    printf("Compressed bits: %lu\n", (unsigned long)compressed_size_bits);
+    printf("Contexts: %u\n", context_count);
+
+    ContextDecoder* decoders = (ContextDecoder*)calloc(256, sizeof(ContextDecoder));
+    if (decoders == NULL) return -1;
+
+    int result = 0;
+    for (int context = 0; context < 256 && result == 0; context++) {
+        if ((used[context >> 3] & (1 << (context & 7))) && read_context_table(input, &decoders[context]) != 0) {
+            fprintf(stderr, "Error reading table for context %d\n", context);
+            result = -1;
+        }
+    }
+
+    // Биты копятся в acc младшими разрядами; за концом файла подставляются нули
+    uint64_t acc = 0;
+    int count = 0;
+    int previous = 0;
+    uint64_t bytes_written = 0;
+    while (result == 0 && bytes_written < base_header->original_size) {
+        const ContextDecoder* decoder = &decoders[previous];
+        if (decoder->entries == NULL) {
+            fprintf(stderr, "Error: unknown context %d\n", previous);
+            result = -1;
+            break;
+        }
+        while (count < 56) {
+            int byte = fgetc(input);
+            acc = (acc << 8) | (byte == EOF ? 0 : (uint8_t)byte);
+            count += 8;
+        }
+        uint32_t index = (uint32_t)(acc >> (count - decoder->bits)) & ((1u << decoder->bits) - 1);
+        uint16_t entry = decoder->entries[index];
+        count -= entry >> 8;
+        previous = entry & 0xFF;
+        fputc(previous, output);
+        bytes_written++;
+    }
+
+    if (result == 0) {
+        printf("Successfully decompressed %lu bytes\n", (unsigned long)bytes_written);
+    }
+
+    for (int context = 0; context < 256; context++) {
+        free(decoders[context].entries);
+    }
+    free(decoders);
+    return result;
+}
+
 // Определение формата и выбор декодера
 int detect_format_and_decode(FILE* input, FILE* output) {
     BaseHeader base_header;
     int format_type;
+    unsigned char context_model;
     
     // Читаем заголовок в совместимом формате
-    if (read_compatible_header(input, &base_header, &format_type) != 0) {
+    if (read_compatible_header(input, &base_header, &format_type, &context_model) != 0) {
         fprintf(stderr, "Invalid file signature. Expected 'SEROSA'\n");
         return -1;
     }
@@ -231,9 +384,18 @@ int detect_format_and_decode(FILE* input, FILE* output) {
     uint8_t major_version = (base_header.version >> 8) & 0xFF;
     uint8_t minor_version = base_header.version & 0xFF;
     
-    printf("Detected format: SEROSA v%d.%d, Algorithm: %d, Format type: %s\n",
-           major_version, minor_version, base_header.algorithm,
-           format_type == 1 ? "new" : "old");
+    printf("Detected format: SEROSA v%d.%d, Algorithm: %d, Context model: %d, Format type: %s\n",
+           major_version, minor_version, base_header.algorithm, context_model,
+           format_type == 1 ? "new" : (format_type == 2 ? "old" : "huffman"));
+
+    // Контекстная модель задаёт свой формат таблиц, поле алгоритма при этом не используется
+    if (context_model == CONTEXT_MODEL_ORDER1) {
+        return decode_huffman_context(input, output, &base_header);
+    }
+    if (context_model != CONTEXT_MODEL_NONE) {
+        fprintf(stderr, "Unsupported context model: %d\n", context_model);
+        return -1;
+    }
 
     // Выбираем соответствующий декодер
     switch (base_header.algorithm) {
@@ -285,5 +447,6 @@ void print_supported_formats() {
     printf("Supported SEROSA formats:\n");
     printf("  - Old format (Л3.№3): No compression\n");
     printf("  - New format (Л4.№1): No compression and Huffman coding\n");
+    printf("  - Huffman format (v2): Huffman coding, order-1 context Huffman coding\n");
     printf("  - All versions with proper 'SEROSA' signature\n");
 }
\ No newline at end of file
@@ -12,6 +12,15 @@
 #define ALGORITHM_NO_COMPRESSION 0
 #define ALGORITHM_HUFFMAN 1
 
+// Архивы huffman.c: major_version = 2, заголовок HuffmanHeader из huffman.h
+#define LEGACY_HUFFMAN_VERSION 2
+
+// Значения поля compression_with_context
+#define CONTEXT_MODEL_NONE 0
+#define CONTEXT_MODEL_ORDER1 1
+#define CONTEXT_MAX_CODE_LENGTH 12
+#define CONTEXT_SPARSE_LIMIT 32
+
 #pragma pack(push, 1)
 // Базовый заголовок
 typedef struct {
@@ -33,11 +42,12 @@ typedef struct {
 // Универсальные функции
 int universal_decode(const char* input_path, const char* output_path);
 int detect_format_and_decode(FILE* input, FILE* output);
-int read_compatible_header(FILE* input, BaseHeader* base_header, int* format_type);
+int read_compatible_header(FILE* input, BaseHeader* base_header, int* format_type, unsigned char* context_model);
 void print_supported_formats();
 
 // Декодеры
 int decode_no_compression(FILE* input, FILE* output, BaseHeader* header, int format_type);
 int decode_huffman(FILE* input, FILE* output, BaseHeader* base_header, int format_type);
+int decode_huffman_context(FILE* input, FILE* output, BaseHeader* base_header);
 
 #endif
\ No newline at end of file
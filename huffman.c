@@ -1,5 +1,6 @@
 #include "huffman.h"
 #include <limits.h>
+#include <stddef.h>
 
 // Создание нового узла
 HuffmanNode* create_node(unsigned char symbol, int frequency) {
@@ -178,14 +179,16 @@ int huffman_compress(const char* input_file, const char* output_file) {
     header.major_version = 2;
     header.minor_version = 0;
     header.compression_no_context = HUFFMAN_ALGORITHM_CODE;
-    header.compression_with_context = 0;
+    header.compression_with_context = CONTEXT_MODEL_NONE;
     header.error_protection = 0;
     header.original_size = file_size;
     header.tree_leaf_count = count_tree_leaves(root);
     memset(header.reserved, 0, 3);
     
+    header.compressed_size_bits = 0;
+    
     // Пока неизвестно compressed_size_bits, запишем позже
-    long compressed_size_pos = sizeof(header) - sizeof(uint64_t);
+    long compressed_size_pos = offsetof(HuffmanHeader, compressed_size_bits);
     fwrite(&header, sizeof(header), 1, output);
     
     // Записываем дерево
@@ -268,6 +271,23 @@ int huffman_decompress(const char* input_file, const char* output_file) {
         return -1;
     }
 
+    // Контекстный режим имеет свой формат таблиц и данных
+    if (header.compression_with_context == CONTEXT_MODEL_ORDER1) {
+        int result = huffman_decompress_context(input, output, &header);
+        fclose(input);
+        fclose(output);
+        if (result == 0) {
+            printf("Decompression completed successfully\n");
+        }
+        return result;
+    }
+    if (header.compression_with_context != CONTEXT_MODEL_NONE) {
+        fprintf(stderr, "Unsupported context model: %d\n", header.compression_with_context);
+        fclose(input);
+        fclose(output);
+        return -1;
+    }
+
     // Проверяем алгоритм
     if (header.compression_no_context != HUFFMAN_ALGORITHM_CODE) {
         fprintf(stderr, "Unsupported algorithm code: %d\n", header.compression_no_context);
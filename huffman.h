@@ -11,6 +11,12 @@
 #define HUFFMAN_ALGORITHM_CODE 1
 #define HUFFMAN_VERSION 2
 
+// Значения поля compression_with_context
+#define CONTEXT_MODEL_NONE 0
+#define CONTEXT_MODEL_ORDER1 1          // своя таблица кодов на каждый предыдущий байт
+#define CONTEXT_MAX_CODE_LENGTH 12      // ограничение длины кода для таблиц декодирования
+#define CONTEXT_SPARSE_LIMIT 32         // до стольких символов контекст хранится списком
+
 #pragma pack(push, 1)
 typedef struct {
     unsigned char signature[6];
@@ -42,6 +48,15 @@ typedef struct {
 int huffman_compress(const char* input_file, const char* output_file);
 int huffman_decompress(const char* input_file, const char* output_file);
 
+// Контекстное сжатие первого порядка (huffman_context.c)
+int huffman_compress_context(const char* input_file, const char* output_file);
+int huffman_decompress_context(FILE* input, FILE* output, const HuffmanHeader* header);
+
+// Построение дерева и кодов (используется обоими режимами)
+HuffmanNode* build_huffman_tree(int* frequencies);
+void build_codes(HuffmanNode* root, HuffmanCode* codes);
+void free_huffman_tree(HuffmanNode* node);
+
 // Функции анализа для Л2.№1
 void analyze_file(const char* filename);
 double calculate_information_bits(int* frequencies, uint64_t file_size);
@@ -0,0 +1,382 @@
+#include "huffman.h"
+#include <stddef.h>
+
+// Контекстная модель первого порядка: для каждого значения предыдущего байта
+// строится свой канонический код Хаффмана. Первый байт кодируется в контексте 0.
+//
+// Формат после заголовка:
+//   32 байта - битовая карта используемых контекстов;
+//   для каждого используемого контекста по возрастанию:
+//     1 байт  - число символов минус один;
+//     символы - списком (до CONTEXT_SPARSE_LIMIT штук) или битовой картой 32 байта;
+//     длины кодов по 4 бита на символ, старшая половина байта первой;
+//   далее поток кодов, старшие биты вперёд.
+// Контекст с единственным символом получает код нулевой длины и бит не тратит.
+
+typedef struct {
+    FILE* file;
+    uint64_t acc;
+    int count;
+    uint64_t bits_written;
+} BitOutput;
+
+typedef struct {
+    FILE* file;
+    unsigned char buffer[65536];
+    size_t pos;
+    size_t size;
+    uint64_t acc;
+    int count;
+} BitInput;
+
+// Таблица декодирования контекста: индекс - следующие bits бит потока,
+// элемент - символ в младшем байте и длина кода в старшем
+typedef struct {
+    int bits;
+    uint16_t* entries;
+} ContextDecoder;
+
+static void put_bits(BitOutput* out, uint32_t code, int length) {
+    out->acc = (out->acc << length) | code;
+    out->count += length;
+    out->bits_written += length;
+    while (out->count >= 8) {
+        out->count -= 8;
+        fputc((int)((out->acc >> out->count) & 0xFF), out->file);
+    }
+}
+
+static void flush_bits(BitOutput* out) {
+    if (out->count > 0) {
+        fputc((int)((out->acc << (8 - out->count)) & 0xFF), out->file);
+        out->count = 0;
+    }
+}
+
+static void refill_bits(BitInput* in) {
+    while (in->count < 56) {
+        if (in->pos == in->size) {
+            in->size = fread(in->buffer, 1, sizeof(in->buffer), in->file);
+            in->pos = 0;
+        }
+        // За концом файла подставляются нули: декодер останавливается по original_size
+        uint8_t byte = in->pos < in->size ? in->buffer[in->pos++] : 0;
+        in->acc = (in->acc << 8) | byte;
+        in->count += 8;
+    }
+}
+
+// Длины кодов Хаффмана, не превышающие CONTEXT_MAX_CODE_LENGTH:
+// пока дерево слишком глубокое, частоты делятся пополам (ненулевые остаются ненулевыми)
+static void build_limited_lengths(const int* frequencies, uint8_t* lengths) {
+    int scaled[256];
+    memcpy(scaled, frequencies, sizeof(scaled));
+
+    for (;;) {
+        HuffmanNode* root = build_huffman_tree(scaled);
+        HuffmanCode codes[256];
+        build_codes(root, codes);
+        free_huffman_tree(root);
+
+        int max_length = 0;
+        for (int i = 0; i < 256; i++) {
+            lengths[i] = codes[i].length;
+            if (lengths[i] > max_length) max_length = lengths[i];
+        }
+        if (max_length <= CONTEXT_MAX_CODE_LENGTH) return;
+
+        for (int i = 0; i < 256; i++) {
+            if (scaled[i] > 0) scaled[i] = (scaled[i] + 1) / 2;
+        }
+    }
+}
+
+// Канонические коды: по возрастанию длины, внутри длины - по возрастанию символа.
+// Возвращает 0, если длины не образуют префиксный код.
+static int assign_canonical_codes(const uint8_t* present, const uint8_t* lengths, HuffmanCode* codes) {
+    int length_count[CONTEXT_MAX_CODE_LENGTH + 1] = {0};
+    uint32_t next_code[CONTEXT_MAX_CODE_LENGTH + 1];
+
+    for (int i = 0; i < 256; i++) {
+        if (present[i] && lengths[i] > 0) length_count[lengths[i]]++;
+    }
+
+    uint32_t code = 0;
+    for (int length = 1; length <= CONTEXT_MAX_CODE_LENGTH; length++) {
+        code = (code + length_count[length - 1]) << 1;
+        next_code[length] = code;
+    }
+    // Переполнение последней длины означает нарушение неравенства Крафта
+    if (next_code[CONTEXT_MAX_CODE_LENGTH] + length_count[CONTEXT_MAX_CODE_LENGTH] > (1u << CONTEXT_MAX_CODE_LENGTH)) {
+        return 0;
+    }
+
+    for (int i = 0; i < 256; i++) {
+        codes[i].code = 0;
+        codes[i].length = 0;
+        if (present[i] && lengths[i] > 0) {
+            codes[i].code = next_code[lengths[i]]++;
+            codes[i].length = lengths[i];
+        }
+    }
+    return 1;
+}
+
+static void write_context_table(FILE* output, const int* frequencies, const uint8_t* lengths) {
+    int count = 0;
+    uint8_t bitmap[32] = {0};
+    for (int i = 0; i < 256; i++) {
+        if (frequencies[i] > 0) {
+            bitmap[i >> 3] |= (uint8_t)(1 << (i & 7));
+            count++;
+        }
+    }
+
+    fputc(count - 1, output);
+    if (count <= CONTEXT_SPARSE_LIMIT) {
+        for (int i = 0; i < 256; i++) {
+            if (frequencies[i] > 0) fputc(i, output);
+        }
+    } else {
+        fwrite(bitmap, 1, sizeof(bitmap), output);
+    }
+
+    int pending = -1;
+    for (int i = 0; i < 256; i++) {
+        if (frequencies[i] == 0) continue;
+        if (pending < 0) {
+            pending = lengths[i] << 4;
+        } else {
+            fputc(pending | lengths[i], output);
+            pending = -1;
+        }
+    }
+    if (pending >= 0) fputc(pending, output);
+}
+
+// Читает таблицу контекста и строит по ней таблицу декодирования
+static int read_context_table(FILE* input, ContextDecoder* decoder) {
+    uint8_t present[256] = {0};
+    uint8_t lengths[256] = {0};
+    HuffmanCode codes[256];
+
+    int byte = fgetc(input);
+    if (byte == EOF) return -1;
+    int count = byte + 1;
+
+    if (count <= CONTEXT_SPARSE_LIMIT) {
+        for (int i = 0; i < count; i++) {
+            int symbol = fgetc(input);
+            if (symbol == EOF || present[symbol]) return -1;
+            present[symbol] = 1;
+        }
+    } else {
+        uint8_t bitmap[32];
+        if (fread(bitmap, 1, sizeof(bitmap), input) != sizeof(bitmap)) return -1;
+        int found = 0;
+        for (int i = 0; i < 256; i++) {
+            present[i] = (bitmap[i >> 3] >> (i & 7)) & 1;
+            found += present[i];
+        }
+        if (found != count) return -1;
+    }
+
+    int index = 0;
+    int max_length = 0;
+    for (int i = 0; i < 256; i++) {
+        if (!present[i]) continue;
+        if ((index & 1) == 0) {
+            byte = fgetc(input);
+            if (byte == EOF) return -1;
+            lengths[i] = (uint8_t)(byte >> 4);
+        } else {
+            lengths[i] = (uint8_t)(byte & 0x0F);
+        }
+        index++;
+        // Нулевая длина допустима только у единственного символа контекста
+        if ((lengths[i] == 0) != (count == 1) || lengths[i] > CONTEXT_MAX_CODE_LENGTH) return -1;
+        if (lengths[i] > max_length) max_length = lengths[i];
+    }
+
+    if (!assign_canonical_codes(present, lengths, codes)) return -1;
+
+    decoder->bits = max_length;
+    decoder->entries = (uint16_t*)calloc((size_t)1 << max_length, sizeof(uint16_t));
+    if (decoder->entries == NULL) return -1;
+
+    // Код длины L занимает 2^(bits - L) подряд идущих элементов
+    for (int i = 0; i < 256; i++) {
+        if (!present[i]) continue;
+        int shift = max_length - codes[i].length;
+        uint32_t first = codes[i].code << shift;
+        uint32_t last = first + (1u << shift);
+        for (uint32_t j = first; j < last; j++) {
+            decoder->entries[j] = (uint16_t)(i | (codes[i].length << 8));
+        }
+    }
+    return 0;
+}
+
+int huffman_compress_context(const char* input_file, const char* output_file) {
+    FILE* input = fopen(input_file, "rb");
+    if (!input) {
+        perror("Failed to open input file");
+        return -1;
+    }
+
+    // Частоты пар (предыдущий байт, текущий байт)
+    int (*frequencies)[256] = calloc(256, sizeof(*frequencies));
+    uint8_t (*lengths)[256] = calloc(256, sizeof(*lengths));
+    HuffmanCode (*codes)[256] = calloc(256, sizeof(*codes));
+    if (!frequencies || !lengths || !codes) {
+        fprintf(stderr, "Out of memory\n");
+        free(frequencies);
+        free(lengths);
+        free(codes);
+        fclose(input);
+        return -1;
+    }
+
+    uint64_t file_size = 0;
+    int previous = 0;
+    int ch;
+    while ((ch = getc(input)) != EOF) {
+        frequencies[previous][ch]++;
+        previous = ch;
+        file_size++;
+    }
+
+    uint8_t used[32] = {0};
+    uint16_t used_count = 0;
+    for (int context = 0; context < 256; context++) {
+        uint8_t present[256];
+        int count = 0;
+        for (int i = 0; i < 256; i++) {
+            present[i] = frequencies[context][i] > 0;
+            count += present[i];
+        }
+        if (count == 0) continue;
+
+        used[context >> 3] |= (uint8_t)(1 << (context & 7));
+        used_count++;
+        build_limited_lengths(frequencies[context], lengths[context]);
+        assign_canonical_codes(present, lengths[context], codes[context]);
+    }
+
+    FILE* output = fopen(output_file, "wb");
+    if (!output) {
+        perror("Failed to open output file");
+        free(frequencies);
+        free(lengths);
+        free(codes);
+        fclose(input);
+        return -1;
+    }
+
+    HuffmanHeader header;
+    memcpy(header.signature, SEROSA_SIGNATURE, 6);
+    header.major_version = HUFFMAN_VERSION;
+    header.minor_version = 0;
+    header.compression_no_context = 0;
+    header.compression_with_context = CONTEXT_MODEL_ORDER1;
+    header.error_protection = 0;
+    header.original_size = file_size;
+    header.compressed_size_bits = 0;
+    header.tree_leaf_count = used_count;  // в контекстном режиме - число непустых контекстов
+    memset(header.reserved, 0, 3);
+
+    long compressed_size_pos = offsetof(HuffmanHeader, compressed_size_bits);
+    fwrite(&header, sizeof(header), 1, output);
+
+    fwrite(used, 1, sizeof(used), output);
+    for (int context = 0; context < 256; context++) {
+        if (used[context >> 3] & (1 << (context & 7))) {
+            write_context_table(output, frequencies[context], lengths[context]);
+        }
+    }
+    long tables_end = ftell(output);
+
+    BitOutput bits = {output, 0, 0, 0};
+    fseek(input, 0, SEEK_SET);
+    previous = 0;
+    while ((ch = getc(input)) != EOF) {
+        HuffmanCode code = codes[previous][ch];
+        put_bits(&bits, code.code, code.length);
+        previous = ch;
+    }
+    flush_bits(&bits);
+    long total_size = ftell(output);
+
+    header.compressed_size_bits = bits.bits_written;
+    fseek(output, compressed_size_pos, SEEK_SET);
+    fwrite(&header.compressed_size_bits, sizeof(uint64_t), 1, output);
+
+    fclose(input);
+    fclose(output);
+    free(frequencies);
+    free(lengths);
+    free(codes);
+
+    printf("Context compression completed (order 1):\n");
+    printf("  Original size: %lu bytes\n", (unsigned long)file_size);
+    printf("  Used contexts: %u\n", used_count);
+    printf("  Context tables: %ld bytes\n", tables_end - (long)sizeof(header));
+    printf("  Compressed size: %ld bytes\n", total_size);
+    if (file_size > 0) {
+        printf("  Compression ratio: %.2f%%\n", (1.0 - (double)total_size / file_size) * 100);
+    }
+    return 0;
+}
+
+int huffman_decompress_context(FILE* input, FILE* output, const HuffmanHeader* header) {
+    uint8_t used[32];
+    if (fread(used, 1, sizeof(used), input) != sizeof(used)) {
+        fprintf(stderr, "Error reading context map\n");
+        return -1;
+    }
+
+    ContextDecoder* decoders = calloc(256, sizeof(ContextDecoder));
+    BitInput* in = malloc(sizeof(BitInput));
+    if (!decoders || !in) {
+        fprintf(stderr, "Out of memory\n");
+        free(decoders);
+        free(in);
+        return -1;
+    }
+
+    int result = 0;
+    for (int context = 0; context < 256 && result == 0; context++) {
+        if ((used[context >> 3] & (1 << (context & 7))) && read_context_table(input, &decoders[context]) != 0) {
+            fprintf(stderr, "Error reading table for context %d\n", context);
+            result = -1;
+        }
+    }
+
+    in->file = input;
+    in->pos = in->size = 0;
+    in->acc = 0;
+    in->count = 0;
+
+    int previous = 0;
+    for (uint64_t i = 0; i < header->original_size && result == 0; i++) {
+        const ContextDecoder* decoder = &decoders[previous];
+        if (decoder->entries == NULL) {
+            fprintf(stderr, "Corrupted data: unknown context %d\n", previous);
+            result = -1;
+            break;
+        }
+        refill_bits(in);
+        uint32_t index = (uint32_t)(in->acc >> (in->count - decoder->bits)) & ((1u << decoder->bits) - 1);
+        uint16_t entry = decoder->entries[index];
+        in->count -= entry >> 8;
+        previous = entry & 0xFF;
+        putc(previous, output);
+    }
+
+    for (int context = 0; context < 256; context++) {
+        free(decoders[context].entries);
+    }
+    free(decoders);
+    free(in);
+    return result;
+}
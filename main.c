@@ -6,6 +6,7 @@ void print_usage(const char* program_name) {
     printf("Usage: %s <command> <input_file> [output_file]\n", program_name);
     printf("Commands:\n");
     printf("  -c    Compress file\n");
+    printf("  -C    Compress file with order-1 context model\n");
     printf("  -d    Decompress file\n");
     printf("  -a    Analyze file (L2.No1)\n");
 }
@@ -23,6 +24,13 @@ int main(int argc, char* argv[]) {
             return 1;
         }
         return huffman_compress(argv[2], argv[3]);
+    } else if (strcmp(argv[1], "-C") == 0) {
+        if (argc != 4) {
+            printf("Error: compress requires input and output files\n");
+            print_usage(argv[0]);
+            return 1;
+        }
+        return huffman_compress_context(argv[2], argv[3]);
     } else if (strcmp(argv[1], "-d") == 0) {
         if (argc != 4) {
             printf("Error: decompress requires input and output files\n");
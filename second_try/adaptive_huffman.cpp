@@ -0,0 +1,99 @@
+#include "adaptive_huffman.h"
+#include "bitstream.h"
+#include <algorithm>
+#include <stdexcept>
+
+void AdaptiveHuffman::reset() {
+    std::fill(weight, weight + MAX_NODES, 0);
+    std::fill(parent, parent + MAX_NODES, -1);
+    std::fill(left, left + MAX_NODES, -1);
+    std::fill(right, right + MAX_NODES, -1);
+    std::fill(symbols, symbols + MAX_NODES, 0);
+    std::fill(leafOf, leafOf + SYMBOL_COUNT, -1);
+    nyt = ROOT;
+}
+
+int32_t AdaptiveHuffman::findLeader(int32_t node) const {
+    // Веса на [nyt, ROOT] не убывают: последний узел с тем же весом
+    const uint64_t* last = std::upper_bound(weight + node, weight + MAX_NODES, weight[node]);
+    return static_cast<int32_t>(last - weight) - 1;
+}
+
+void AdaptiveHuffman::swapNodes(int32_t a, int32_t b) {
+    // Родитель привязан к ячейке, поэтому меняются только поддеревья
+    std::swap(left[a], left[b]);
+    std::swap(right[a], right[b]);
+    std::swap(symbols[a], symbols[b]);
+    std::swap(weight[a], weight[b]);
+    for (int32_t node : {a, b}) {
+        if (isLeaf(node)) {
+            leafOf[symbols[node]] = node;
+        } else {
+            parent[left[node]] = node;
+            parent[right[node]] = node;
+        }
+    }
+}
+
+void AdaptiveHuffman::update(uint32_t value) {
+    int32_t node = leafOf[value];
+    if (node < 0) {
+        // NYT делится на внутренний узел, новый NYT (слева) и лист символа (справа)
+        int32_t internal = nyt;
+        int32_t leaf = nyt - 1;
+        nyt -= 2;
+
+        left[internal] = nyt;
+        right[internal] = leaf;
+        parent[nyt] = internal;
+        parent[leaf] = internal;
+        left[leaf] = right[leaf] = -1;
+        left[nyt] = right[nyt] = -1;
+        weight[leaf] = weight[nyt] = 0;
+        symbols[leaf] = value;
+        leafOf[value] = leaf;
+        node = leaf;
+    }
+
+    while (node != ROOT) {
+        int32_t leader = findLeader(node);
+        if (leader != node && leader != parent[node]) {
+            swapNodes(node, leader);
+            node = leader;
+        }
+        weight[node]++;
+        node = parent[node];
+    }
+    weight[ROOT]++;
+}
+
+size_t AdaptiveHuffmanCode::encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+    AdaptiveHuffman model;
+    BitWriter out(dst, capacity);
+    for (size_t i = 0; i < size; i++) {
+        model.encodeSymbol(src[i], out);
+    }
+    model.encodeSymbol(AdaptiveHuffman::END_OF_STREAM, out);
+    out.flush();
+    return out.bytesWritten();
+}
+
+void AdaptiveHuffmanCode::decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size) {
+    AdaptiveHuffman model;
+    BitReader in(src, srcSize);
+    size_t count = 0;
+    for (;;) {
+        uint32_t symbol = model.decodeSymbol(in);
+        if (in.overrun()) {
+            throw std::runtime_error("Corrupted adaptive Huffman stream: unexpected end of data");
+        }
+        if (symbol == AdaptiveHuffman::END_OF_STREAM) break;
+        if (count >= size) {
+            throw std::runtime_error("Adaptive Huffman stream is longer than declared");
+        }
+        dst[count++] = static_cast<uint8_t>(symbol);
+    }
+    if (count != size) {
+        throw std::runtime_error("Adaptive Huffman stream is shorter than declared");
+    }
+}
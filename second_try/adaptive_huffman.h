@@ -0,0 +1,112 @@
+// adaptive_huffman.h - однопроходный адаптивный Хаффман (FGK)
+#pragma once
+#include "common.h"
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+// Кодер и декодер одинаково перестраивают дерево после каждого символа,
+// поэтому ни предварительного прохода, ни таблицы частот не нужно.
+//
+// Дерево хранится в массивах фиксированного размера. Номер узла в смысле
+// FGK - это его индекс: корень - последний элемент, веса не убывают с
+// ростом индекса (свойство братства). Поэтому лидер блока одинаковых весов
+// находится двоичным поиском, а обмен узлов - это обмен содержимого двух
+// ячеек без перестройки указателей родителей.
+//
+// Новый символ передаётся кодом узла NYT и RAW_BITS битами значения.
+// Поток заканчивается символом END_OF_STREAM, так что длина входа
+// заранее может быть неизвестна.
+class AdaptiveHuffman {
+public:
+    static const uint32_t END_OF_STREAM = Common::ALPHABET_SIZE;
+    static const uint32_t SYMBOL_COUNT = Common::ALPHABET_SIZE + 1;
+    static const int RAW_BITS = 9;
+    // Верхняя граница кода одного символа в байтах: путь до корня и сырые биты
+    static const int MAX_CODE_BYTES = (2 * SYMBOL_COUNT + RAW_BITS) / 8 + 1;
+
+    AdaptiveHuffman() { reset(); }
+
+    void reset();
+
+    template <class Writer>
+    void encodeSymbol(uint32_t symbol, Writer& out) {
+        int32_t leaf = leafOf[symbol];
+        if (leaf < 0) {
+            writePath(nyt, out);
+            out.writeBits(symbol, RAW_BITS);
+        } else {
+            writePath(leaf, out);
+        }
+        update(symbol);
+    }
+
+    // Reader - BitReader или BitInputStream (нужен только readBit)
+    template <class Reader>
+    uint32_t decodeSymbol(Reader& in) {
+        int32_t node = ROOT;
+        while (!isLeaf(node)) {
+            node = in.readBit() ? right[node] : left[node];
+        }
+        uint32_t symbol;
+        if (node == nyt) {
+            symbol = 0;
+            for (int i = 0; i < RAW_BITS; i++) {
+                symbol = (symbol << 1) | (in.readBit() ? 1 : 0);
+            }
+            if (symbol >= SYMBOL_COUNT || leafOf[symbol] >= 0) {
+                throw std::runtime_error("Corrupted adaptive Huffman stream");
+            }
+        } else {
+            symbol = symbols[node];
+        }
+        update(symbol);
+        return symbol;
+    }
+
+private:
+    // Начальный NYT и по два узла на каждый новый символ: когда лист
+    // получает и END_OF_STREAM, в дереве 2 * SYMBOL_COUNT + 1 узел
+    static const int32_t MAX_NODES = 2 * SYMBOL_COUNT + 1;
+    static const int32_t ROOT = MAX_NODES - 1;
+
+    bool isLeaf(int32_t node) const { return left[node] < 0; }
+
+    template <class Writer>
+    void writePath(int32_t node, Writer& out) const {
+        // Биты собираются от листа к корню, а пишутся от корня
+        uint8_t path[MAX_NODES];
+        int length = 0;
+        for (; node != ROOT; node = parent[node]) {
+            path[length++] = right[parent[node]] == node ? 1 : 0;
+        }
+        while (length > 0) {
+            int count = length < 32 ? length : 32;
+            uint32_t bits = 0;
+            for (int i = 0; i < count; i++) {
+                bits = (bits << 1) | path[--length];
+            }
+            out.writeBits(bits, count);
+        }
+    }
+
+    void update(uint32_t symbol);
+    int32_t findLeader(int32_t node) const;
+    void swapNodes(int32_t a, int32_t b);
+
+    uint64_t weight[MAX_NODES];
+    int32_t parent[MAX_NODES];
+    int32_t left[MAX_NODES];
+    int32_t right[MAX_NODES];
+    uint32_t symbols[MAX_NODES];
+    int32_t leafOf[SYMBOL_COUNT];
+    int32_t nyt;  // узел "ещё не передавался"; занятые узлы - [nyt, ROOT]
+};
+
+class AdaptiveHuffmanCode {
+public:
+    // Возвращает размер закодированных данных; std::length_error, если не хватает места
+    static size_t encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity);
+    // Декодирует до END_OF_STREAM; число символов должно совпасть с size
+    static void decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size);
+};
@@ -1,16 +1,64 @@
 // analyzer.cpp - анализатор файлов
 #include "frequency.h"
+#include "block_split.h"
+#include "archive_format.h"
+#include <fstream>
 #include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+// Разбиение файла на блоки по стоимости (как encoder --split):
+// для каждого блока - выбранная таблица и её цена в битах
+static void analyzeBlocks(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open file: " << filename << std::endl;
+        return;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+                              std::istreambuf_iterator<char>());
+    if (data.empty()) return;
+
+    BlockSplitter splitter;
+    std::vector<uint8_t> encoded(BlockSplitter::bound(data.size()));
+    size_t encodedSize = splitter.encode(data.data(), data.size(), encoded.data(), encoded.size());
+
+    std::cout << "Blocks chosen by cost (segment " << BlockSplitter::SEGMENT_SIZE << " bytes):" << std::endl;
+    std::cout << std::setw(8) << "Block" << std::setw(12) << "Offset" << std::setw(12) << "Size"
+              << std::setw(20) << "Table" << std::setw(14) << "Table bits" << std::setw(14) << "Data bits"
+              << std::setw(12) << "Bits/byte" << std::endl;
+    size_t index = 0;
+    for (const BlockChoice& block : splitter.lastBlocks()) {
+        std::string table = block.kind == BlockChoice::STORED ? "stored"
+                          : block.kind == BlockChoice::REUSE_TABLE ? "reuse/" + ArchiveWriter::tableBitsName(block.tableBits)
+                                                                   : "new/" + ArchiveWriter::tableBitsName(block.tableBits);
+        double bitsPerByte = (block.tableBytes * 8.0 + block.payloadBits) / block.size;
+        std::cout << std::setw(8) << index++ << std::setw(12) << block.offset << std::setw(12) << block.size
+                  << std::setw(20) << table << std::setw(14) << block.tableBytes * 8
+                  << std::setw(14) << block.payloadBits << std::setw(12) << std::fixed << std::setprecision(3)
+                  << bitsPerByte << std::defaultfloat << std::endl;
+    }
+    std::cout << "Total: " << encodedSize << " bytes with block headers (" << (encodedSize * 100.0) / data.size()
+              << "%), " << splitter.newTables() << " new tables, " << splitter.reusedTables() << " reused, "
+              << splitter.storedBlocks() << " stored" << std::endl << std::endl;
+}
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <file1> [file2] ..." << std::endl;
+    bool blocks = argc > 1 && std::string(argv[1]) == "--blocks";
+    int first = blocks ? 2 : 1;
+    if (argc <= first) {
+        std::cerr << "Usage: " << argv[0] << " [--blocks] <file1> [file2] ..." << std::endl;
+        std::cerr << "  --blocks also shows cost-driven block splitting and per-block table choices" << std::endl;
         return 1;
     }
     
-    for (int i = 1; i < argc; i++) {
+    for (int i = first; i < argc; i++) {
         FrequencyAnalyzer::analyzeFile(argv[i]);
+        if (blocks) {
+            analyzeBlocks(argv[i]);
+        }
     }
     
     return 0;
-}
\ No newline at end of file
+}
@@ -1,17 +1,285 @@
 #include "archive_format.h"
+#include "bitstream.h"
 #include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    int valueWidth(uint64_t value) {
+        return value == 0 ? 0 : 64 - __builtin_clzll(value);
+    }
+
+    size_t varintSize(uint64_t value) {
+        size_t size = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            size++;
+        }
+        return size;
+    }
+
+    size_t packedSize(size_t values, int width) {
+        return (static_cast<uint64_t>(values) * width + 7) / 8;
+    }
+
+    // Значения старого формата записываются без маски: не помещается - ошибка
+    void checkLegacyWidth(const uint64_t* freqs, size_t count, int bits) {
+        if (bits >= 64) return;
+        for (size_t i = 0; i < count; i++) {
+            if (freqs[i] >> bits) {
+                throw std::invalid_argument("Frequency does not fit in " + std::to_string(bits) + " bits");
+            }
+        }
+    }
+
+    // Как ArchiveWriter::readVarint, но обрыв данных - не ошибка, а false
+    bool peekVarint(const uint8_t* src, size_t size, size_t& offset, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (offset >= size) return false;
+            uint8_t byte = src[offset++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        throw std::runtime_error("Variable-length integer is too long");
+    }
+
+    uint64_t readPacked(BitReader& in, int width) {
+        uint64_t value = 0;
+        while (width > 0) {
+            int bits = std::min(width, 32);
+            value = (value << bits) | in.peekBits(bits);
+            in.skipBits(bits);
+            width -= bits;
+        }
+        return value;
+    }
+
+    // Всё, от чего зависят размеры форм компактной таблицы
+    struct TableStats {
+        size_t present = 0;           // ненулевых значений
+        uint64_t maxValue = 0;
+        size_t denseVarints = 0;      // байт varint всех значений
+        size_t presentVarints = 0;    // байт varint ненулевых значений минус 1
+        size_t sparseIndex = 0;       // байт varint числа и промежутков номеров
+    };
+
+    TableStats collectStats(const uint64_t* freqs, size_t count) {
+        TableStats stats;
+        size_t next = 0;
+        for (size_t i = 0; i < count; i++) {
+            stats.denseVarints += varintSize(freqs[i]);
+            if (freqs[i] == 0) continue;
+            stats.present++;
+            stats.maxValue = std::max(stats.maxValue, freqs[i]);
+            stats.presentVarints += varintSize(freqs[i] - 1);
+            stats.sparseIndex += varintSize(i - next);
+            next = i + 1;
+        }
+        stats.sparseIndex += varintSize(stats.present);
+        return stats;
+    }
+
+    // Размер формы при данной ширине значений; SIZE_MAX - значения не помещаются
+    size_t formSize(const TableStats& stats, size_t count, int form, int width) {
+        bool varint = width == ArchiveWriter::VARINT_VALUES;
+        if (form == ArchiveWriter::FORM_DENSE) {
+            if (varint) return 1 + stats.denseVarints;
+            if (valueWidth(stats.maxValue) > width) return SIZE_MAX;
+            return 1 + packedSize(count, width);
+        }
+        size_t values;
+        if (varint) {
+            values = stats.presentVarints;
+        } else if (stats.present > 0 && valueWidth(stats.maxValue - 1) > width) {
+            return SIZE_MAX;
+        } else {
+            values = packedSize(stats.present, width);
+        }
+        size_t index = form == ArchiveWriter::FORM_BITMAP ? (count + 7) / 8 : stats.sparseIndex;
+        return 1 + index + values;
+    }
+
+    int bestForm(const TableStats& stats, size_t count, int width, size_t& size) {
+        int best = ArchiveWriter::FORM_DENSE;
+        size = formSize(stats, count, best, width);
+        for (int form : {ArchiveWriter::FORM_BITMAP, ArchiveWriter::FORM_SPARSE}) {
+            size_t candidate = formSize(stats, count, form, width);
+            if (candidate < size) {
+                size = candidate;
+                best = form;
+            }
+        }
+        return best;
+    }
+
+    int compactWidth(int bits) {
+        int width = bits & ~ArchiveWriter::COMPACT_TABLE;
+        if (width > ArchiveWriter::VARINT_VALUES) {
+            throw std::runtime_error("Corrupted frequency table: invalid value width");
+        }
+        return width;
+    }
+
+    size_t writeCompact(uint8_t* dst, const uint64_t* freqs, int bits, size_t count) {
+        int width = bits & ~ArchiveWriter::COMPACT_TABLE;
+        if (width > ArchiveWriter::VARINT_VALUES) {
+            throw std::invalid_argument("Unsupported bit size");
+        }
+        TableStats stats = collectStats(freqs, count);
+        size_t size;
+        int form = bestForm(stats, count, width, size);
+        if (size == SIZE_MAX) {
+            throw std::invalid_argument("Frequency does not fit in " + std::to_string(width) + " bits");
+        }
+
+        dst[0] = static_cast<uint8_t>(form);
+        size_t offset = 1;
+        if (form == ArchiveWriter::FORM_BITMAP) {
+            std::memset(dst + offset, 0, (count + 7) / 8);
+            for (size_t i = 0; i < count; i++) {
+                if (freqs[i] > 0) dst[offset + i / 8] |= static_cast<uint8_t>(0x80 >> (i % 8));
+            }
+            offset += (count + 7) / 8;
+        } else if (form == ArchiveWriter::FORM_SPARSE) {
+            ArchiveWriter::writeVarint(dst, size, offset, stats.present);
+            size_t next = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (freqs[i] == 0) continue;
+                ArchiveWriter::writeVarint(dst, size, offset, i - next);
+                next = i + 1;
+            }
+        }
+
+        uint64_t bias = form == ArchiveWriter::FORM_DENSE ? 0 : 1;
+        if (width == ArchiveWriter::VARINT_VALUES) {
+            for (size_t i = 0; i < count; i++) {
+                if (bias == 0 || freqs[i] > 0) ArchiveWriter::writeVarint(dst, size, offset, freqs[i] - bias);
+            }
+            return offset;
+        }
+        BitWriter out(dst + offset, size - offset);
+        for (size_t i = 0; i < count; i++) {
+            if (bias == 0 || freqs[i] > 0) out.writeBits(freqs[i] - bias, width);
+        }
+        out.flush();
+        return offset + out.bytesWritten();
+    }
+
+    // Разбор компактной таблицы. Без freqs только проверяет структуру и считает
+    // размер; false - данных меньше, чем нужно
+    bool parseCompact(const uint8_t* src, size_t avail, int width, size_t count, uint64_t* freqs, size_t& size) {
+        if (avail < 1) return false;
+        int form = src[0];
+        size_t offset = 1;
+        size_t present = count;
+        size_t indexOffset = offset;
+        if (form == ArchiveWriter::FORM_BITMAP) {
+            size_t maskBytes = (count + 7) / 8;
+            if (avail - offset < maskBytes) return false;
+            present = 0;
+            for (size_t i = 0; i < maskBytes; i++) {
+                present += __builtin_popcount(src[offset + i]);
+            }
+            if (count % 8 != 0 && (src[offset + maskBytes - 1] & (0xFF >> (count % 8))) != 0) {
+                throw std::runtime_error("Corrupted frequency table: symbol out of range");
+            }
+            offset += maskBytes;
+        } else if (form == ArchiveWriter::FORM_SPARSE) {
+            uint64_t number;
+            if (!peekVarint(src, avail, offset, number)) return false;
+            if (number > count) {
+                throw std::runtime_error("Corrupted frequency table: too many symbols");
+            }
+            present = static_cast<size_t>(number);
+            indexOffset = offset;
+            size_t next = 0;
+            for (size_t i = 0; i < present; i++) {
+                uint64_t gap;
+                if (!peekVarint(src, avail, offset, gap)) return false;
+                if (gap >= count - next) {
+                    throw std::runtime_error("Corrupted frequency table: symbol out of range");
+                }
+                next += static_cast<size_t>(gap) + 1;
+            }
+        } else if (form != ArchiveWriter::FORM_DENSE) {
+            throw std::runtime_error("Corrupted frequency table: unknown form " + std::to_string(form));
+        }
+
+        size_t valuesOffset = offset;
+        bool varint = width == ArchiveWriter::VARINT_VALUES;
+        if (varint) {
+            for (size_t i = 0; i < present; i++) {
+                uint64_t value;
+                if (!peekVarint(src, avail, offset, value)) return false;
+            }
+        } else {
+            size_t bytes = packedSize(present, width);
+            if (avail - offset < bytes) return false;
+            offset += bytes;
+        }
+        size = offset;
+        if (freqs == nullptr) return true;
+
+        // Значения присутствующих символов хранятся уменьшенными на 1
+        uint64_t bias = form == ArchiveWriter::FORM_DENSE ? 0 : 1;
+        BitReader packed(src + valuesOffset, offset - valuesOffset);
+        size_t valuePos = valuesOffset;
+        auto nextValue = [&]() {
+            uint64_t value;
+            if (varint) {
+                peekVarint(src, offset, valuePos, value);
+            } else {
+                value = readPacked(packed, width);
+            }
+            if (value + bias < value) {
+                throw std::runtime_error("Corrupted frequency table: value overflow");
+            }
+            return value + bias;
+        };
+
+        if (form == ArchiveWriter::FORM_DENSE) {
+            for (size_t i = 0; i < count; i++) {
+                freqs[i] = nextValue();
+            }
+        } else if (form == ArchiveWriter::FORM_BITMAP) {
+            for (size_t i = 0; i < count; i++) {
+                bool set = (src[indexOffset + i / 8] >> (7 - i % 8)) & 1;
+                freqs[i] = set ? nextValue() : 0;
+            }
+        } else {
+            std::fill(freqs, freqs + count, 0);
+            size_t cursor = indexOffset;
+            size_t next = 0;
+            for (size_t i = 0; i < present; i++) {
+                uint64_t gap;
+                peekVarint(src, avail, cursor, gap);
+                next += static_cast<size_t>(gap);
+                freqs[next++] = nextValue();
+            }
+        }
+        return true;
+    }
+}
 
 void ArchiveWriter::writeHeader(std::ostream& out, const ArchiveHeader& header) {
     out.write(reinterpret_cast<const char*>(&header.signature), sizeof(header.signature));
     out.write(reinterpret_cast<const char*>(&header.version), sizeof(header.version));
     out.write(reinterpret_cast<const char*>(&header.algorithm), sizeof(header.algorithm));
     out.write(reinterpret_cast<const char*>(&header.frequencyBits), sizeof(header.frequencyBits));
-    out.write(reinterpret_cast<const char*>(&header.reserved), sizeof(header.reserved));
+    out.write(reinterpret_cast<const char*>(&header.filter), sizeof(header.filter));
     out.write(reinterpret_cast<const char*>(&header.originalSize), sizeof(header.originalSize));
     out.write(reinterpret_cast<const char*>(&header.compressedSize), sizeof(header.compressedSize));
 }
 
 void ArchiveWriter::writeFrequencies(std::ostream& out, const std::vector<uint64_t>& freqs, int bits) {
+    if (compactTable(bits)) {
+        std::vector<uint8_t> table(tableSize(freqs.data(), bits, freqs.size()));
+        writeFrequencies(table.data(), freqs.data(), bits, freqs.size());
+        out.write(reinterpret_cast<const char*>(table.data()), table.size());
+        return;
+    }
+    checkLegacyWidth(freqs.data(), freqs.size(), bits);
     if (bits == 64) {
         for (uint64_t freq : freqs) {
             out.write(reinterpret_cast<const char*>(&freq), sizeof(freq));
@@ -21,6 +289,11 @@ void ArchiveWriter::writeFrequencies(std::ostream& out, const std::vector<uint64
             uint32_t freq32 = static_cast<uint32_t>(freq);
             out.write(reinterpret_cast<const char*>(&freq32), sizeof(freq32));
         }
+    } else if (bits == 16) {
+        for (uint64_t freq : freqs) {
+            uint16_t freq16 = static_cast<uint16_t>(freq);
+            out.write(reinterpret_cast<const char*>(&freq16), sizeof(freq16));
+        }
     } else if (bits == 8) {
         for (uint64_t freq : freqs) {
             uint8_t freq8 = static_cast<uint8_t>(freq);
@@ -28,9 +301,9 @@ void ArchiveWriter::writeFrequencies(std::ostream& out, const std::vector<uint64
         }
     } else if (bits == 4) {
         for (size_t i = 0; i < freqs.size(); i += 2) {
-            uint8_t byte = (freqs[i] & 0x0F) << 4;
+            uint8_t byte = static_cast<uint8_t>(freqs[i] << 4);
             if (i + 1 < freqs.size()) {
-                byte |= (freqs[i + 1] & 0x0F);
+                byte |= static_cast<uint8_t>(freqs[i + 1]);
             }
             out.put(static_cast<char>(byte));
         }
@@ -45,7 +318,7 @@ ArchiveHeader ArchiveWriter::readHeader(std::istream& in) {
     in.read(reinterpret_cast<char*>(&header.version), sizeof(header.version));
     in.read(reinterpret_cast<char*>(&header.algorithm), sizeof(header.algorithm));
     in.read(reinterpret_cast<char*>(&header.frequencyBits), sizeof(header.frequencyBits));
-    in.read(reinterpret_cast<char*>(&header.reserved), sizeof(header.reserved));
+    in.read(reinterpret_cast<char*>(&header.filter), sizeof(header.filter));
     in.read(reinterpret_cast<char*>(&header.originalSize), sizeof(header.originalSize));
     in.read(reinterpret_cast<char*>(&header.compressedSize), sizeof(header.compressedSize));
     return header;
@@ -54,7 +327,19 @@ ArchiveHeader ArchiveWriter::readHeader(std::istream& in) {
 std::vector<uint64_t> ArchiveWriter::readFrequencies(std::istream& in, int bits) {
     std::vector<uint64_t> freqs(Common::ALPHABET_SIZE, 0);
     
-    if (bits == 64) {
+    if (compactTable(bits)) {
+        // Размер компактной таблицы виден только по её содержимому
+        std::vector<uint8_t> table;
+        size_t size = 0;
+        while (!tryReadTableSize(table.data(), table.size(), bits, size)) {
+            int byte = in.get();
+            if (byte == std::char_traits<char>::eof()) {
+                throw std::runtime_error("Frequency table is truncated");
+            }
+            table.push_back(static_cast<uint8_t>(byte));
+        }
+        readFrequencies(table.data(), table.size(), bits, freqs.data());
+    } else if (bits == 64) {
         for (size_t i = 0; i < freqs.size(); i++) {
             in.read(reinterpret_cast<char*>(&freqs[i]), sizeof(uint64_t));
         }
@@ -64,6 +349,12 @@ std::vector<uint64_t> ArchiveWriter::readFrequencies(std::istream& in, int bits)
             in.read(reinterpret_cast<char*>(&freq32), sizeof(uint32_t));
             freqs[i] = freq32;
         }
+    } else if (bits == 16) {
+        for (size_t i = 0; i < freqs.size(); i++) {
+            uint16_t freq16;
+            in.read(reinterpret_cast<char*>(&freq16), sizeof(uint16_t));
+            freqs[i] = freq16;
+        }
     } else if (bits == 8) {
         for (size_t i = 0; i < freqs.size(); i++) {
             uint8_t freq8 = in.get();
@@ -82,4 +373,285 @@ std::vector<uint64_t> ArchiveWriter::readFrequencies(std::istream& in, int bits)
     }
     
     return freqs;
-}
\ No newline at end of file
+}
+
+void ArchiveWriter::writeBlockHeader(std::ostream& out, const BlockHeader& header) {
+    out.write(reinterpret_cast<const char*>(&header.type), sizeof(header.type));
+    out.write(reinterpret_cast<const char*>(&header.frequencyBits), sizeof(header.frequencyBits));
+    out.write(reinterpret_cast<const char*>(&header.originalSize), sizeof(header.originalSize));
+    out.write(reinterpret_cast<const char*>(&header.compressedSize), sizeof(header.compressedSize));
+}
+
+BlockHeader ArchiveWriter::readBlockHeader(std::istream& in) {
+    BlockHeader header;
+    in.read(reinterpret_cast<char*>(&header.type), sizeof(header.type));
+    in.read(reinterpret_cast<char*>(&header.frequencyBits), sizeof(header.frequencyBits));
+    in.read(reinterpret_cast<char*>(&header.originalSize), sizeof(header.originalSize));
+    in.read(reinterpret_cast<char*>(&header.compressedSize), sizeof(header.compressedSize));
+    return header;
+}
+
+size_t ArchiveWriter::frequencyTableSize(int bits, size_t count) {
+    switch (bits) {
+        case 64: return count * 8;
+        case 32: return count * 4;
+        case 16: return count * 2;
+        case 8:  return count;
+        case 4:  return (count + 1) / 2;
+        case 0:  return 0; // таблица не хранится (адаптивные модели)
+        default: throw std::invalid_argument("Unsupported bit size");
+    }
+}
+
+void ArchiveWriter::writeHeader(uint8_t* dst, const ArchiveHeader& header) {
+    std::memcpy(dst + 0, &header.signature, sizeof(header.signature));
+    dst[4] = header.version;
+    dst[5] = header.algorithm;
+    dst[6] = header.frequencyBits;
+    dst[7] = header.filter;
+    std::memcpy(dst + 8, &header.originalSize, sizeof(header.originalSize));
+    std::memcpy(dst + 16, &header.compressedSize, sizeof(header.compressedSize));
+}
+
+ArchiveHeader ArchiveWriter::readHeader(const uint8_t* src) {
+    ArchiveHeader header;
+    std::memcpy(&header.signature, src + 0, sizeof(header.signature));
+    header.version = src[4];
+    header.algorithm = src[5];
+    header.frequencyBits = src[6];
+    header.filter = src[7];
+    std::memcpy(&header.originalSize, src + 8, sizeof(header.originalSize));
+    std::memcpy(&header.compressedSize, src + 16, sizeof(header.compressedSize));
+    return header;
+}
+
+size_t ArchiveWriter::writeFrequencies(uint8_t* dst, const uint64_t* freqs, int bits, size_t count) {
+    if (compactTable(bits)) {
+        return writeCompact(dst, freqs, bits, count);
+    }
+    checkLegacyWidth(freqs, count, bits);
+    if (bits == 0) {
+        return 0;
+    } else if (bits == 64) {
+        std::memcpy(dst, freqs, count * sizeof(uint64_t));
+    } else if (bits == 32) {
+        for (size_t i = 0; i < count; i++) {
+            uint32_t freq32 = static_cast<uint32_t>(freqs[i]);
+            std::memcpy(dst + i * sizeof(freq32), &freq32, sizeof(freq32));
+        }
+    } else if (bits == 16) {
+        for (size_t i = 0; i < count; i++) {
+            uint16_t freq16 = static_cast<uint16_t>(freqs[i]);
+            std::memcpy(dst + i * sizeof(freq16), &freq16, sizeof(freq16));
+        }
+    } else if (bits == 8) {
+        for (size_t i = 0; i < count; i++) {
+            dst[i] = static_cast<uint8_t>(freqs[i]);
+        }
+    } else if (bits == 4) {
+        for (size_t i = 0; i < count; i += 2) {
+            uint8_t byte = static_cast<uint8_t>(freqs[i] << 4);
+            if (i + 1 < count) {
+                byte |= static_cast<uint8_t>(freqs[i + 1]);
+            }
+            dst[i / 2] = byte;
+        }
+    } else {
+        throw std::invalid_argument("Unsupported bit size");
+    }
+    return frequencyTableSize(bits, count);
+}
+
+size_t ArchiveWriter::readFrequencies(const uint8_t* src, size_t avail, int bits, uint64_t* freqs, size_t count) {
+    if (bits == PRETRAINED_TABLE) {
+        // Частоты лежат вне архива - их подставляет TableLibrary
+        throw std::runtime_error("Archive refers to a pretrained table");
+    }
+    if (compactTable(bits)) {
+        size_t size = 0;
+        if (!parseCompact(src, avail, compactWidth(bits), count, freqs, size)) {
+            throw std::runtime_error("Frequency table is truncated");
+        }
+        return size;
+    }
+    size_t size = frequencyTableSize(bits, count);
+    if (avail < size) {
+        throw std::runtime_error("Frequency table is truncated");
+    }
+    if (bits == 0) {
+        std::fill(freqs, freqs + count, 0);
+    } else if (bits == 64) {
+        std::memcpy(freqs, src, count * sizeof(uint64_t));
+    } else if (bits == 32) {
+        for (size_t i = 0; i < count; i++) {
+            uint32_t freq32;
+            std::memcpy(&freq32, src + i * sizeof(freq32), sizeof(freq32));
+            freqs[i] = freq32;
+        }
+    } else if (bits == 16) {
+        for (size_t i = 0; i < count; i++) {
+            uint16_t freq16;
+            std::memcpy(&freq16, src + i * sizeof(freq16), sizeof(freq16));
+            freqs[i] = freq16;
+        }
+    } else if (bits == 8) {
+        for (size_t i = 0; i < count; i++) {
+            freqs[i] = src[i];
+        }
+    } else if (bits == 4) {
+        for (size_t i = 0; i < count; i += 2) {
+            uint8_t byte = src[i / 2];
+            freqs[i] = (byte >> 4) & 0x0F;
+            if (i + 1 < count) {
+                freqs[i + 1] = byte & 0x0F;
+            }
+        }
+    } else {
+        throw std::invalid_argument("Unsupported bit size");
+    }
+    return size;
+}
+
+std::string ArchiveWriter::tableBitsName(int bits) {
+    if (bits == PRETRAINED_TABLE) return "pretrained";
+    if (!compactTable(bits)) return std::to_string(bits);
+    int width = bits & ~COMPACT_TABLE;
+    return width == VARINT_VALUES ? "compact/varint" : "compact/" + std::to_string(width);
+}
+
+const char* ArchiveWriter::algorithmName(uint8_t algorithm) {
+    switch (algorithm) {
+        case Common::ALGO_HUFFMAN: return "Huffman";
+        case Common::ALGO_SHANNON_FANO: return "Shannon-Fano";
+        case Common::ALGO_TANS: return "tANS";
+        case Common::ALGO_RANGE: return "Range";
+        case Common::ALGO_ADAPTIVE_HUFFMAN: return "Adaptive";
+        case Common::ALGO_LZ77: return "LZ77";
+        case Common::ALGO_BWT: return "BWT";
+        case Common::ALGO_STORED: return "Stored";
+        case Common::ALGO_UTF8: return "UTF-8";
+        case Common::ALGO_WORD: return "Word";
+        case Common::ALGO_ALPHABETIC: return "Alphabetic";
+        default: return "?";
+    }
+}
+
+bool ArchiveWriter::parseAlgorithm(const std::string& name, Common::Algorithm& algorithm) {
+    struct Entry {
+        const char* name;
+        Common::Algorithm algorithm;
+    };
+    const Entry entries[] = {
+        {"huffman", Common::ALGO_HUFFMAN}, {"sf", Common::ALGO_SHANNON_FANO}, {"tans", Common::ALGO_TANS},
+        {"range", Common::ALGO_RANGE}, {"adaptive", Common::ALGO_ADAPTIVE_HUFFMAN}, {"lz77", Common::ALGO_LZ77},
+        {"bwt", Common::ALGO_BWT}, {"utf8", Common::ALGO_UTF8}, {"word", Common::ALGO_WORD},
+        {"alphabetic", Common::ALGO_ALPHABETIC},
+    };
+    for (const Entry& entry : entries) {
+        if (name == entry.name) {
+            algorithm = entry.algorithm;
+            return true;
+        }
+    }
+    return false;
+}
+
+int ArchiveWriter::compactTableBits(const uint64_t* freqs, size_t count) {
+    // Ширина по наибольшему значению подходит всем формам, по наибольшему
+    // минус 1 - только BITMAP и SPARSE; varint выгоден при редких больших значениях
+    TableStats stats = collectStats(freqs, count);
+    int candidates[] = {valueWidth(stats.maxValue), stats.present > 0 ? valueWidth(stats.maxValue - 1) : 0,
+                        VARINT_VALUES};
+    int bestWidth = candidates[0];
+    size_t bestSize = SIZE_MAX;
+    for (int width : candidates) {
+        size_t size;
+        bestForm(stats, count, width, size);
+        if (size < bestSize) {
+            bestSize = size;
+            bestWidth = width;
+        }
+    }
+    return COMPACT_TABLE | bestWidth;
+}
+
+size_t ArchiveWriter::tableSize(const uint64_t* freqs, int bits, size_t count) {
+    if (!compactTable(bits)) {
+        return frequencyTableSize(bits, count);
+    }
+    int width = bits & ~COMPACT_TABLE;
+    if (width > VARINT_VALUES) {
+        throw std::invalid_argument("Unsupported bit size");
+    }
+    size_t size;
+    bestForm(collectStats(freqs, count), count, width, size);
+    if (size == SIZE_MAX) {
+        throw std::invalid_argument("Frequency does not fit in " + std::to_string(width) + " bits");
+    }
+    return size;
+}
+
+size_t ArchiveWriter::tableBound(size_t count) {
+    // Самая широкая форма DENSE с 64-битными значениями всегда допустима
+    return 1 + frequencyTableSize(64, count);
+}
+
+bool ArchiveWriter::tryReadTableSize(const uint8_t* src, size_t avail, int bits, size_t& size, size_t count) {
+    if (bits == PRETRAINED_TABLE) {
+        size = TABLE_ID_SIZE;
+        return avail >= size;
+    }
+    if (compactTable(bits)) {
+        return parseCompact(src, avail, compactWidth(bits), count, nullptr, size);
+    }
+    size = frequencyTableSize(bits, count);
+    return avail >= size;
+}
+
+size_t ArchiveWriter::readTableSize(const uint8_t* src, size_t avail, int bits, size_t count) {
+    size_t size = 0;
+    if (!tryReadTableSize(src, avail, bits, size, count)) {
+        throw std::runtime_error("Frequency table is truncated");
+    }
+    return size;
+}
+
+void ArchiveWriter::writeBlockHeader(uint8_t* dst, const BlockHeader& header) {
+    dst[0] = header.type;
+    dst[1] = header.frequencyBits;
+    std::memcpy(dst + 2, &header.originalSize, sizeof(header.originalSize));
+    std::memcpy(dst + 6, &header.compressedSize, sizeof(header.compressedSize));
+}
+
+BlockHeader ArchiveWriter::readBlockHeader(const uint8_t* src) {
+    BlockHeader header;
+    header.type = src[0];
+    header.frequencyBits = src[1];
+    std::memcpy(&header.originalSize, src + 2, sizeof(header.originalSize));
+    std::memcpy(&header.compressedSize, src + 6, sizeof(header.compressedSize));
+    return header;
+}
+
+void ArchiveWriter::writeVarint(uint8_t* dst, size_t capacity, size_t& offset, uint64_t value) {
+    do {
+        if (offset >= capacity) {
+            throw std::length_error("Destination buffer too small");
+        }
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        dst[offset++] = static_cast<uint8_t>(byte | (value != 0 ? 0x80 : 0));
+    } while (value != 0);
+}
+
+uint64_t ArchiveWriter::readVarint(const uint8_t* src, size_t size, size_t& offset) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (offset >= size) {
+            throw std::runtime_error("Variable-length integer is truncated");
+        }
+        uint8_t byte = src[offset++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return value;
+    }
+    throw std::runtime_error("Variable-length integer is too long");
+}
@@ -2,6 +2,7 @@
 #pragma once
 #include "common.h"
 #include <vector>
+#include <string>
 #include <iostream>
 
 struct ArchiveHeader {
@@ -9,17 +10,99 @@ struct ArchiveHeader {
     uint8_t version;
     uint8_t algorithm;
     uint8_t frequencyBits;
-    uint8_t reserved;
+    uint8_t filter;             // предварительный фильтр (DataFilter), 0 - нет
     uint64_t originalSize;
     uint64_t compressedSize;
     
     static const size_t SIZE = 24;
 };
 
+// Заголовок блока потокового формата (VERSION_4).
+// Каждый блок самодостаточен: своя таблица частот и данные,
+// выровненные на границу байта.
+struct BlockHeader {
+    uint8_t type;
+    uint8_t frequencyBits;
+    uint32_t originalSize;
+    uint32_t compressedSize;
+    
+    static const size_t SIZE = 10;
+};
+
+// Таблицы частот. Старые форматы (frequencyBits = 4, 8, 16, 32, 64) - все
+// значения подряд фиксированной ширины - по-прежнему читаются. Компактная
+// таблица помечается frequencyBits = COMPACT_TABLE | ширина значений в битах
+// (0..64) или COMPACT_TABLE | VARINT_VALUES. Первый байт компактной таблицы -
+// форма (TableForm), дальше:
+//   DENSE  - все count значений;
+//   BITMAP - битовая маска присутствующих символов ((count + 7) / 8 байт,
+//            старший бит первым), затем значения присутствующих минус 1;
+//   SPARSE - varint числа присутствующих и varint промежутков между их
+//            номерами, затем значения присутствующих минус 1.
+// Значения упакованы битами подряд (старший бит первым) и дополнены до
+// байта либо записаны как varint. Форму и ширину выбирает writeFrequencies
+// по самим значениям - так, чтобы таблица была как можно короче.
+// frequencyBits = PRETRAINED_TABLE - таблица не хранится, вместо неё
+// TABLE_ID_SIZE байт номера обученной таблицы (PretrainedTable::id).
 class ArchiveWriter {
 public:
+    static const uint8_t COMPACT_TABLE = 0x80;
+    static const uint8_t VARINT_VALUES = 65;
+    static const uint8_t PRETRAINED_TABLE = 0xFF;
+    static const size_t TABLE_ID_SIZE = 4;
+    enum TableForm : uint8_t { FORM_DENSE = 0, FORM_BITMAP = 1, FORM_SPARSE = 2 };
+
+    static bool compactTable(int bits) { return (bits & COMPACT_TABLE) != 0; }
+    // Разрядность для отчётов: "8", "compact/6", "compact/varint", "pretrained"
+    static std::string tableBitsName(int bits);
+    // Название алгоритма для отчётов ("Huffman", "tANS", ...; "?" - неизвестный)
+    static const char* algorithmName(uint8_t algorithm);
+    // Алгоритм по ключу утилит: huffman, sf, tans, range, adaptive, lz77,
+    // bwt, utf8, word, alphabetic; false - такого нет
+    static bool parseAlgorithm(const std::string& name, Common::Algorithm& algorithm);
+
     static void writeHeader(std::ostream& out, const ArchiveHeader& header);
     static void writeFrequencies(std::ostream& out, const std::vector<uint64_t>& freqs, int bits);
     static ArchiveHeader readHeader(std::istream& in);
     static std::vector<uint64_t> readFrequencies(std::istream& in, int bits);
+    
+    static void writeBlockHeader(std::ostream& out, const BlockHeader& header);
+    static BlockHeader readBlockHeader(std::istream& in);
+    
+    // Размер таблицы частот старого формата в байтах для заданной разрядности
+    // (count - размер алфавита, больше 256 у LZ77)
+    static size_t frequencyTableSize(int bits, size_t count = Common::ALPHABET_SIZE);
+    
+    // Разрядность (COMPACT_TABLE | ...) самой короткой компактной таблицы для freqs
+    static int compactTableBits(const uint64_t* freqs, size_t count = Common::ALPHABET_SIZE);
+    // Сколько байт займёт таблица freqs, записанная с разрядностью bits;
+    // std::invalid_argument, если значения в неё не помещаются
+    static size_t tableSize(const uint64_t* freqs, int bits, size_t count = Common::ALPHABET_SIZE);
+    // Верхняя граница размера любой таблицы из count значений
+    static size_t tableBound(size_t count = Common::ALPHABET_SIZE);
+    // Размер записанной таблицы по её началу (avail байт). tryReadTableSize
+    // возвращает false, если avail байт не хватает, чтобы узнать размер или
+    // вместить таблицу; readTableSize в этом случае бросает std::runtime_error.
+    // Испорченная таблица - std::runtime_error в обоих случаях
+    static bool tryReadTableSize(const uint8_t* src, size_t avail, int bits, size_t& size,
+                                 size_t count = Common::ALPHABET_SIZE);
+    static size_t readTableSize(const uint8_t* src, size_t avail, int bits, size_t count = Common::ALPHABET_SIZE);
+    
+    // Те же форматы для буферов в памяти (библиотечный интерфейс, без iostream)
+    static void writeHeader(uint8_t* dst, const ArchiveHeader& header);
+    static ArchiveHeader readHeader(const uint8_t* src);
+    // Записывает tableSize(freqs, bits, count) байт и возвращает это число
+    static size_t writeFrequencies(uint8_t* dst, const uint64_t* freqs, int bits,
+                                   size_t count = Common::ALPHABET_SIZE);
+    // Читает таблицу из avail байт и возвращает её размер
+    static size_t readFrequencies(const uint8_t* src, size_t avail, int bits, uint64_t* freqs,
+                                  size_t count = Common::ALPHABET_SIZE);
+    static void writeBlockHeader(uint8_t* dst, const BlockHeader& header);
+    static BlockHeader readBlockHeader(const uint8_t* src);
+    
+    // Целые переменной длины: по 7 бит в байте, младшие первыми, старший
+    // бит байта - признак продолжения. offset сдвигается за число.
+    // При нехватке места - std::length_error, при обрыве данных - std::runtime_error
+    static void writeVarint(uint8_t* dst, size_t capacity, size_t& offset, uint64_t value);
+    static uint64_t readVarint(const uint8_t* src, size_t size, size_t& offset);
 };
\ No newline at end of file
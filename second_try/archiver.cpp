@@ -0,0 +1,140 @@
+#include "common.h"
+#include "container.h"
+#include "archive_format.h"
+#include "mapped_output.h"
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " create [--solid] [--algorithm NAME] <archive> <files...>" << std::endl;
+    std::cerr << "       " << program << " list <archive>" << std::endl;
+    std::cerr << "       " << program << " extract <archive> <name> <output file|->" << std::endl;
+    std::cerr << "  --algorithm NAME: huffman (default), sf, tans, range, adaptive, lz77, bwt, utf8, word, alphabetic" << std::endl;
+    std::cerr << "  --solid groups files under " << ContainerWriter::SOLID_FILE_SIZE / 1024
+              << " KB into blocks of up to " << ContainerWriter::SOLID_GROUP_SIZE / 1024
+              << " KB sharing one Huffman table" << std::endl;
+}
+
+static int create(int argc, char* argv[]) {
+    bool solid = false;
+    Common::Algorithm algorithm = Common::ALGO_HUFFMAN;
+    int arg = 2;
+    while (arg < argc && std::string(argv[arg]).rfind("--", 0) == 0) {
+        std::string option = argv[arg];
+        if (option == "--solid") {
+            solid = true;
+            arg++;
+        } else if (option == "--algorithm" && arg + 1 < argc &&
+                   ArchiveWriter::parseAlgorithm(argv[arg + 1], algorithm)) {
+            arg += 2;
+        } else {
+            std::cerr << "Unknown option: " << option << std::endl;
+            return 1;
+        }
+    }
+    if (argc - arg < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::ofstream output(argv[arg], std::ios::binary);
+    if (!output) {
+        std::cerr << "Cannot create output file: " << argv[arg] << std::endl;
+        return 1;
+    }
+    try {
+        ContainerWriter writer(output, algorithm);
+        writer.setSolid(solid);
+        uint64_t totalSize = 0;
+        for (int i = arg + 1; i < argc; i++) {
+            // Имя в каталоге - путь в том виде, в каком он передан
+            MappedInput input(argv[i]);
+            writer.add(argv[i], input.data(), input.size());
+            totalSize += input.size();
+        }
+        writer.finish();
+
+        std::cout << "Container created: " << writer.entries().size() << " files, " << totalSize << " -> "
+                  << writer.bytesWritten() << " bytes";
+        if (solid) {
+            std::cout << ", " << writer.sharedTables() << " shared tables";
+        }
+        std::cout << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Compression error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+static int list(const char* archive) {
+    std::ifstream input(archive, std::ios::binary);
+    if (!input) {
+        std::cerr << "Cannot open input archive: " << archive << std::endl;
+        return 1;
+    }
+    try {
+        ContainerReader reader(input);
+        std::cout << std::setw(12) << "Size" << std::setw(12) << "Packed" << std::setw(14) << "Algorithm"
+                  << std::setw(10) << "CRC-32" << "  Name" << std::endl;
+        for (const ContainerEntry& entry : reader.entries()) {
+            uint64_t packed = entry.payloadSize + (entry.sharedTable() ? 0 : entry.tableSize);
+            std::string algorithm = ArchiveWriter::algorithmName(entry.algorithm);
+            if (entry.sharedTable()) algorithm += "*";
+            std::cout << std::setw(12) << entry.originalSize << std::setw(12) << packed << std::setw(14)
+                      << algorithm << "  " << std::hex << std::setw(8) << std::setfill('0') << entry.checksum
+                      << std::dec << std::setfill(' ') << "  " << entry.name << std::endl;
+        }
+        std::cout << reader.entries().size() << " files; * - shared table, not counted in Packed" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Container error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+static int extract(const char* archive, const std::string& name, const std::string& outputFile) {
+    std::ifstream input(archive, std::ios::binary);
+    if (!input) {
+        std::cerr << "Cannot open input archive: " << archive << std::endl;
+        return 1;
+    }
+    try {
+        ContainerReader reader(input);
+        size_t index = reader.find(name);
+        if (index == reader.entries().size()) {
+            std::cerr << "No such entry: " << name << std::endl;
+            return 1;
+        }
+        const ContainerEntry& entry = reader.entries()[index];
+        MappedOutput output(outputFile == "-" ? "/dev/stdout" : outputFile, entry.originalSize);
+        reader.extract(index, output.data());
+        output.commit();
+
+        (outputFile == "-" ? std::cerr : std::cout) << "Extracted " << name << ": " << entry.originalSize
+                                                    << " bytes written" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Decompression error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command == "create") {
+        return create(argc, argv);
+    }
+    if (command == "list" && argc == 3) {
+        return list(argv[2]);
+    }
+    if (command == "extract" && argc == 5) {
+        return extract(argv[2], argv[3], argv[4]);
+    }
+    printUsage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,742 @@
+#include "common.h"
+#include "codec.h"
+#include "record_codec.h"
+#include "ordered_key.h"
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
+// Счётчик обращений к куче: перекрываем глобальный operator new.
+// Ресурсы pmr выделяют память через вариант с выравниванием, его тоже считаем.
+static size_t allocationCount = 0;
+
+void* operator new(size_t size) {
+    allocationCount++;
+    if (size == 0) size = 1;
+    if (void* ptr = std::malloc(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    allocationCount++;
+    size_t align = static_cast<size_t>(alignment);
+    size = (size + align - 1) / align * align;
+    if (size == 0) size = align;
+    if (void* ptr = std::aligned_alloc(align, size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+struct BenchResult {
+    double seconds;
+    size_t allocations;
+    size_t archiveBytes;  // суммарный размер архивов за один проход
+};
+
+static const char* algorithmName(Common::Algorithm algorithm) {
+    switch (algorithm) {
+        case Common::ALGO_HUFFMAN: return "Huffman";
+        case Common::ALGO_SHANNON_FANO: return "Shannon-Fano";
+        case Common::ALGO_TANS: return "tANS";
+        case Common::ALGO_RANGE: return "Range";
+        case Common::ALGO_ADAPTIVE_HUFFMAN: return "Adaptive";
+        case Common::ALGO_LZ77: return "LZ77";
+        case Common::ALGO_BWT: return "BWT";
+        case Common::ALGO_UTF8: return "UTF-8";
+        case Common::ALGO_WORD: return "Word";
+        case Common::ALGO_ALPHABETIC: return "Alphabetic";
+        default: return "Unknown";
+    }
+}
+
+// Алгоритмы, которые сжимают и распаковывают контексты без выделений памяти
+static const Common::Algorithm ALGORITHMS[] = {Common::ALGO_HUFFMAN, Common::ALGO_SHANNON_FANO,
+                                               Common::ALGO_TANS, Common::ALGO_RANGE,
+                                               Common::ALGO_ADAPTIVE_HUFFMAN, Common::ALGO_LZ77,
+                                               Common::ALGO_UTF8, Common::ALGO_WORD, Common::ALGO_ALPHABETIC};
+
+// Все 256 значений байта на фоне частых символов, чтобы вход кодировался, а
+// не сохранялся как есть: у адаптивного Хаффмана END_OF_STREAM приходит
+// 257-м новым символом, и дерево должно вместить последнее деление NYT
+static void checkAllByteValues() {
+    std::vector<uint8_t> data;
+    for (int i = 0; i < 4096; i++) {
+        data.push_back("etaoin"[i % 6]);
+    }
+    for (int value = 0; value < 256; value++) {
+        data.push_back(static_cast<uint8_t>(value));
+    }
+    std::vector<uint8_t> archive(Codec::compressBound(data.size()));
+    std::vector<uint8_t> restored(data.size());
+    for (Common::Algorithm algorithm : ALGORITHMS) {
+        CompressContext compressor(algorithm);
+        DecompressContext decompressor;
+        // Фильтр (например, дельта) свёл бы 0..255 к одному значению
+        compressor.setFilter(DataFilter::NONE);
+        size_t size = compressor.compress(data.data(), data.size(), archive.data(), archive.size());
+        std::fill(restored.begin(), restored.end(), 0);
+        size_t restoredSize = decompressor.decompress(archive.data(), size, restored.data(), restored.size());
+        if (compressor.lastStored() || restoredSize != data.size() || restored != data) {
+            throw std::runtime_error(std::string(algorithmName(algorithm)) + " round trip of all byte values failed");
+        }
+    }
+    std::cout << "All byte values: round trip OK" << std::endl;
+}
+
+// Сжимает и распаковывает data сообщениями по messageSize байт, iterations раз
+static BenchResult run(CompressContext& compressor, DecompressContext& decompressor,
+                       const std::vector<uint8_t>& data, size_t messageSize, int iterations,
+                       std::vector<uint8_t>& archive, std::vector<uint8_t>& restored) {
+    size_t before = allocationCount;
+    size_t archiveBytes = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int it = 0; it < iterations; it++) {
+        for (size_t offset = 0; offset < data.size(); offset += messageSize) {
+            size_t count = std::min(messageSize, data.size() - offset);
+            size_t archiveSize = compressor.compress(data.data() + offset, count, archive.data(), archive.size());
+            if (it == 0) archiveBytes += archiveSize;
+            size_t restoredSize = decompressor.decompress(archive.data(), archiveSize, restored.data(), count);
+            if (restoredSize != count) {
+                throw std::runtime_error("Round trip size mismatch");
+            }
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    BenchResult result = {std::chrono::duration<double>(end - start).count(), allocationCount - before, archiveBytes};
+
+    // Содержимое сверяется вне замера: каждое сообщение ещё раз через те же контексты
+    for (size_t offset = 0; offset < data.size(); offset += messageSize) {
+        size_t count = std::min(messageSize, data.size() - offset);
+        size_t archiveSize = compressor.compress(data.data() + offset, count, archive.data(), archive.size());
+        std::fill(restored.begin(), restored.begin() + count, 0);
+        decompressor.decompress(archive.data(), archiveSize, restored.data(), count);
+        if (!std::equal(restored.begin(), restored.begin() + count, data.begin() + offset)) {
+            throw std::runtime_error("Round trip mismatch");
+        }
+    }
+    return result;
+}
+
+// Время сжатия и размер архива при оценке частот по выборке с шагом stride
+static void compareSampling(const std::vector<uint8_t>& data, int iterations, std::vector<uint8_t>& archive) {
+    std::cout << std::endl << "Frequency sampling (Huffman, whole file):" << std::endl;
+    std::cout << std::string(60, '-') << std::endl;
+    std::cout << std::setw(15) << "Stride"
+              << std::setw(15) << "Size (bytes)"
+              << std::setw(15) << "Ratio penalty"
+              << std::setw(15) << "Time saved" << std::endl;
+    std::cout << std::string(60, '-') << std::endl;
+
+    double exactSeconds = 0;
+    size_t exactSize = 0;
+    const size_t strides[] = {1, 4, 16, 64};
+    for (size_t stride : strides) {
+        CompressContext compressor(Common::ALGO_HUFFMAN);
+        compressor.setSampleStride(stride);
+        size_t size = compressor.compress(data.data(), data.size(), archive.data(), archive.size());
+
+        auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            compressor.compress(data.data(), data.size(), archive.data(), archive.size());
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (stride == 1) {
+            exactSeconds = seconds;
+            exactSize = size;
+        }
+        std::cout << std::setw(15) << (stride == 1 ? std::string("exact") : "1/" + std::to_string(stride))
+                  << std::setw(15) << size
+                  << std::setw(14) << std::fixed << std::setprecision(2)
+                  << (size * 100.0 / exactSize - 100) << "%"
+                  << std::setw(14) << (100 - seconds * 100.0 / exactSeconds) << "%"
+                  << (stride > 1 && !compressor.lastSampled() ? "  (exact fallback)" : "") << std::endl;
+    }
+}
+
+// Сжатие и распаковка всего входа при каждой из count настроек алгоритма:
+// configure(i, ...) настраивает новые контексты, label(i) - подпись строки
+static void sweepSettings(const std::string& title, const char* column, Common::Algorithm algorithm, size_t count,
+                          const std::function<void(size_t, CompressContext&, DecompressContext&)>& configure,
+                          const std::function<std::string(size_t)>& label, const std::vector<uint8_t>& data,
+                          int iterations, std::vector<uint8_t>& archive) {
+    std::cout << std::endl << title << " (whole file):" << std::endl;
+    std::cout << std::string(75, '-') << std::endl;
+    std::cout << std::setw(15) << column
+              << std::setw(15) << "Size (bytes)"
+              << std::setw(15) << "Ratio (%)"
+              << std::setw(15) << "Comp MB/s"
+              << std::setw(15) << "Decomp MB/s" << std::endl;
+    std::cout << std::string(75, '-') << std::endl;
+
+    std::vector<uint8_t> restored(data.size());
+    double megabytes = static_cast<double>(data.size()) * iterations / (1024.0 * 1024.0);
+    for (size_t i = 0; i < count; i++) {
+        CompressContext compressor(algorithm);
+        DecompressContext decompressor;
+        configure(i, compressor, decompressor);
+        size_t size = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            size = compressor.compress(data.data(), data.size(), archive.data(), archive.size());
+        }
+        auto middle = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            decompressor.decompress(archive.data(), size, restored.data(), restored.size());
+        }
+        auto end = std::chrono::steady_clock::now();
+        if (restored != data) {
+            throw std::runtime_error(std::string(algorithmName(algorithm)) + " round trip mismatch");
+        }
+
+        std::cout << std::setw(15) << label(i)
+                  << std::setw(15) << size
+                  << std::setw(15) << std::fixed << std::setprecision(2) << size * 100.0 / data.size()
+                  << std::setw(15) << std::setprecision(1)
+                  << megabytes / std::chrono::duration<double>(middle - start).count()
+                  << std::setw(15) << megabytes / std::chrono::duration<double>(end - middle).count() << std::endl;
+    }
+}
+
+// Скорость против степени сжатия LZ77 при разных окнах и уровнях поиска
+static void compareLz77(const std::vector<uint8_t>& data, int iterations, std::vector<uint8_t>& archive) {
+    struct Setting {
+        int windowLog;
+        int level;
+    };
+    static const Setting settings[] = {
+        {16, 1}, {16, 5}, {16, 9},
+        {20, 1}, {20, 3}, {20, 5}, {20, 7}, {20, 9},
+        {24, 5}, {24, 9},
+    };
+    sweepSettings(
+        "LZ77 window and effort", "Window/level", Common::ALGO_LZ77, std::size(settings),
+        [](size_t i, CompressContext& compressor, DecompressContext&) {
+            compressor.setLz77Options(settings[i].windowLog, settings[i].level);
+        },
+        [](size_t i) {
+            return std::to_string(1 << settings[i].windowLog >> 10) + "K/" + std::to_string(settings[i].level);
+        },
+        data, iterations, archive);
+}
+
+// Размер блока BWT против степени сжатия и число потоков против скорости.
+// Блоки обрабатываются со своими буферами, поэтому в проверку выделений BWT не входит.
+static void compareBwt(const std::vector<uint8_t>& data, int iterations, std::vector<uint8_t>& archive) {
+    struct Setting {
+        size_t blockSize;
+        unsigned threads;
+    };
+    static const Setting settings[] = {
+        {128 * 1024, 1}, {128 * 1024, 0},
+        {BwtCode::DEFAULT_BLOCK_SIZE, 1}, {BwtCode::DEFAULT_BLOCK_SIZE, 0},
+        {BwtCode::MAX_BLOCK_SIZE, 1},
+    };
+    sweepSettings(
+        "BWT block size and threads", "Block/threads", Common::ALGO_BWT, std::size(settings),
+        [](size_t i, CompressContext& compressor, DecompressContext& decompressor) {
+            compressor.setBwtOptions(settings[i].blockSize, settings[i].threads);
+            decompressor.setBwtThreads(settings[i].threads);
+        },
+        [](size_t i) {
+            return std::to_string(settings[i].blockSize >> 10) + "K/" +
+                   (settings[i].threads == 0 ? std::string("all") : std::to_string(settings[i].threads));
+        },
+        data, iterations, archive);
+}
+
+// Короткие записи с общей таблицей: архив на запись со своей и с обученной
+// таблицей против RecordCodec по одной записи и пакетом. Таблица обучена на
+// самом входе - это верхняя оценка выигрыша для похожих данных.
+// Накладные расходы - байты на запись сверх самих кодов (заголовок архива,
+// таблица или номер, длина записи). Возвращает false, если были выделения памяти
+static bool compareRecords(const std::vector<uint8_t>& data, int iterations, size_t recordSize) {
+    std::cout << std::endl << "Records of " << recordSize << " bytes with a shared table:" << std::endl;
+    std::cout << std::string(90, '-') << std::endl;
+    std::cout << std::setw(20) << "Mode"
+              << std::setw(14) << "Size (bytes)"
+              << std::setw(14) << "Overhead/rec"
+              << std::setw(14) << "Comp MB/s"
+              << std::setw(14) << "Decomp MB/s"
+              << std::setw(14) << "Allocs/call" << std::endl;
+    std::cout << std::string(90, '-') << std::endl;
+
+    std::vector<uint64_t> counts(Common::ALPHABET_SIZE, 0);
+    for (uint8_t byte : data) {
+        counts[byte]++;
+    }
+    PretrainedTable table = PretrainedTable::train("input", counts.data());
+    TableLibrary library("");
+    library.add(table);
+    RecordCodec codec(table);
+
+    std::vector<RecordView> records;
+    for (size_t offset = 0; offset < data.size(); offset += recordSize) {
+        records.push_back({data.data() + offset, std::min(recordSize, data.size() - offset)});
+    }
+    size_t count = records.size();
+    std::vector<uint8_t> packed(count * Codec::compressBound(recordSize));
+    std::vector<uint64_t> offsets(count + 1);
+    std::vector<uint8_t> restored(data.size());
+    std::vector<uint64_t> restoredOffsets(count + 1);
+    double megabytes = static_cast<double>(data.size()) * iterations / (1024.0 * 1024.0);
+    bool clean = true;
+
+    auto report = [&](const char* mode, size_t size, size_t payload, double compressSeconds,
+                      double decompressSeconds, size_t allocations) {
+        if (restored != data) {
+            throw std::runtime_error(std::string(mode) + " round trip mismatch");
+        }
+        std::cout << std::setw(20) << mode
+                  << std::setw(14) << size
+                  << std::setw(14) << std::fixed << std::setprecision(2)
+                  << static_cast<double>(size - payload) / count
+                  << std::setw(14) << std::setprecision(1) << megabytes / compressSeconds
+                  << std::setw(14) << megabytes / decompressSeconds
+                  << std::setw(14) << std::setprecision(3)
+                  << static_cast<double>(allocations) / (2.0 * count * iterations) << std::endl;
+        if (allocations > 0) clean = false;
+    };
+
+    // Архив на каждую запись: своя таблица, затем номер обученной таблицы
+    for (int pretrained = 0; pretrained < 2; pretrained++) {
+        CompressContext compressor(Common::ALGO_HUFFMAN);
+        DecompressContext decompressor;
+        decompressor.setTableLibrary(&library);
+        if (pretrained) compressor.setPretrainedTable(&library.get(table.id));
+
+        size_t size = 0;
+        size_t payload = 0;
+        size_t allocations = 0;
+        double compressSeconds = 0;
+        double decompressSeconds = 0;
+        for (int pass = 0; pass < 2; pass++) {
+            // Первый проход - прогрев арен, время и выделения считаются по второму
+            int rounds = pass == 0 ? 1 : iterations;
+            size_t before = allocationCount;
+            auto start = std::chrono::steady_clock::now();
+            for (int it = 0; it < rounds; it++) {
+                size = 0;
+                payload = 0;
+                for (size_t i = 0; i < count; i++) {
+                    offsets[i] = size;
+                    size += compressor.compress(records[i].data, records[i].size, packed.data() + size,
+                                                packed.size() - size);
+                    payload += ArchiveWriter::readHeader(packed.data() + offsets[i]).compressedSize;
+                }
+                offsets[count] = size;
+            }
+            auto middle = std::chrono::steady_clock::now();
+            for (int it = 0; it < rounds; it++) {
+                for (size_t i = 0; i < count; i++) {
+                    decompressor.decompress(packed.data() + offsets[i], offsets[i + 1] - offsets[i],
+                                            restored.data() + (records[i].data - data.data()), records[i].size);
+                }
+            }
+            auto end = std::chrono::steady_clock::now();
+            allocations = allocationCount - before;
+            compressSeconds = std::chrono::duration<double>(middle - start).count();
+            decompressSeconds = std::chrono::duration<double>(end - middle).count();
+        }
+        report(pretrained ? "Archive, pretrained" : "Archive, own table", size, payload, compressSeconds,
+               decompressSeconds, allocations);
+        std::fill(restored.begin(), restored.end(), 0);
+    }
+
+    // RecordCodec: по одной записи и пакетом; накладные расходы - поле длины
+    for (int batch = 0; batch < 2; batch++) {
+        size_t size = 0;
+        size_t before = allocationCount;
+        auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            if (batch) {
+                size = codec.encodeBatch(records.data(), count, packed.data(), packed.size(), offsets.data());
+                continue;
+            }
+            size = 0;
+            for (size_t i = 0; i < count; i++) {
+                offsets[i] = size;
+                size += codec.encode(records[i].data, records[i].size, packed.data() + size, packed.size() - size);
+            }
+            offsets[count] = size;
+        }
+        auto middle = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            if (batch) {
+                codec.decodeBatch(packed.data(), offsets.data(), count, restored.data(), restored.size(),
+                                  restoredOffsets.data());
+                continue;
+            }
+            for (size_t i = 0; i < count; i++) {
+                codec.decode(packed.data() + offsets[i], offsets[i + 1] - offsets[i],
+                             restored.data() + (records[i].data - data.data()), records[i].size);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        size_t allocations = allocationCount - before;
+
+        size_t lengthBytes = 0;
+        for (size_t i = 0; i < count; i++) {
+            size_t recordOffset = 0;
+            ArchiveWriter::readVarint(packed.data() + offsets[i], offsets[i + 1] - offsets[i], recordOffset);
+            lengthBytes += recordOffset;
+        }
+        report(batch ? "Record, batch" : "Record", size, size - lengthBytes,
+               std::chrono::duration<double>(middle - start).count(),
+               std::chrono::duration<double>(end - middle).count(), allocations);
+        std::fill(restored.begin(), restored.end(), 0);
+    }
+    return clean;
+}
+
+// Распаковка потока сообщений, таблицы которых повторяются: сообщения
+// сжимаются по кругу из DECODE_CACHE_TABLES разных архивов (Хаффман, свои
+// таблицы). Без кэша код строится для каждого сообщения, с кэшем на все
+// таблицы - по разу, с кэшем меньше их числа LRU вытесняет коды по кругу
+static const size_t DECODE_CACHE_TABLES = 16;
+static const unsigned DECODE_CACHE_THREADS = 4;
+
+static void compareDecodeCache(const std::vector<uint8_t>& data, int iterations, size_t messageSize) {
+    std::cout << std::endl << "Decode table cache (Huffman archives of " << messageSize << " bytes, "
+              << DECODE_CACHE_TABLES << " distinct tables):" << std::endl;
+    std::cout << std::string(75, '-') << std::endl;
+    std::cout << std::setw(15) << "Capacity"
+              << std::setw(15) << "Decomp MB/s"
+              << std::setw(15) << "Hits"
+              << std::setw(15) << "Misses"
+              << std::setw(15) << "Evictions" << std::endl;
+    std::cout << std::string(75, '-') << std::endl;
+
+    size_t messages = (data.size() + messageSize - 1) / messageSize;
+    size_t distinct = std::min(messages, DECODE_CACHE_TABLES);
+    CompressContext compressor(Common::ALGO_HUFFMAN);
+    std::vector<std::vector<uint8_t>> archives(distinct);
+    for (size_t m = 0; m < distinct; m++) {
+        size_t count = std::min(messageSize, data.size() - m * messageSize);
+        archives[m].resize(Codec::compressBound(count));
+        archives[m].resize(compressor.compress(data.data() + m * messageSize, count, archives[m].data(),
+                                               archives[m].size()));
+    }
+
+    std::vector<uint8_t> restored(messageSize);
+    double megabytes = 0;
+    for (size_t m = 0; m < messages; m++) {
+        megabytes += std::min(messageSize, data.size() - (m % distinct) * messageSize);
+    }
+    megabytes *= iterations / (1024.0 * 1024.0);
+    const size_t capacities[] = {0, distinct, std::max<size_t>(distinct / 4, 1)};
+    for (size_t i = 0; i < 3; i++) {
+        DecodeTableCache cache(capacities[i]);
+        DecompressContext decompressor;
+        if (i > 0) decompressor.setDecodeCache(&cache);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            for (size_t m = 0; m < messages; m++) {
+                const std::vector<uint8_t>& archive = archives[m % distinct];
+                decompressor.decompress(archive.data(), archive.size(), restored.data(), restored.size());
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (size_t m = 0; m < distinct; m++) {
+            size_t size = decompressor.decompress(archives[m].data(), archives[m].size(), restored.data(),
+                                                  restored.size());
+            if (!std::equal(restored.begin(), restored.begin() + size, data.begin() + m * messageSize)) {
+                throw std::runtime_error("Decode cache round trip mismatch");
+            }
+        }
+
+        DecodeTableCache::Stats stats = cache.stats();
+        std::cout << std::setw(15) << (i == 0 ? std::string("no cache") : std::to_string(capacities[i]))
+                  << std::setw(15) << std::fixed << std::setprecision(1) << megabytes / seconds
+                  << std::setw(15) << stats.hits
+                  << std::setw(15) << stats.misses
+                  << std::setw(15) << stats.evictions << std::endl;
+    }
+
+    // Потоки со своими контекстами и общим кэшем меньше числа таблиц:
+    // промахи, вытеснения и выдача кодов идут одновременно, а вытесненный
+    // код остаётся цел, пока им распаковывает другой поток
+    DecodeTableCache shared(capacities[2]);
+    std::atomic<bool> failed(false);
+    std::atomic<uint64_t> acquires(0);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < DECODE_CACHE_THREADS; t++) {
+        workers.emplace_back([&, t]() {
+            try {
+                DecompressContext decompressor;
+                decompressor.setDecodeCache(&shared);
+                std::vector<uint8_t> output(messageSize);
+                for (int it = 0; it < iterations; it++) {
+                    for (size_t m = 0; m < messages; m++) {
+                        size_t k = (m + t) % distinct;
+                        size_t size = decompressor.decompress(archives[k].data(), archives[k].size(), output.data(),
+                                                              output.size());
+                        if (ArchiveWriter::readHeader(archives[k].data()).algorithm == Common::ALGO_HUFFMAN) {
+                            acquires++;
+                        }
+                        if (!std::equal(output.begin(), output.begin() + size, data.begin() + k * messageSize)) {
+                            failed = true;
+                        }
+                    }
+                }
+            } catch (const std::exception&) {
+                failed = true;
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    DecodeTableCache::Stats stats = shared.stats();
+    if (failed || stats.hits + stats.misses != acquires || stats.entries > stats.capacity) {
+        throw std::runtime_error("Decode cache failed under concurrent use");
+    }
+    std::cout << std::setw(15) << (std::to_string(capacities[2]) + ", " + std::to_string(DECODE_CACHE_THREADS) + " thr")
+              << std::setw(15) << std::fixed << std::setprecision(1)
+              << megabytes * DECODE_CACHE_THREADS / seconds
+              << std::setw(15) << stats.hits
+              << std::setw(15) << stats.misses
+              << std::setw(15) << stats.evictions << std::endl;
+}
+
+// Строки входа как ключи: сортировка и бинарный поиск по сжатым
+// алфавитным кодом ключам без распаковки против тех же действий над исходными
+static const size_t MAX_ORDERED_KEYS = 200000;
+
+static void compareOrderedKeys(const std::vector<uint8_t>& data, int iterations) {
+    std::vector<RecordView> keys;
+    size_t keyBytes = 0;
+    for (size_t start = 0; start < data.size() && keys.size() < MAX_ORDERED_KEYS;) {
+        size_t end = start;
+        while (end < data.size() && data[end] != '\n') end++;
+        keys.push_back({data.data() + start, end - start});
+        keyBytes += end - start;
+        start = end + 1;
+    }
+    if (keys.size() < 2) return;
+
+    std::cout << std::endl << "Order-preserving keys (" << keys.size() << " lines):" << std::endl;
+    std::cout << std::string(75, '-') << std::endl;
+    std::cout << std::setw(15) << "Keys"
+              << std::setw(15) << "Size (bytes)"
+              << std::setw(15) << "Ratio (%)"
+              << std::setw(15) << "Sort ms"
+              << std::setw(15) << "Lookups/s" << std::endl;
+    std::cout << std::string(75, '-') << std::endl;
+
+    std::vector<uint64_t> counts(Common::ALPHABET_SIZE, 0);
+    for (const RecordView& key : keys) {
+        for (size_t i = 0; i < key.size; i++) {
+            counts[key.data[i]]++;
+        }
+    }
+    OrderedKeyCodec codec(PretrainedTable::train("keys", counts.data()),
+                          std::max<size_t>(keyBytes / keys.size(), 1));
+
+    std::vector<uint8_t> packed;
+    std::vector<RecordView> compressed;
+    std::vector<uint64_t> offsets;
+    for (const RecordView& key : keys) {
+        size_t offset = packed.size();
+        packed.resize(offset + codec.keyBound(key.size));
+        packed.resize(offset + codec.encode(key.data, key.size, packed.data() + offset, packed.size() - offset));
+        offsets.push_back(offset);
+    }
+    std::vector<uint8_t> restored;
+    for (size_t i = 0; i < keys.size(); i++) {
+        compressed.push_back({packed.data() + offsets[i], (i + 1 < keys.size() ? offsets[i + 1] : packed.size()) -
+                                                             offsets[i]});
+        restored.resize(keys[i].size + 1);
+        size_t size = codec.decode(compressed[i].data, compressed[i].size, restored.data(), restored.size());
+        if (size != keys[i].size || !std::equal(keys[i].data, keys[i].data + size, restored.data())) {
+            throw std::runtime_error("Ordered key round trip mismatch");
+        }
+    }
+
+    auto rawCompare = [](const RecordView& a, const RecordView& b) {
+        int result = std::memcmp(a.data, b.data, std::min(a.size, b.size));
+        if (result != 0) return result;
+        return a.size < b.size ? -1 : (a.size > b.size ? 1 : 0);
+    };
+    auto sign = [](int value) { return (value > 0) - (value < 0); };
+
+    for (int mode = 0; mode < 2; mode++) {
+        const std::vector<RecordView>& source = mode == 0 ? keys : compressed;
+        std::vector<uint32_t> order(keys.size());
+        double sortSeconds = 0;
+        for (int it = 0; it < iterations; it++) {
+            for (uint32_t i = 0; i < order.size(); i++) {
+                order[i] = i;
+            }
+            auto start = std::chrono::steady_clock::now();
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                return mode == 0 ? rawCompare(source[a], source[b]) < 0
+                                 : OrderedKeyCodec::compare(source[a].data, source[a].size, source[b].data,
+                                                            source[b].size) < 0;
+            });
+            sortSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        // Соседи в порядке сжатых ключей сравниваются так же, как исходные,
+        // и со сжатым, и с несжатым вторым ключом
+        for (size_t i = 1; i < order.size(); i++) {
+            const RecordView& a = compressed[order[i - 1]];
+            const RecordView& b = compressed[order[i]];
+            const RecordView& key = keys[order[i]];
+            int expected = sign(rawCompare(keys[order[i - 1]], key));
+            if (sign(OrderedKeyCodec::compare(a.data, a.size, b.data, b.size)) != expected ||
+                sign(codec.compareWithKey(a.data, a.size, key.data, key.size)) != expected) {
+                throw std::runtime_error("Compressed keys are out of order");
+            }
+        }
+
+        // Поиск каждого ключа: по сжатым - запрос сжимается один раз и
+        // сравнивается побайтно
+        std::vector<uint8_t> probe;
+        auto start = std::chrono::steady_clock::now();
+        for (const RecordView& key : keys) {
+            RecordView target = key;
+            if (mode == 1) {
+                probe.resize(codec.keyBound(key.size));
+                target = {probe.data(), codec.encode(key.data, key.size, probe.data(), probe.size())};
+            }
+            auto found = std::lower_bound(order.begin(), order.end(), target,
+                                          [&](uint32_t index, const RecordView& value) {
+                const RecordView& item = source[index];
+                return mode == 0 ? rawCompare(item, value) < 0
+                                 : OrderedKeyCodec::compare(item.data, item.size, value.data, value.size) < 0;
+            });
+            if (found == order.end() || rawCompare(keys[*found], key) != 0) {
+                throw std::runtime_error("Key lookup failed");
+            }
+        }
+        double searchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t size = mode == 0 ? keyBytes : packed.size();
+        std::cout << std::setw(15) << (mode == 0 ? "raw" : "alphabetic")
+                  << std::setw(15) << size
+                  << std::setw(15) << std::fixed << std::setprecision(2) << 100.0 * size / keyBytes
+                  << std::setw(15) << std::setprecision(1) << sortSeconds * 1000 / iterations
+                  << std::setw(15) << std::setprecision(0) << keys.size() / searchSeconds << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <input_file> [iterations] [message_size]" << std::endl;
+        return 1;
+    }
+
+    try {
+        std::ifstream file(argv[1], std::ios::binary);
+        if (!file) {
+            std::cerr << "Cannot open file: " << argv[1] << std::endl;
+            return 1;
+        }
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+                                  std::istreambuf_iterator<char>());
+        if (data.empty()) {
+            std::cout << "File is empty" << std::endl;
+            return 0;
+        }
+
+        int iterations = argc > 2 ? std::stoi(argv[2]) : 10;
+        size_t messageSize = argc > 3 ? std::stoul(argv[3]) : data.size();
+        if (iterations <= 0 || messageSize == 0) {
+            std::cerr << "Iterations and message size must be positive" << std::endl;
+            return 1;
+        }
+
+        size_t messages = (data.size() + messageSize - 1) / messageSize;
+        std::vector<uint8_t> archive(Codec::compressBound(std::min(messageSize, data.size())));
+        std::vector<uint8_t> restored(std::min(messageSize, data.size()));
+
+        std::cout << "File: " << argv[1] << " (" << data.size() << " bytes, "
+                  << messages << " messages of " << messageSize << " bytes)" << std::endl;
+        std::cout << std::string(75, '-') << std::endl;
+        std::cout << std::setw(15) << "Algorithm"
+                  << std::setw(15) << "Size (bytes)"
+                  << std::setw(15) << "MB/s"
+                  << std::setw(15) << "Warm-up allocs"
+                  << std::setw(15) << "Allocs/call" << std::endl;
+        std::cout << std::string(75, '-') << std::endl;
+
+        bool steadyStateClean = true;
+        for (Common::Algorithm algorithm : ALGORITHMS) {
+            CompressContext compressor(algorithm);
+            DecompressContext decompressor;
+
+            // Первый проход заполняет арены контекстов, дальше выделений быть не должно
+            BenchResult warmUp = run(compressor, decompressor, data, messageSize, 1, archive, restored);
+            BenchResult steady = run(compressor, decompressor, data, messageSize, iterations, archive, restored);
+
+            double megabytes = static_cast<double>(data.size()) * iterations / (1024.0 * 1024.0);
+            double perCall = static_cast<double>(steady.allocations) / (messages * iterations);
+            std::cout << std::setw(15) << algorithmName(algorithm)
+                      << std::setw(15) << warmUp.archiveBytes
+                      << std::setw(15) << std::fixed << std::setprecision(1) << megabytes / steady.seconds
+                      << std::setw(15) << warmUp.allocations
+                      << std::setw(15) << std::setprecision(3) << perCall << std::endl;
+
+            if (steady.allocations > 0) steadyStateClean = false;
+        }
+
+        if (data.size() >= CompressContext::SAMPLING_MIN_SIZE) {
+            std::vector<uint8_t> fullArchive(Codec::compressBound(data.size()));
+            compareSampling(data, iterations, fullArchive);
+            compareLz77(data, iterations, fullArchive);
+            compareBwt(data, iterations, fullArchive);
+        }
+        if (messages > 1 && !compareRecords(data, iterations, messageSize)) {
+            steadyStateClean = false;
+        }
+        if (messages > 1) {
+            compareDecodeCache(data, iterations, messageSize);
+        }
+        compareOrderedKeys(data, iterations);
+        std::cout << std::endl;
+        checkAllByteValues();
+
+        if (!steadyStateClean) {
+            std::cerr << "Steady-state calls allocate memory" << std::endl;
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
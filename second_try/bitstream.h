@@ -2,6 +2,9 @@
 #pragma once
 #include <fstream>
 #include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
 
 class BitOutputStream {
 public:
@@ -64,4 +67,100 @@ private:
     std::istream& in;
     uint8_t buffer;
     int bitCount;
-};
\ No newline at end of file
+};
+
+// Побитовая запись в буфер вызывающей стороны (без iostream).
+// Порядок битов тот же, что у BitOutputStream: старший бит байта первым.
+class BitWriter {
+public:
+    BitWriter(uint8_t* dst, size_t capacity) : out(dst), capacity(capacity), pos(0), buffer(0), bitCount(0) {}
+    
+    // count <= 64
+    void writeBits(uint64_t bits, int count) {
+        if (count > 32) {
+            writeBits(bits >> 32, count - 32);
+            count = 32;
+        }
+        buffer = (buffer << count) | (bits & ((1ULL << count) - 1));
+        bitCount += count;
+        while (bitCount >= 8) {
+            bitCount -= 8;
+            put(static_cast<uint8_t>(buffer >> bitCount));
+        }
+    }
+    
+    void flush() {
+        if (bitCount > 0) {
+            put(static_cast<uint8_t>(buffer << (8 - bitCount)));
+            bitCount = 0;
+        }
+        buffer = 0;
+    }
+    
+    size_t bytesWritten() const { return pos; }
+    uint64_t bitsWritten() const { return pos * 8ULL + bitCount; }
+    
+    // Начать запись с начала буфера, сохранив неполный байт (после того как
+    // вызывающая сторона забрала bytesWritten() готовых байт)
+    void rewind() { pos = 0; }
+    
+private:
+    void put(uint8_t byte) {
+        if (pos >= capacity) {
+            throw std::length_error("Destination buffer too small");
+        }
+        out[pos++] = byte;
+    }
+    
+    uint8_t* out;
+    size_t capacity;
+    size_t pos;
+    uint64_t buffer;
+    int bitCount;
+};
+
+// Побитовое чтение из буфера в памяти. За концом данных читаются нули,
+// поэтому peekBits можно вызывать у самого конца потока.
+class BitReader {
+public:
+    BitReader(const uint8_t* src, size_t size) : in(src), size(size), pos(0), buffer(0), bitCount(0), consumed(0) {}
+    
+    // count <= 32
+    uint32_t peekBits(int count) {
+        refill();
+        return static_cast<uint32_t>((buffer >> (64 - count)) & ((1ULL << count) - 1));
+    }
+    
+    void skipBits(int count) {
+        buffer <<= count;
+        bitCount -= count;
+        consumed += count;
+    }
+    
+    bool readBit() {
+        bool bit = peekBits(1) != 0;
+        skipBits(1);
+        return bit;
+    }
+    
+    // Сколько бит прочитано с начала буфера
+    uint64_t position() const { return consumed; }
+    bool overrun() const { return consumed > size * 8ULL; }
+    
+private:
+    void refill() {
+        while (bitCount <= 56) {
+            uint64_t byte = pos < size ? in[pos] : 0;
+            pos++;
+            buffer |= byte << (56 - bitCount);
+            bitCount += 8;
+        }
+    }
+    
+    const uint8_t* in;
+    size_t size;
+    size_t pos;
+    uint64_t buffer;
+    int bitCount;
+    uint64_t consumed;
+};
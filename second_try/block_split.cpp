@@ -0,0 +1,167 @@
+#include "block_split.h"
+#include "archive_format.h"
+#include "frequency.h"
+#include "bitstream.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    // Размер в битах при идеальном коде по собственным частотам
+    double entropyBits(const uint64_t* counts) {
+        uint64_t total = 0;
+        double sum = 0;
+        for (size_t i = 0; i < Common::ALPHABET_SIZE; i++) {
+            if (counts[i] > 0) {
+                total += counts[i];
+                sum += counts[i] * std::log2(static_cast<double>(counts[i]));
+            }
+        }
+        return total > 0 ? total * std::log2(static_cast<double>(total)) - sum : 0;
+    }
+
+    void countBytes(const uint8_t* src, size_t size, uint64_t* counts) {
+        std::fill(counts, counts + Common::ALPHABET_SIZE, 0);
+        for (size_t i = 0; i < size; i++) {
+            counts[src[i]]++;
+        }
+    }
+
+    uint64_t bitsToBytes(uint64_t bits) { return (bits + 7) / 8; }
+}
+
+BlockSplitter::BlockSplitter(std::pmr::memory_resource* resource)
+    : resource(resource),
+      counts(Common::ALPHABET_SIZE, 0, resource),
+      segmentCounts(Common::ALPHABET_SIZE, 0, resource),
+      mergedCounts(Common::ALPHABET_SIZE, 0, resource),
+      normalized(Common::ALPHABET_SIZE, 0, resource),
+      boundaries(resource),
+      blocks(resource),
+      previous(resource),
+      candidate(resource),
+      havePrevious(false),
+      previousBits(0),
+      newTableCount(0),
+      reusedTableCount(0),
+      storedBlockCount(0) {}
+
+size_t BlockSplitter::bound(size_t size) {
+    // Каждый блок не больше несжатого; блоков - не больше числа сегментов
+    return size + (size / SEGMENT_SIZE + 1) * BlockHeader::SIZE;
+}
+
+void BlockSplitter::resume(const uint64_t* freqs, int bits) {
+    // Тот же код, что строит декодер по таблице (PrefixCode::buildHuffman)
+    previous.buildHuffmanCodes(freqs, Common::ALPHABET_SIZE);
+    havePrevious = true;
+    previousBits = bits;
+}
+
+void BlockSplitter::planBoundaries(const uint8_t* src, size_t size) {
+    // Цена отдельного блока: заголовок и таблица. Точный размер таблицы до
+    // выбора нормировки неизвестен - берётся типичный для текста (BITMAP,
+    // около сотни символов по 6 бит)
+    const double splitCost = 8.0 * (BlockHeader::SIZE + TYPICAL_TABLE_SIZE);
+
+    boundaries.clear();
+    boundaries.push_back(0);
+    size_t first = std::min(size, SEGMENT_SIZE);
+    countBytes(src, first, counts.data());
+    double blockBits = entropyBits(counts.data());
+    uint64_t blockSize = first;
+
+    for (size_t start = first; start < size; start += SEGMENT_SIZE) {
+        size_t length = std::min(SEGMENT_SIZE, size - start);
+        countBytes(src + start, length, segmentCounts.data());
+        for (size_t i = 0; i < Common::ALPHABET_SIZE; i++) {
+            mergedCounts[i] = counts[i] + segmentCounts[i];
+        }
+        double segmentBits = entropyBits(segmentCounts.data());
+        double mergedBits = entropyBits(mergedCounts.data());
+
+        if (mergedBits - blockBits - segmentBits > splitCost || blockSize + length > UINT32_MAX) {
+            boundaries.push_back(start);
+            counts.swap(segmentCounts);
+            blockBits = segmentBits;
+            blockSize = length;
+        } else {
+            counts.swap(mergedCounts);
+            blockBits = mergedBits;
+            blockSize += length;
+        }
+    }
+    boundaries.push_back(size);
+}
+
+size_t BlockSplitter::encodeBlock(const uint8_t* src, uint64_t offset, uint64_t size, uint8_t* dst,
+                                  size_t capacity) {
+    const uint8_t* data = src + offset;
+    countBytes(data, size, counts.data());
+
+    // Точные размеры всех трёх вариантов
+    uint64_t reuseBits = havePrevious ? previous.encodedBits(counts.data(), Common::ALPHABET_SIZE) : UINT64_MAX;
+    int bits = FrequencyAnalyzer::selectTableBits(counts.data(), Common::ALPHABET_SIZE, normalized.data(),
+                                                  candidate, resource);
+    uint64_t newBits = candidate.encodedBits(counts.data(), Common::ALPHABET_SIZE);
+    uint64_t tableBytes = ArchiveWriter::tableSize(normalized.data(), bits);
+    uint64_t newBytes = tableBytes + bitsToBytes(newBits);
+    uint64_t reuseBytes = reuseBits == UINT64_MAX ? UINT64_MAX : bitsToBytes(reuseBits);
+
+    BlockChoice choice = {offset, size, BlockChoice::STORED, 0, 0, size * 8};
+    if (reuseBytes <= newBytes && reuseBytes < size) {
+        choice = {offset, size, BlockChoice::REUSE_TABLE, previousBits, 0, reuseBits};
+    } else if (newBytes < size) {
+        choice = {offset, size, BlockChoice::NEW_TABLE, bits, tableBytes, newBits};
+    }
+
+    uint64_t bodySize = choice.kind == BlockChoice::STORED ? size : choice.tableBytes + bitsToBytes(choice.payloadBits);
+    if (capacity < BlockHeader::SIZE || capacity - BlockHeader::SIZE < bodySize) {
+        throw std::length_error("Destination buffer too small");
+    }
+    uint8_t* body = dst + BlockHeader::SIZE;
+    BlockHeader header;
+    header.originalSize = static_cast<uint32_t>(size);
+    header.compressedSize = static_cast<uint32_t>(bodySize - choice.tableBytes);
+    if (choice.kind == BlockChoice::STORED) {
+        header.type = Common::BLOCK_STORED;
+        header.frequencyBits = 0;
+        std::memcpy(body, data, size);
+        storedBlockCount++;
+    } else if (choice.kind == BlockChoice::REUSE_TABLE) {
+        header.type = Common::BLOCK_REPEAT;
+        header.frequencyBits = 0;
+        BitWriter out(body, bodySize);
+        previous.encode(data, size, out);
+        out.flush();
+        reusedTableCount++;
+    } else {
+        header.type = Common::BLOCK_HUFFMAN;
+        header.frequencyBits = static_cast<uint8_t>(bits);
+        ArchiveWriter::writeFrequencies(body, normalized.data(), bits);
+        BitWriter out(body + tableBytes, bodySize - tableBytes);
+        candidate.encode(data, size, out);
+        out.flush();
+        std::swap(previous, candidate);
+        havePrevious = true;
+        previousBits = bits;
+        newTableCount++;
+    }
+    ArchiveWriter::writeBlockHeader(dst, header);
+    blocks.push_back(choice);
+    return BlockHeader::SIZE + bodySize;
+}
+
+size_t BlockSplitter::encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+    blocks.clear();
+    if (size == 0) return 0;
+    planBoundaries(src, size);
+
+    size_t written = 0;
+    for (size_t i = 0; i + 1 < boundaries.size(); i++) {
+        written += encodeBlock(src, boundaries[i], boundaries[i + 1] - boundaries[i], dst + written,
+                               capacity - written);
+    }
+    return written;
+}
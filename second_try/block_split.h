@@ -0,0 +1,74 @@
+// block_split.h - разбиение на блоки по оценке стоимости
+#pragma once
+#include "common.h"
+#include "prefix_code.h"
+#include <memory_resource>
+#include <cstdint>
+#include <cstddef>
+
+// Выбор для одного блока: своя таблица, таблица предыдущего блока или без сжатия
+struct BlockChoice {
+    enum Kind : uint8_t { NEW_TABLE, REUSE_TABLE, STORED };
+
+    uint64_t offset;
+    uint64_t size;
+    Kind kind;
+    int tableBits;          // разрядность таблицы (своей или повторной), 0 у STORED
+    uint64_t tableBytes;    // место под таблицу в этом блоке
+    uint64_t payloadBits;   // данные без выравнивания и заголовка блока
+};
+
+// Кодирует вход блоками потокового формата (VERSION_4) с границами,
+// выбранными по стоимости. Вход делится на сегменты по SEGMENT_SIZE байт;
+// сегмент присоединяется к текущему блоку, пока потеря на общей таблице
+// (разность энтропий объединения и частей) меньше цены отдельной таблицы
+// с заголовком блока. Затем для каждого блока сравниваются точные размеры:
+// новая таблица (BLOCK_HUFFMAN), код предыдущего блока с таблицей без
+// записи таблицы (BLOCK_REPEAT) и несжатые данные (BLOCK_STORED).
+// Код последней записанной таблицы помнится между вызовами encode(),
+// поэтому повторно использовать её может и первый блок следующего вызова.
+class BlockSplitter {
+public:
+    // constexpr: std::min принимает по ссылке, нужно определение и без -O2
+    static constexpr size_t SEGMENT_SIZE = 16 * 1024;
+    static const size_t TYPICAL_TABLE_SIZE = 112;
+
+    explicit BlockSplitter(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Возвращает число записанных байт; std::length_error, если не хватает места
+    // (capacity >= bound(size) достаточно всегда)
+    size_t encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity);
+    static size_t bound(size_t size);
+
+    // Начать новый поток: таблица предыдущего блока забывается
+    void reset() { havePrevious = false; }
+    // Продолжить поток, последний блок с таблицей которого записан по
+    // частотам freqs разрядности bits: первый блок может взять его код
+    // (дописывание в существующий архив)
+    void resume(const uint64_t* freqs, int bits);
+
+    // Блоки последнего encode() и счётчики за всё время жизни объекта
+    const std::pmr::vector<BlockChoice>& lastBlocks() const { return blocks; }
+    uint64_t newTables() const { return newTableCount; }
+    uint64_t reusedTables() const { return reusedTableCount; }
+    uint64_t storedBlocks() const { return storedBlockCount; }
+
+private:
+    void planBoundaries(const uint8_t* src, size_t size);
+    size_t encodeBlock(const uint8_t* src, uint64_t offset, uint64_t size, uint8_t* dst, size_t capacity);
+
+    std::pmr::memory_resource* resource;
+    std::pmr::vector<uint64_t> counts;
+    std::pmr::vector<uint64_t> segmentCounts;
+    std::pmr::vector<uint64_t> mergedCounts;
+    std::pmr::vector<uint64_t> normalized;
+    std::pmr::vector<uint64_t> boundaries;
+    std::pmr::vector<BlockChoice> blocks;
+    PrefixCode previous;
+    PrefixCode candidate;
+    bool havePrevious;
+    int previousBits;
+    uint64_t newTableCount;
+    uint64_t reusedTableCount;
+    uint64_t storedBlockCount;
+};
@@ -0,0 +1,447 @@
+#include "bwt.h"
+#include "archive_format.h"
+#include "frequency.h"
+#include "bitstream.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+    // Заголовок блока: первичный индекс, размер потока, разрядность таблицы
+    const size_t BLOCK_HEADER_SIZE = 9;
+
+    uint32_t read32(const uint8_t* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    void write32(uint8_t* p, uint32_t value) {
+        std::memcpy(p, &value, sizeof(value));
+    }
+
+    // Начала (end = false) или концы корзин символов алфавита k
+    void bucketBounds(const int32_t* s, int32_t n, int32_t k, int32_t* bkt, bool end) {
+        std::fill(bkt, bkt + k, 0);
+        for (int32_t i = 0; i < n; i++) {
+            bkt[s[i]]++;
+        }
+        int32_t sum = 0;
+        for (int32_t c = 0; c < k; c++) {
+            int32_t count = bkt[c];
+            sum += count;
+            bkt[c] = end ? sum : sum - count;
+        }
+    }
+
+    // Индуцированная сортировка: L-суффиксы слева направо, S-суффиксы справа налево
+    void induceL(const int32_t* s, int32_t* sa, int32_t n, int32_t k, const uint8_t* stype, int32_t* bkt) {
+        bucketBounds(s, n, k, bkt, false);
+        for (int32_t i = 0; i < n; i++) {
+            int32_t j = sa[i] - 1;
+            if (sa[i] > 0 && !stype[j]) {
+                sa[bkt[s[j]]++] = j;
+            }
+        }
+    }
+
+    void induceS(const int32_t* s, int32_t* sa, int32_t n, int32_t k, const uint8_t* stype, int32_t* bkt) {
+        bucketBounds(s, n, k, bkt, true);
+        for (int32_t i = n - 1; i >= 0; i--) {
+            int32_t j = sa[i] - 1;
+            if (sa[i] > 0 && stype[j]) {
+                sa[--bkt[s[j]]] = j;
+            }
+        }
+    }
+
+    // Суффиксный массив SA-IS (Nong, Zhang, Chan) за линейное время.
+    // Последний символ s должен быть единственным минимальным (терминатор 0).
+    void sais(const int32_t* s, int32_t* sa, int32_t n, int32_t k) {
+        if (n == 1) {
+            sa[0] = 0;
+            return;
+        }
+
+        std::vector<uint8_t> stype(n);
+        stype[n - 1] = 1;
+        for (int32_t i = n - 2; i >= 0; i--) {
+            stype[i] = s[i] < s[i + 1] || (s[i] == s[i + 1] && stype[i + 1]);
+        }
+        auto isLms = [&stype](int32_t i) { return i > 0 && stype[i] && !stype[i - 1]; };
+
+        // Грубая сортировка LMS-подстрок
+        std::vector<int32_t> bkt(k);
+        bucketBounds(s, n, k, bkt.data(), true);
+        std::fill(sa, sa + n, -1);
+        for (int32_t i = 1; i < n; i++) {
+            if (isLms(i)) {
+                sa[--bkt[s[i]]] = i;
+            }
+        }
+        induceL(s, sa, n, k, stype.data(), bkt.data());
+        induceS(s, sa, n, k, stype.data(), bkt.data());
+
+        int32_t n1 = 0;
+        for (int32_t i = 0; i < n; i++) {
+            if (isLms(sa[i])) {
+                sa[n1++] = sa[i];
+            }
+        }
+
+        // Имена LMS-подстрок; позиции LMS отстоят минимум на 2, поэтому
+        // имя позиции pos помещается в sa[n1 + pos / 2]
+        std::fill(sa + n1, sa + n, -1);
+        int32_t names = 0;
+        int32_t prev = -1;
+        for (int32_t i = 0; i < n1; i++) {
+            int32_t pos = sa[i];
+            bool differs = false;
+            for (int32_t d = 0;; d++) {
+                if (prev == -1 || s[pos + d] != s[prev + d] || stype[pos + d] != stype[prev + d]) {
+                    differs = true;
+                    break;
+                }
+                if (d > 0 && (isLms(pos + d) || isLms(prev + d))) {
+                    break;
+                }
+            }
+            if (differs) {
+                names++;
+                prev = pos;
+            }
+            sa[n1 + pos / 2] = names - 1;
+        }
+        for (int32_t i = n - 1, j = n - 1; i >= n1; i--) {
+            if (sa[i] >= 0) {
+                sa[j--] = sa[i];
+            }
+        }
+
+        // Сокращённая строка из имён; рекурсия, пока имена не станут уникальными
+        int32_t* s1 = sa + n - n1;
+        if (names < n1) {
+            sais(s1, sa, n1, names);
+        } else {
+            for (int32_t i = 0; i < n1; i++) {
+                sa[s1[i]] = i;
+            }
+        }
+
+        // Точный порядок LMS-суффиксов индуцирует порядок всех остальных
+        bucketBounds(s, n, k, bkt.data(), true);
+        for (int32_t i = 1, j = 0; i < n; i++) {
+            if (isLms(i)) {
+                s1[j++] = i;
+            }
+        }
+        for (int32_t i = 0; i < n1; i++) {
+            sa[i] = s1[sa[i]];
+        }
+        std::fill(sa + n1, sa + n, -1);
+        for (int32_t i = n1 - 1; i >= 0; i--) {
+            int32_t j = sa[i];
+            sa[i] = -1;
+            sa[--bkt[s[j]]] = j;
+        }
+        induceL(s, sa, n, k, stype.data(), bkt.data());
+        induceS(s, sa, n, k, stype.data(), bkt.data());
+    }
+
+    // Серия из run нулей MTF в биективной двоичной записи цифрами RUN_A (1) и RUN_B (2)
+    void emitRun(uint64_t run, std::vector<uint16_t>& symbols, uint64_t* freqs) {
+        while (run > 0) {
+            uint32_t symbol = (run & 1) ? BwtCode::RUN_A : BwtCode::RUN_B;
+            symbols.push_back(static_cast<uint16_t>(symbol));
+            freqs[symbol]++;
+            run = (run - 1 - symbol) / 2;
+        }
+    }
+
+    void mtfEncode(const uint8_t* src, size_t size, std::vector<uint16_t>& symbols, uint64_t* freqs) {
+        uint8_t order[Common::ALPHABET_SIZE];
+        std::iota(order, order + Common::ALPHABET_SIZE, 0);
+        uint64_t run = 0;
+        for (size_t i = 0; i < size; i++) {
+            uint8_t c = src[i];
+            if (order[0] == c) {
+                run++;
+                continue;
+            }
+            emitRun(run, symbols, freqs);
+            run = 0;
+
+            // Сдвиг списка до позиции c с одновременным поиском
+            uint8_t carried = order[0];
+            order[0] = c;
+            uint32_t index = 1;
+            while (order[index] != c) {
+                std::swap(carried, order[index]);
+                index++;
+            }
+            order[index] = carried;
+
+            symbols.push_back(static_cast<uint16_t>(index + 1));
+            freqs[index + 1]++;
+        }
+        emitRun(run, symbols, freqs);
+    }
+
+    void mtfDecode(const PrefixCode& code, BitReader& in, uint8_t* dst, size_t size) {
+        uint8_t order[Common::ALPHABET_SIZE];
+        std::iota(order, order + Common::ALPHABET_SIZE, 0);
+        size_t pos = 0;
+        uint64_t run = 0;
+        uint64_t weight = 1;
+        while (pos + run < size) {
+            uint32_t symbol = code.decodeSymbol(in);
+            if (symbol <= BwtCode::RUN_B) {
+                run += weight << symbol;
+                weight <<= 1;
+                if (run > size - pos) {
+                    throw std::runtime_error("Corrupted BWT block: zero run out of range");
+                }
+                continue;
+            }
+            if (run > 0) {
+                std::memset(dst + pos, order[0], run);
+                pos += run;
+                run = 0;
+                weight = 1;
+            }
+
+            uint32_t index = symbol - 1;
+            uint8_t c = order[index];
+            std::memmove(order + 1, order, index);
+            order[0] = c;
+            dst[pos++] = c;
+        }
+        std::memset(dst + pos, order[0], run);
+    }
+
+    void encodeBlock(const uint8_t* src, size_t size, std::vector<uint8_t>& out) {
+        std::vector<uint8_t> transformed(size);
+        uint32_t primary = BwtCode::forward(src, size, transformed.data());
+
+        std::vector<uint16_t> symbols;
+        symbols.reserve(size);
+        std::vector<uint64_t> freqs(BwtCode::SYMBOLS, 0);
+        std::vector<uint64_t> normalized(BwtCode::SYMBOLS, 0);
+        mtfEncode(transformed.data(), size, symbols, freqs.data());
+
+        std::pmr::memory_resource* heap = std::pmr::new_delete_resource();
+        PrefixCode code(heap);
+        int bits = FrequencyAnalyzer::selectTableBits(freqs.data(), BwtCode::SYMBOLS, normalized.data(), code, heap);
+        size_t tableSize = ArchiveWriter::tableSize(normalized.data(), bits, BwtCode::SYMBOLS);
+
+        // Код по точным частотам не длиннее 9 бит на символ в среднем,
+        // а более узкая таблица выбирается, только если выигрывает вместе с ней
+        size_t prefixSize = BLOCK_HEADER_SIZE + tableSize;
+        out.resize(prefixSize + size + size / 8 + ArchiveWriter::tableBound(BwtCode::SYMBOLS) + 16);
+        write32(out.data(), primary);
+        out[8] = static_cast<uint8_t>(bits);
+        ArchiveWriter::writeFrequencies(out.data() + BLOCK_HEADER_SIZE, normalized.data(), bits, BwtCode::SYMBOLS);
+
+        BitWriter writer(out.data() + prefixSize, out.size() - prefixSize);
+        code.encode(symbols.data(), symbols.size(), writer);
+        writer.flush();
+        write32(out.data() + 4, static_cast<uint32_t>(writer.bytesWritten()));
+        out.resize(prefixSize + writer.bytesWritten());
+    }
+
+    void decodeBlock(const uint8_t* src, size_t tableSize, uint8_t* dst, size_t size) {
+        uint32_t primary = read32(src);
+        uint32_t payloadSize = read32(src + 4);
+        int bits = src[8];
+
+        std::pmr::memory_resource* heap = std::pmr::new_delete_resource();
+        std::vector<uint64_t> freqs(BwtCode::SYMBOLS, 0);
+        ArchiveWriter::readFrequencies(src + BLOCK_HEADER_SIZE, tableSize, bits, freqs.data(), BwtCode::SYMBOLS);
+        PrefixCode code(heap);
+        code.buildHuffman(freqs.data(), BwtCode::SYMBOLS);
+
+        BitReader in(src + BLOCK_HEADER_SIZE + tableSize, payloadSize);
+        mtfDecode(code, in, dst, size);
+        if (in.overrun()) {
+            throw std::runtime_error("Unexpected end of stream during decoding");
+        }
+        BwtCode::inverse(dst, size, primary, dst);
+    }
+
+    // Задачи 0..count-1 разбираются workers потоками (включая вызывающий);
+    // первое исключение останавливает раздачу и пробрасывается после join
+    template <typename Task>
+    void runParallel(size_t count, unsigned workers, const Task& task) {
+        std::atomic<size_t> next(0);
+        std::vector<std::exception_ptr> errors(workers);
+        auto loop = [&](unsigned id) {
+            try {
+                for (size_t i; (i = next++) < count;) {
+                    task(i);
+                }
+            } catch (...) {
+                errors[id] = std::current_exception();
+                next = count;
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned id = 1; id < workers; id++) {
+            threads.emplace_back(loop, id);
+        }
+        loop(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        for (const std::exception_ptr& error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+    }
+}
+
+BwtCode::BwtCode() : block(DEFAULT_BLOCK_SIZE), threadCount(0) {}
+
+void BwtCode::configure(size_t blockSize, unsigned threads) {
+    if (blockSize < MIN_BLOCK_SIZE || blockSize > MAX_BLOCK_SIZE) {
+        throw std::invalid_argument("BWT block size must be in " + std::to_string(MIN_BLOCK_SIZE) + ".." +
+                                    std::to_string(MAX_BLOCK_SIZE));
+    }
+    block = blockSize;
+    threadCount = threads;
+}
+
+unsigned BwtCode::workerCount(size_t blocks) const {
+    unsigned workers = threadCount != 0 ? threadCount : std::thread::hardware_concurrency();
+    if (workers == 0) workers = 1;
+    return static_cast<unsigned>(std::min<size_t>(workers, std::max<size_t>(blocks, 1)));
+}
+
+uint32_t BwtCode::forward(const uint8_t* src, size_t size, uint8_t* dst) {
+    if (size == 0) return 0;
+    if (size > MAX_BLOCK_SIZE) {
+        throw std::length_error("BWT block is too large");
+    }
+
+    // Суффиксы строки с терминатором: байты сдвинуты на 1, терминатор - 0.
+    // Строка 0 - суффикс из одного терминатора, перед ним последний байт входа
+    int32_t n = static_cast<int32_t>(size) + 1;
+    std::vector<int32_t> text(n);
+    std::vector<int32_t> sa(n);
+    for (size_t i = 0; i < size; i++) {
+        text[i] = src[i] + 1;
+    }
+    text[size] = 0;
+    sais(text.data(), sa.data(), n, Common::ALPHABET_SIZE + 1);
+
+    uint32_t primary = 0;
+    size_t out = 0;
+    for (int32_t row = 0; row < n; row++) {
+        int32_t pos = sa[row];
+        if (pos == 0) {
+            primary = static_cast<uint32_t>(row);
+            continue;
+        }
+        dst[out++] = src[pos - 1];
+    }
+    return primary;
+}
+
+void BwtCode::inverse(const uint8_t* src, size_t size, uint32_t primary, uint8_t* dst) {
+    if (size == 0) return;
+    if (primary == 0 || primary > size || size > MAX_BLOCK_SIZE) {
+        throw std::runtime_error("Corrupted BWT block: primary index out of range");
+    }
+
+    uint32_t next[Common::ALPHABET_SIZE] = {0};
+    for (size_t i = 0; i < size; i++) {
+        next[src[i]]++;
+    }
+    uint32_t sum = 1;  // строка 0 занята терминатором
+    for (size_t c = 0; c < Common::ALPHABET_SIZE; c++) {
+        uint32_t count = next[c];
+        next[c] = sum;
+        sum += count;
+    }
+
+    // links[r] = (строка следующего символа << 8) | первый символ строки r:
+    // на каждый байт выхода одно случайное чтение, символ лежит рядом со ссылкой
+    std::vector<uint32_t> links(size + 1, 0);
+    for (uint32_t row = 0; row < primary; row++) {
+        uint8_t c = src[row];
+        links[next[c]++] = (row << 8) | c;
+    }
+    for (uint32_t row = primary + 1; row <= size; row++) {
+        uint8_t c = src[row - 1];
+        links[next[c]++] = (row << 8) | c;
+    }
+
+    uint32_t row = primary;
+    for (size_t i = 0; i < size; i++) {
+        uint32_t link = links[row];
+        dst[i] = static_cast<uint8_t>(link);
+        row = link >> 8;
+    }
+}
+
+size_t BwtCode::encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+    if (capacity < 4) {
+        throw std::length_error("Destination buffer too small");
+    }
+    write32(dst, static_cast<uint32_t>(block));
+
+    size_t blocks = (size + block - 1) / block;
+    std::vector<std::vector<uint8_t>> outputs(blocks);
+    runParallel(blocks, workerCount(blocks), [&](size_t i) {
+        size_t offset = i * block;
+        encodeBlock(src + offset, std::min(block, size - offset), outputs[i]);
+    });
+
+    size_t offset = 4;
+    for (const std::vector<uint8_t>& out : outputs) {
+        if (capacity - offset < out.size()) {
+            throw std::length_error("Destination buffer too small");
+        }
+        std::memcpy(dst + offset, out.data(), out.size());
+        offset += out.size();
+    }
+    return offset;
+}
+
+void BwtCode::decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size) {
+    if (srcSize < 4) {
+        throw std::runtime_error("BWT stream is truncated");
+    }
+    size_t blockSize = read32(src);
+    if (blockSize < MIN_BLOCK_SIZE || blockSize > MAX_BLOCK_SIZE) {
+        throw std::runtime_error("Corrupted BWT stream: invalid block size");
+    }
+
+    // Заголовки блоков читаются последовательно, сами блоки - параллельно
+    size_t blocks = (size + blockSize - 1) / blockSize;
+    std::vector<const uint8_t*> starts(blocks);
+    std::vector<size_t> tableSizes(blocks);
+    size_t offset = 4;
+    for (size_t i = 0; i < blocks; i++) {
+        if (srcSize - offset < BLOCK_HEADER_SIZE) {
+            throw std::runtime_error("BWT stream is truncated");
+        }
+        tableSizes[i] = ArchiveWriter::readTableSize(src + offset + BLOCK_HEADER_SIZE,
+                                                     srcSize - offset - BLOCK_HEADER_SIZE, src[offset + 8], SYMBOLS);
+        size_t blockBytes = BLOCK_HEADER_SIZE + tableSizes[i] + read32(src + offset + 4);
+        if (srcSize - offset < blockBytes) {
+            throw std::runtime_error("BWT stream is truncated");
+        }
+        starts[i] = src + offset;
+        offset += blockBytes;
+    }
+
+    runParallel(blocks, workerCount(blocks), [&](size_t i) {
+        size_t position = i * blockSize;
+        decodeBlock(starts[i], tableSizes[i], dst + position, std::min(blockSize, size - position));
+    });
+}
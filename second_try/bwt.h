@@ -0,0 +1,57 @@
+// bwt.h - преобразование Барроуза-Уилера с MTF и кодированием серий нулей
+#pragma once
+#include "common.h"
+#include "prefix_code.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Вход режется на независимые блоки, каждый блок проходит цепочку
+// BWT (суффиксный массив SA-IS) -> move-to-front -> серии нулей в биективной
+// двоичной записи RUN_A/RUN_B (как в bzip2) -> код Хаффмана на алфавите
+// SYMBOLS = 2 символа серий + 255 ненулевых индексов MTF.
+// Блоки сжимаются и распаковываются параллельно в нескольких потоках.
+//
+// Формат данных: размер блока (4 байта), затем для каждого блока
+// первичный индекс (4 байта), размер битового потока (4 байта),
+// разрядность таблицы (1 байт), таблица частот в формате ArchiveWriter
+// и поток кодов старшими битами вперёд.
+//
+// В отличие от остальных кодеров рабочие массивы не живут в арене
+// контекста: каждый блок обрабатывается со своими буферами из кучи,
+// чтобы потоки ничего не делили между собой.
+class BwtCode {
+public:
+    static const uint32_t RUN_A = 0;
+    static const uint32_t RUN_B = 1;
+    static const uint32_t SYMBOLS = 2 + Common::ALPHABET_SIZE - 1;
+
+    static const size_t MIN_BLOCK_SIZE = 1024;
+    // Индекс строки и символ упаковываются в 32 бита при обратном преобразовании
+    static const size_t MAX_BLOCK_SIZE = 8 << 20;
+    static const size_t DEFAULT_BLOCK_SIZE = 900 * 1024;
+
+    BwtCode();
+
+    // threads = 0 - по числу аппаратных потоков;
+    // std::invalid_argument при размере блока вне допустимых границ
+    void configure(size_t blockSize, unsigned threads);
+    size_t blockSize() const { return block; }
+    unsigned threads() const { return threadCount; }
+
+    // Возвращает размер закодированных данных; std::length_error, если не хватает места
+    size_t encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity);
+    void decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size);
+
+    // Прямое преобразование size байт в dst, возвращает первичный индекс
+    // (номер строки, соответствующей самому входу; от 1 до size)
+    static uint32_t forward(const uint8_t* src, size_t size, uint8_t* dst);
+    // Обратное преобразование; src и dst могут совпадать
+    static void inverse(const uint8_t* src, size_t size, uint32_t primary, uint8_t* dst);
+
+private:
+    unsigned workerCount(size_t blocks) const;
+
+    size_t block;
+    unsigned threadCount;
+};
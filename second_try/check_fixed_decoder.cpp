@@ -0,0 +1,124 @@
+#include "common.h"
+#include "huffman.h"
+#include "prefix_code.h"
+#include "mapped_output.h"
+#include "sample_decoder.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <random>
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+// Сверка заголовка, сгенерированного gen_decoder (SampleTable, см. makefile),
+// с HuffmanEncoder/HuffmanDecoder на той же таблице: коды, закодированные
+// данные и результат декодирования должны совпадать бит в бит
+
+using SampleCode = SampleTable::Code;
+
+static void checkCodes(const HuffmanEncoder& encoder) {
+    std::map<uint8_t, std::vector<bool>> codes = encoder.getCodes();
+    for (uint32_t symbol = 0; symbol < Common::ALPHABET_SIZE; symbol++) {
+        auto found = codes.find(static_cast<uint8_t>(symbol));
+        size_t length = found == codes.end() ? 0 : found->second.size();
+        if (length != SampleTable::Table::lengths[symbol]) {
+            throw std::runtime_error("Code length differs for symbol " + std::to_string(symbol));
+        }
+        uint64_t bits = 0;
+        for (size_t i = 0; i < length; i++) {
+            bits = (bits << 1) | (found->second[i] ? 1 : 0);
+        }
+        if (bits != SampleTable::Table::codes[symbol]) {
+            throw std::runtime_error("Code differs for symbol " + std::to_string(symbol));
+        }
+    }
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void checkData(const std::string& label, const std::vector<uint8_t>& data, const HuffmanEncoder& encoder,
+                      const std::vector<uint64_t>& frequencies) {
+    std::ostringstream stream;
+    BitOutputStream bitsOut(stream);
+    encoder.encodeData(data, bitsOut);
+    bitsOut.flush();
+    std::string text = stream.str();
+    std::vector<uint8_t> encoded(text.begin(), text.end());
+
+    // Кодер по сгенерированным таблицам даёт те же байты
+    std::vector<uint8_t> fixedEncoded(encoded.size() + 8);
+    BitWriter writer(fixedEncoded.data(), fixedEncoded.size());
+    SampleCode::encode(data.data(), data.size(), writer);
+    writer.flush();
+    if (writer.bytesWritten() != encoded.size() ||
+        !std::equal(encoded.begin(), encoded.end(), fixedEncoded.begin())) {
+        throw std::runtime_error(label + ": encoded data differs from HuffmanEncoder");
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::istringstream input(text);
+    BitInputStream bitsIn(input);
+    HuffmanDecoder reference(frequencies);
+    std::vector<uint8_t> expected = reference.decodeData(bitsIn, data.size());
+    double referenceSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    PrefixCode runtime;
+    runtime.buildHuffman(frequencies.data(), Common::ALPHABET_SIZE);
+    std::vector<uint8_t> runtimeDecoded(data.size());
+    BitReader runtimeReader(encoded.data(), encoded.size());
+    runtime.decode(runtimeReader, runtimeDecoded.data(), runtimeDecoded.size());
+    double runtimeSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> decoded(data.size());
+    BitReader reader(encoded.data(), encoded.size());
+    SampleCode::decode(reader, decoded.data(), decoded.size());
+    double fixedSeconds = secondsSince(start);
+
+    if (expected != data || runtimeDecoded != data || decoded != data) {
+        throw std::runtime_error(label + ": decoded data differs from HuffmanDecoder");
+    }
+    double megabytes = data.size() / (1024.0 * 1024.0);
+    std::cout << std::setw(24) << label << std::setw(12) << data.size() << std::setw(16) << std::fixed
+              << std::setprecision(1) << megabytes / referenceSeconds << std::setw(16) << megabytes / runtimeSeconds
+              << std::setw(16) << megabytes / fixedSeconds << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        std::vector<uint64_t> frequencies(std::begin(SampleTable::Table::frequencies),
+                                          std::end(SampleTable::Table::frequencies));
+        HuffmanEncoder encoder(frequencies);
+        checkCodes(encoder);
+
+        std::cout << "Table " << std::hex << SampleTable::Table::ID << std::dec << ": codes up to "
+                  << SampleTable::Table::MAX_CODE_LENGTH << " bits, primary index " << SampleTable::Table::PRIMARY_BITS
+                  << " bits, " << SampleTable::Table::SECONDARY_SIZE << " secondary entries" << std::endl;
+        std::cout << std::setw(24) << "Data" << std::setw(12) << "Bytes" << std::setw(16) << "Huffman MB/s"
+                  << std::setw(16) << "Runtime MB/s" << std::setw(16) << "Fixed MB/s" << std::endl;
+
+        for (int i = 1; i < argc; i++) {
+            MappedInput input(argv[i]);
+            checkData(argv[i], std::vector<uint8_t>(input.data(), input.data() + input.size()), encoder,
+                      frequencies);
+        }
+        // Все символы, в том числе с самыми длинными кодами
+        std::vector<uint8_t> random(1 << 20);
+        std::mt19937 generator(12345);
+        for (uint8_t& byte : random) {
+            byte = static_cast<uint8_t>(generator());
+        }
+        checkData("random bytes", random, encoder, frequencies);
+
+        std::cout << "Generated decoder matches HuffmanDecoder" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Check failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
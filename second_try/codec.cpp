@@ -0,0 +1,635 @@
+#include "codec.h"
+#include "archive_format.h"
+#include "frequency.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    // Алгоритмы с префиксным кодом PrefixCode по таблице частот архива
+    bool prefixAlgorithm(Common::Algorithm algorithm) {
+        return algorithm == Common::ALGO_HUFFMAN || algorithm == Common::ALGO_SHANNON_FANO ||
+               algorithm == Common::ALGO_ALPHABETIC;
+    }
+}
+
+CompressContext::CompressContext(Common::Algorithm algorithm)
+    : algorithm(algorithm),
+      scratchBuffer(new std::byte[SCRATCH_SIZE]),
+      scratch(scratchBuffer.get(), SCRATCH_SIZE, &pool),
+      counts(Common::ALPHABET_SIZE, 0, &pool),
+      normFreqs(Common::ALPHABET_SIZE, 0, &pool),
+      code(&pool),
+      tans(&pool),
+      lz77(&pool),
+      utf8(&pool),
+      word(&pool),
+      frequencyBits(0),
+      sampleStride(0),
+      sampled(false),
+      stored(false),
+      filterMode(DataFilter::AUTO),
+      appliedFilter(DataFilter::NONE),
+      filtered(&pool),
+      filterTemp(&pool),
+      filterSample(&pool),
+      indexInterval(0),
+      index(&pool),
+      pretrained(nullptr),
+      pretrainedReady(false) {
+    if (algorithm != Common::ALGO_HUFFMAN && algorithm != Common::ALGO_SHANNON_FANO &&
+        algorithm != Common::ALGO_TANS && algorithm != Common::ALGO_RANGE &&
+        algorithm != Common::ALGO_ADAPTIVE_HUFFMAN && algorithm != Common::ALGO_LZ77 &&
+        algorithm != Common::ALGO_BWT && algorithm != Common::ALGO_UTF8 &&
+        algorithm != Common::ALGO_WORD && algorithm != Common::ALGO_ALPHABETIC) {
+        throw std::invalid_argument("Unsupported algorithm: " + std::to_string(algorithm));
+    }
+}
+
+void CompressContext::setFilter(uint8_t filter) {
+    if (filter != DataFilter::AUTO) {
+        try {
+            DataFilter::validate(filter);
+        } catch (const std::runtime_error& e) {
+            throw std::invalid_argument(e.what());
+        }
+    }
+    filterMode = filter;
+}
+
+void CompressContext::setIndexInterval(size_t interval) {
+    if (interval > 0 && !prefixAlgorithm(algorithm)) {
+        throw std::invalid_argument("Seek index requires Huffman, Shannon-Fano or alphabetic coding");
+    }
+    if (interval > UINT32_MAX) {
+        throw std::invalid_argument("Seek index interval must be below 2^32");
+    }
+    indexInterval = interval;
+}
+
+void CompressContext::setPretrainedTable(const PretrainedTable* table) {
+    if (table && !prefixAlgorithm(algorithm)) {
+        throw std::invalid_argument("Pretrained tables require Huffman, Shannon-Fano or alphabetic coding");
+    }
+    pretrained = table;
+    pretrainedReady = false;
+}
+
+void CompressContext::buildCode(const uint64_t* freqs) {
+    if (algorithm == Common::ALGO_SHANNON_FANO) {
+        code.buildShannonFano(freqs, Common::ALPHABET_SIZE);
+    } else if (algorithm == Common::ALGO_ALPHABETIC) {
+        code.buildAlphabeticCodes(freqs, Common::ALPHABET_SIZE);
+    } else {
+        code.buildHuffmanCodes(freqs, Common::ALPHABET_SIZE);
+    }
+}
+
+void CompressContext::countExact(const uint8_t* src, size_t srcSize) {
+    std::fill(counts.begin(), counts.end(), 0);
+    for (size_t i = 0; i < srcSize; i++) {
+        counts[src[i]]++;
+    }
+}
+
+void CompressContext::countSampled(const uint8_t* src, size_t srcSize) {
+    // Пол в 1 для всех символов: таблица описывает весь алфавит,
+    // поэтому любой байт входа кодируется без дополнительного прохода
+    std::fill(counts.begin(), counts.end(), 1);
+    size_t step = SAMPLE_BLOCK * sampleStride;
+    for (size_t offset = 0; offset < srcSize; offset += step) {
+        size_t end = std::min(offset + SAMPLE_BLOCK, srcSize);
+        for (size_t i = offset; i < end; i++) {
+            counts[src[i]] += sampleStride;
+        }
+    }
+    // Счётчики масштабированы на шаг, чтобы оценка размера данных при выборе
+    // разрядности таблицы была сравнима с размером самой таблицы
+}
+
+size_t CompressContext::encodeBody(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                                   uint64_t& payloadSize) {
+    // Временные массивы прошлого вызова больше не нужны
+    scratch.release();
+
+    if (algorithm == Common::ALGO_TANS) {
+        return encodeTans(src, srcSize, dst, dstCapacity, payloadSize);
+    }
+    return encodePrefix(src, srcSize, dst, dstCapacity, payloadSize);
+}
+
+size_t CompressContext::encodeTans(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                                   uint64_t& payloadSize) {
+    // Таблица частот с суммой 2^TABLE_LOG в самой короткой компактной форме
+    if (srcSize == 0) {
+        std::fill(normFreqs.begin(), normFreqs.end(), 0);
+    } else {
+        FrequencyNormalizer::normalizeToSum(counts.data(), counts.size(), 1ULL << TansCode::TABLE_LOG,
+                                            normFreqs.data(), &scratch);
+    }
+    frequencyBits = ArchiveWriter::compactTableBits(normFreqs.data());
+    size_t tableSize = ArchiveWriter::tableSize(normFreqs.data(), frequencyBits);
+    if (dstCapacity < tableSize) {
+        throw std::length_error("Destination buffer too small");
+    }
+    ArchiveWriter::writeFrequencies(dst, normFreqs.data(), frequencyBits);
+
+    if (srcSize == 0) {
+        payloadSize = 0;
+        return tableSize;
+    }
+    tans.build(normFreqs.data(), Common::ALPHABET_SIZE);
+
+    payloadSize = tans.encode(src, srcSize, dst + tableSize, dstCapacity - tableSize);
+    return tableSize + payloadSize;
+}
+
+size_t CompressContext::encodePrefix(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                                     uint64_t& payloadSize) {
+    if (algorithm == Common::ALGO_HUFFMAN) {
+        frequencyBits = FrequencyAnalyzer::selectTableBits(counts.data(), counts.size(), normFreqs.data(), code,
+                                                           &scratch);
+        return writePrefix(src, srcSize, dst, dstCapacity, payloadSize);
+    }
+
+    // Коды Шеннона-Фано и алфавитные коды не короче кода Хаффмана,
+    // поэтому нижняя граница данных для отсечения ширин - код Хаффмана
+    std::pmr::vector<uint32_t> order(counts.size(), &scratch);
+    FrequencyNormalizer::rankByFrequency(counts.data(), counts.size(), order.data());
+    code.buildHuffmanCodes(counts.data(), Common::ALPHABET_SIZE);
+    uint64_t exactBytes = (code.encodedBits(counts.data(), Common::ALPHABET_SIZE) + 7) / 8;
+
+    int widths[FrequencyAnalyzer::MAX_WIDTHS];
+    int number = FrequencyAnalyzer::normalizationWidths(counts.data(), counts.size(), widths);
+    uint64_t bestSize = UINT64_MAX;
+    int bestBits = 64;
+    for (int i = 0; i < number; i++) {
+        FrequencyNormalizer::normalizeToBits(counts.data(), counts.size(), widths[i], normFreqs.data(),
+                                             order.data());
+        int tableBits = ArchiveWriter::compactTableBits(normFreqs.data());
+        uint64_t tableBytes = ArchiveWriter::tableSize(normFreqs.data(), tableBits);
+        if (exactBytes + tableBytes >= bestSize) continue;
+        buildCode(normFreqs.data());
+        uint64_t payloadBits = code.encodedBits(counts.data(), Common::ALPHABET_SIZE);
+        if (payloadBits == UINT64_MAX) continue;
+        uint64_t totalSize = (payloadBits + 7) / 8 + tableBytes;
+        if (totalSize < bestSize) {
+            bestSize = totalSize;
+            bestBits = widths[i];
+        }
+    }
+
+    FrequencyNormalizer::normalizeToBits(counts.data(), counts.size(), bestBits, normFreqs.data(), order.data());
+    buildCode(normFreqs.data());
+    frequencyBits = ArchiveWriter::compactTableBits(normFreqs.data());
+    return writePrefix(src, srcSize, dst, dstCapacity, payloadSize);
+}
+
+size_t CompressContext::writePrefix(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                                    uint64_t& payloadSize) {
+    bool external = frequencyBits == ArchiveWriter::PRETRAINED_TABLE;
+    size_t tableSize = external ? ArchiveWriter::TABLE_ID_SIZE
+                                : ArchiveWriter::tableSize(normFreqs.data(), frequencyBits);
+    if (dstCapacity < tableSize) {
+        throw std::length_error("Destination buffer too small");
+    }
+    if (external) {
+        std::memcpy(dst, &pretrained->id, ArchiveWriter::TABLE_ID_SIZE);
+    } else {
+        ArchiveWriter::writeFrequencies(dst, normFreqs.data(), frequencyBits);
+    }
+
+    BitWriter out(dst + tableSize, dstCapacity - tableSize);
+    if (indexInterval == 0) {
+        code.encode(src, srcSize, out);
+    } else {
+        // Точка индекса - позиция в битах перед каждым куском входа
+        index.reset(static_cast<uint32_t>(indexInterval));
+        for (size_t offset = 0; offset < srcSize || offset == 0; offset += indexInterval) {
+            index.add(offset, out.bitsWritten());
+            code.encode(src + offset, std::min(indexInterval, srcSize - offset), out);
+        }
+    }
+    out.flush();
+
+    payloadSize = out.bytesWritten();
+    return tableSize + out.bytesWritten();
+}
+
+bool CompressContext::incompressible(size_t srcSize, size_t tableSize) const {
+    // Нижняя граница кода нулевого порядка - энтропия гистограммы; при
+    // выборке счётчики масштабированы, поэтому оценка пересчитывается на srcSize
+    uint64_t total = 0;
+    double bits = 0;
+    for (uint64_t count : counts) {
+        total += count;
+    }
+    if (total == 0) return true;
+    for (uint64_t count : counts) {
+        if (count > 0) {
+            bits += count * std::log2(static_cast<double>(total) / count);
+        }
+    }
+    double estimate = bits / 8 * srcSize / total + tableSize;
+    return estimate >= srcSize;
+}
+
+size_t CompressContext::storeBody(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                                  uint64_t& payloadSize) {
+    if (dstCapacity < srcSize) {
+        throw std::length_error("Destination buffer too small");
+    }
+    if (srcSize > 0) {
+        std::memcpy(dst, src, srcSize);
+    }
+    stored = true;
+    frequencyBits = 0;
+    payloadSize = srcSize;
+    return srcSize;
+}
+
+size_t CompressContext::compressBody(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                                     uint64_t& payloadSize) {
+    stored = false;
+    size_t bodySize;
+    try {
+        bodySize = encodeAlgorithm(src, srcSize, dst, dstCapacity, payloadSize);
+    } catch (const std::length_error&) {
+        // Код не поместился, а вход поместится - значит, сжатия всё равно нет
+        if (dstCapacity < srcSize) throw;
+        return storeBody(src, srcSize, dst, dstCapacity, payloadSize);
+    }
+    if (stored || bodySize < srcSize) {
+        return bodySize;
+    }
+    return storeBody(src, srcSize, dst, dstCapacity, payloadSize);
+}
+
+size_t CompressContext::encodeAlgorithm(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                                        uint64_t& payloadSize) {
+    if (algorithm == Common::ALGO_RANGE || algorithm == Common::ALGO_ADAPTIVE_HUFFMAN) {
+        // Модели адаптивные, таблицы нет; гистограмма нужна только для оценки энтропии.
+        // Обучение модели обходится не дешевле самой компактной таблицы
+        sampled = false;
+        frequencyBits = 0;
+        countExact(src, srcSize);
+        if (incompressible(srcSize, MIN_TABLE_SIZE)) {
+            return storeBody(src, srcSize, dst, dstCapacity, payloadSize);
+        }
+        payloadSize = algorithm == Common::ALGO_RANGE ? RangeCode::encode(src, srcSize, dst, dstCapacity)
+                                                      : AdaptiveHuffmanCode::encode(src, srcSize, dst, dstCapacity);
+        return payloadSize;
+    }
+    if (algorithm == Common::ALGO_LZ77) {
+        // Таблицы литералов/длин и расстояний строятся по разбору и лежат внутри данных
+        scratch.release();
+        sampled = false;
+        frequencyBits = 0;
+        payloadSize = lz77.encode(src, srcSize, dst, dstCapacity, &scratch);
+        return payloadSize;
+    }
+    if (algorithm == Common::ALGO_BWT) {
+        sampled = false;
+        frequencyBits = 0;
+        payloadSize = bwt.encode(src, srcSize, dst, dstCapacity);
+        return payloadSize;
+    }
+    if (algorithm == Common::ALGO_UTF8) {
+        // Таблица кодовых точек и частоты расширенного алфавита - внутри данных
+        scratch.release();
+        sampled = false;
+        frequencyBits = 0;
+        payloadSize = utf8.encode(src, srcSize, dst, dstCapacity, &scratch);
+        return payloadSize;
+    }
+    if (algorithm == Common::ALGO_WORD) {
+        sampled = false;
+        frequencyBits = 0;
+        payloadSize = word.encode(src, srcSize, dst, dstCapacity);
+        return payloadSize;
+    }
+
+    if (pretrained) {
+        // Код по обученным частотам строится один раз: ни гистограммы, ни
+        // выбора разрядности. Несжимаемость видна только по результату
+        sampled = false;
+        if (!pretrainedReady) {
+            std::copy(pretrained->frequencies.begin(), pretrained->frequencies.end(), normFreqs.begin());
+            buildCode(normFreqs.data());
+            pretrainedReady = true;
+        }
+        frequencyBits = ArchiveWriter::PRETRAINED_TABLE;
+        return writePrefix(src, srcSize, dst, dstCapacity, payloadSize);
+    }
+
+    size_t minTableSize = MIN_TABLE_SIZE;
+    sampled = sampleStride > 1 && srcSize >= SAMPLING_MIN_SIZE;
+    if (sampled) {
+        countSampled(src, srcSize);
+        if (incompressible(srcSize, minTableSize)) {
+            return storeBody(src, srcSize, dst, dstCapacity, payloadSize);
+        }
+        try {
+            return encodeBody(src, srcSize, dst, dstCapacity, payloadSize);
+        } catch (const std::length_error&) {
+            // Выборка оказалась нерепрезентативной - кодируем по точным частотам
+            sampled = false;
+        }
+    }
+
+    countExact(src, srcSize);
+    if (incompressible(srcSize, minTableSize)) {
+        return storeBody(src, srcSize, dst, dstCapacity, payloadSize);
+    }
+    return encodeBody(src, srcSize, dst, dstCapacity, payloadSize);
+}
+
+size_t CompressContext::compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity) {
+    if (dstCapacity < ArchiveHeader::SIZE) {
+        throw std::length_error("Destination buffer too small");
+    }
+
+    index.reset(0);
+    appliedFilter = filterMode;
+    if (indexInterval > 0 || pretrained) {
+        if (filterMode != DataFilter::AUTO && filterMode != DataFilter::NONE) {
+            throw std::invalid_argument(pretrained ? "Filters cannot be combined with a pretrained table"
+                                                   : "Filters cannot be combined with a seek index");
+        }
+        appliedFilter = DataFilter::NONE;
+    } else if (filterMode == DataFilter::AUTO) {
+        bool contextCoder = algorithm == Common::ALGO_LZ77 || algorithm == Common::ALGO_BWT;
+        filterSample.resize(DataFilter::WORKSPACE_SIZE);
+        appliedFilter = DataFilter::detect(src, srcSize, contextCoder, filterSample.data());
+    }
+    const uint8_t* input = src;
+    if (appliedFilter != DataFilter::NONE) {
+        filtered.resize(srcSize);
+        bool needTemp = DataFilter::transposed(appliedFilter) &&
+                        DataFilter::predictor(appliedFilter) != DataFilter::PREDICT_NONE;
+        filterTemp.resize(needTemp ? srcSize : 0);
+        DataFilter::apply(appliedFilter, src, srcSize, filtered.data(), filterTemp.data());
+        input = filtered.data();
+    }
+
+    uint64_t payloadSize = 0;
+    size_t bodySize = compressBody(input, srcSize, dst + ArchiveHeader::SIZE, dstCapacity - ArchiveHeader::SIZE,
+                                   payloadSize);
+    if (stored && appliedFilter != DataFilter::NONE) {
+        // Несжатые данные хранятся без фильтра: распаковка - одно копирование
+        std::memcpy(dst + ArchiveHeader::SIZE, src, srcSize);
+        appliedFilter = DataFilter::NONE;
+    }
+
+    ArchiveHeader header;
+    header.signature = Common::SIGNATURE;
+    header.version = algorithm == Common::ALGO_SHANNON_FANO && !stored ? Common::VERSION_3 : Common::VERSION_2;
+    header.algorithm = stored ? Common::ALGO_STORED : algorithm;
+    header.frequencyBits = frequencyBits;
+    header.filter = appliedFilter;
+    header.originalSize = srcSize;
+    header.compressedSize = payloadSize;
+    ArchiveWriter::writeHeader(dst, header);
+
+    size_t archiveSize = ArchiveHeader::SIZE + bodySize;
+    if (stored) {
+        index.reset(0);
+    } else if (!index.empty()) {
+        archiveSize += index.write(dst + archiveSize, dstCapacity - archiveSize);
+    }
+    return archiveSize;
+}
+
+DecompressContext::DecompressContext()
+    : freqs(Common::ALPHABET_SIZE, 0, &pool), code(&pool), tans(&pool), lz77(&pool), utf8(&pool), word(&pool),
+      huffmanReady(false), filterTemp(&pool), rangeTemp(&pool), tables(nullptr),
+      codeTable(nullptr), codeAlgorithm(Common::ALGO_HUFFMAN), decodeCache(nullptr), activeCode(&code) {}
+
+void DecompressContext::buildPrefixCode(Common::Algorithm algorithm, int frequencyBits, const uint8_t* table,
+                                        size_t tableSize) {
+    if (!prefixAlgorithm(algorithm)) {
+        throw std::runtime_error("Unsupported algorithm: " + std::to_string(algorithm));
+    }
+    huffmanReady = algorithm == Common::ALGO_HUFFMAN;
+    if (frequencyBits == ArchiveWriter::PRETRAINED_TABLE) {
+        if (!tables) {
+            throw std::runtime_error("Archive refers to a pretrained table, but no table library is set");
+        }
+        uint32_t id;
+        std::memcpy(&id, table, sizeof(id));
+        const PretrainedTable& pretrained = tables->get(id);
+        if (codeTable == &pretrained && codeAlgorithm == algorithm) return;
+        std::copy(pretrained.frequencies.begin(), pretrained.frequencies.end(), freqs.begin());
+        codeTable = &pretrained;
+    } else {
+        ArchiveWriter::readFrequencies(table, tableSize, frequencyBits, freqs.data());
+        codeTable = nullptr;
+    }
+    codeAlgorithm = algorithm;
+    if (decodeCache) {
+        cachedCode = decodeCache->acquire(algorithm, freqs.data());
+        activeCode = cachedCode.get();
+        return;
+    }
+    activeCode = &code;
+    if (huffmanReady) {
+        code.buildHuffman(freqs.data(), Common::ALPHABET_SIZE);
+    } else if (algorithm == Common::ALGO_ALPHABETIC) {
+        code.buildAlphabetic(freqs.data(), Common::ALPHABET_SIZE);
+    } else {
+        code.buildShannonFano(freqs.data(), Common::ALPHABET_SIZE);
+    }
+}
+
+void DecompressContext::decompressBody(Common::Algorithm algorithm, int frequencyBits, const uint8_t* src,
+                                       size_t tableSize, uint64_t payloadSize, uint8_t* dst,
+                                       uint64_t originalSize) {
+    if (algorithm == Common::ALGO_ADAPTIVE_HUFFMAN) {
+        // Маркер конца есть и у пустого потока
+        AdaptiveHuffmanCode::decode(src, payloadSize, dst, originalSize);
+        return;
+    }
+    if (algorithm == Common::ALGO_STORED) {
+        if (payloadSize != originalSize) {
+            throw std::runtime_error("Corrupted stored block: size mismatch");
+        }
+        if (originalSize > 0) {
+            std::memcpy(dst, src, originalSize);
+        }
+        return;
+    }
+    if (originalSize == 0) return;
+
+    if (algorithm == Common::ALGO_RANGE) {
+        RangeCode::decode(src, payloadSize, dst, originalSize);
+        return;
+    }
+    if (algorithm == Common::ALGO_LZ77) {
+        lz77.decode(src, payloadSize, dst, originalSize);
+        return;
+    }
+    if (algorithm == Common::ALGO_BWT) {
+        bwt.decode(src, payloadSize, dst, originalSize);
+        return;
+    }
+    if (algorithm == Common::ALGO_UTF8) {
+        utf8.decode(src, payloadSize, dst, originalSize);
+        return;
+    }
+    if (algorithm == Common::ALGO_WORD) {
+        word.decode(src, payloadSize, dst, originalSize);
+        return;
+    }
+
+    if (algorithm == Common::ALGO_TANS) {
+        ArchiveWriter::readFrequencies(src, tableSize, frequencyBits, freqs.data());
+        tans.build(freqs.data(), Common::ALPHABET_SIZE);
+        tans.decode(src + tableSize, payloadSize, dst, originalSize);
+        return;
+    }
+    buildPrefixCode(algorithm, frequencyBits, src, tableSize);
+
+    BitReader in(src + tableSize, payloadSize);
+    activeCode->decode(in, dst, originalSize);
+}
+
+void DecompressContext::decompressRepeat(const uint8_t* src, uint64_t payloadSize, uint8_t* dst,
+                                         uint64_t originalSize) {
+    if (!huffmanReady) {
+        throw std::runtime_error("Repeated block without a preceding Huffman table");
+    }
+    BitReader in(src, payloadSize);
+    activeCode->decode(in, dst, originalSize);
+}
+
+size_t DecompressContext::parseArchive(const uint8_t* src, size_t srcSize, ArchiveHeader& header) {
+    if (srcSize < ArchiveHeader::SIZE) {
+        throw std::runtime_error("Archive is truncated");
+    }
+    header = ArchiveWriter::readHeader(src);
+    if (header.signature != Common::SIGNATURE) {
+        throw std::runtime_error("Invalid signature");
+    }
+
+    bool version2 = header.version == Common::VERSION_2 &&
+                   (header.algorithm == Common::ALGO_HUFFMAN || header.algorithm == Common::ALGO_TANS ||
+                    header.algorithm == Common::ALGO_RANGE || header.algorithm == Common::ALGO_ADAPTIVE_HUFFMAN ||
+                    header.algorithm == Common::ALGO_LZ77 || header.algorithm == Common::ALGO_BWT ||
+                    header.algorithm == Common::ALGO_STORED || header.algorithm == Common::ALGO_UTF8 ||
+                    header.algorithm == Common::ALGO_WORD || header.algorithm == Common::ALGO_ALPHABETIC);
+    bool shannonFano = header.version == Common::VERSION_3 && header.algorithm == Common::ALGO_SHANNON_FANO;
+    if (!version2 && !shannonFano) {
+        throw std::runtime_error("Unsupported version or algorithm: version=" + std::to_string(header.version) +
+                                 ", algorithm=" + std::to_string(header.algorithm));
+    }
+
+    size_t tableSize = ArchiveWriter::readTableSize(src + ArchiveHeader::SIZE, srcSize - ArchiveHeader::SIZE,
+                                                    header.frequencyBits);
+    size_t prefixSize = ArchiveHeader::SIZE + tableSize;
+    if (srcSize < prefixSize || srcSize - prefixSize < header.compressedSize) {
+        throw std::runtime_error("Archive is truncated");
+    }
+    DataFilter::validate(header.filter);
+    return tableSize;
+}
+
+size_t DecompressContext::decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity) {
+    ArchiveHeader header;
+    size_t tableSize = parseArchive(src, srcSize, header);
+    if (dstCapacity < header.originalSize) {
+        throw std::length_error("Destination buffer too small");
+    }
+
+    decompressBody(static_cast<Common::Algorithm>(header.algorithm), header.frequencyBits,
+                   src + ArchiveHeader::SIZE, tableSize, header.compressedSize, dst, header.originalSize);
+    if (header.filter != DataFilter::NONE) {
+        filterTemp.resize(DataFilter::transposed(header.filter) ? header.originalSize : 0);
+        DataFilter::invert(header.filter, dst, header.originalSize, filterTemp.data());
+    }
+    return header.originalSize;
+}
+
+size_t DecompressContext::decodeRange(const uint8_t* src, size_t srcSize, uint64_t offset, uint64_t length,
+                                      uint8_t* dst, size_t dstCapacity) {
+    ArchiveHeader header;
+    size_t tableSize = parseArchive(src, srcSize, header);
+    if (offset > header.originalSize) {
+        throw std::out_of_range("Range starts past the end of data");
+    }
+    length = std::min(length, header.originalSize - offset);
+    if (dstCapacity < length) {
+        throw std::length_error("Destination buffer too small");
+    }
+    if (length == 0) return 0;
+
+    const uint8_t* table = src + ArchiveHeader::SIZE;
+    const uint8_t* payload = table + tableSize;
+    bool prefix = prefixAlgorithm(static_cast<Common::Algorithm>(header.algorithm));
+    if (header.filter == DataFilter::NONE && header.algorithm == Common::ALGO_STORED) {
+        if (header.compressedSize != header.originalSize) {
+            throw std::runtime_error("Corrupted stored block: size mismatch");
+        }
+        std::memcpy(dst, payload + offset, length);
+        return length;
+    }
+    if (header.filter != DataFilter::NONE || !prefix) {
+        rangeTemp.resize(header.originalSize);
+        decompress(src, srcSize, rangeTemp.data(), rangeTemp.size());
+        std::memcpy(dst, rangeTemp.data() + offset, length);
+        return length;
+    }
+
+    buildPrefixCode(static_cast<Common::Algorithm>(header.algorithm), header.frequencyBits, table, tableSize);
+
+    // Без индекса декодирование идёт с начала данных
+    SeekPoint point = {0, 0};
+    size_t tailOffset = ArchiveHeader::SIZE + tableSize + header.compressedSize;
+    SeekIndex::locate(src + tailOffset, srcSize - tailOffset, offset, point);
+    if (point.bitOffset > header.compressedSize * 8) {
+        throw std::runtime_error("Corrupted seek index");
+    }
+    uint64_t startByte = point.bitOffset / 8;
+    BitReader in(payload + startByte, header.compressedSize - startByte);
+    in.skipBits(static_cast<int>(point.bitOffset % 8));
+    for (uint64_t skip = offset - point.offset; skip > 0; skip--) {
+        activeCode->decodeSymbol(in);
+    }
+    activeCode->decode(in, dst, length);
+    return length;
+}
+
+namespace Codec {
+    size_t compressBound(size_t srcSize, size_t indexInterval) {
+        return ArchiveHeader::SIZE + ArchiveWriter::tableBound() + srcSize + srcSize / 8 + 1 +
+               SeekIndex::bound(srcSize, indexInterval);
+    }
+
+    uint64_t decompressedSize(const uint8_t* src, size_t srcSize) {
+        if (srcSize < ArchiveHeader::SIZE) {
+            throw std::runtime_error("Archive is truncated");
+        }
+        ArchiveHeader header = ArchiveWriter::readHeader(src);
+        if (header.signature != Common::SIGNATURE) {
+            throw std::runtime_error("Invalid signature");
+        }
+        return header.originalSize;
+    }
+
+    size_t compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity) {
+        CompressContext context;
+        return context.compress(src, srcSize, dst, dstCapacity);
+    }
+
+    size_t decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity) {
+        DecompressContext context;
+        return context.decompress(src, srcSize, dst, dstCapacity);
+    }
+
+    size_t decodeRange(const uint8_t* src, size_t srcSize, uint64_t offset, uint64_t length, uint8_t* dst,
+                       size_t dstCapacity) {
+        DecompressContext context;
+        return context.decodeRange(src, srcSize, offset, length, dst, dstCapacity);
+    }
+}
@@ -0,0 +1,243 @@
+// codec.h - библиотечный интерфейс: сжатие из буфера в буфер
+#pragma once
+#include "common.h"
+#include "archive_format.h"
+#include "prefix_code.h"
+#include "tans.h"
+#include "range_coder.h"
+#include "adaptive_huffman.h"
+#include "lz77.h"
+#include "bwt.h"
+#include "utf8_code.h"
+#include "word_code.h"
+#include "filter.h"
+#include "seek_index.h"
+#include "table_library.h"
+#include "decode_cache.h"
+#include <memory>
+#include <memory_resource>
+#include <cstdint>
+#include <cstddef>
+
+// Контекст сжатия. Рабочие таблицы живут в арене контекста и
+// переиспользуются между вызовами: после первого (прогревочного) вызова
+// сжатие не обращается к куче. Один контекст выгодно держать на поток.
+// Результат - обычный архив (VERSION_2 для Хаффмана, tANS, интервального
+// кодера, адаптивного Хаффмана, LZ77, BWT, UTF-8, словного и алфавитного кода, VERSION_3 для Шеннона-Фано),
+// который понимает decoder.
+// Исключение - ALGO_BWT: блоки обрабатываются в отдельных потоках со своими буферами.
+class CompressContext {
+public:
+    explicit CompressContext(Common::Algorithm algorithm = Common::ALGO_HUFFMAN);
+
+    // Возвращает размер архива в dst. Если места не хватает - std::length_error;
+    // dstCapacity >= Codec::compressBound(srcSize, шаг индекса) достаточно всегда.
+    size_t compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+
+    // Таблица частот и сжатые данные без заголовка (для блоков потокового формата).
+    // Возвращает число записанных байт, payloadSize - размер данных после таблицы.
+    size_t compressBody(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                        uint64_t& payloadSize);
+
+    int lastFrequencyBits() const { return frequencyBits; }
+
+    // Несжимаемый вход сохраняется как есть (ALGO_STORED, BLOCK_STORED в потоке).
+    // Для кодов нулевого порядка это видно заранее по энтропии гистограммы:
+    // если даже её нижняя оценка с минимальной таблицей не меньше входа,
+    // кодирование не запускается. Для остальных алгоритмов (и когда оценка
+    // не сработала) решение принимается по фактическому размеру.
+    bool lastStored() const { return stored; }
+
+    // Предварительный фильтр (описание DataFilter) или DataFilter::AUTO -
+    // выбор по выборке входа (по умолчанию). Применяется только в compress(),
+    // тела блоков потокового формата не фильтруются.
+    // std::invalid_argument для неизвестного описания
+    void setFilter(uint8_t filter);
+    uint8_t lastFilter() const { return appliedFilter; }
+
+    // Оценка частот по выборке: считается каждый stride-й блок по SAMPLE_BLOCK
+    // байт (0 и 1 - полный проход). Каждому из 256 символов добавляется 1,
+    // чтобы символы, не попавшие в выборку, тоже получили код. Если код по
+    // выборке не помещается в буфер, блок пересчитывается по точным частотам.
+    void setSampleStride(size_t stride) { sampleStride = stride; }
+    bool lastSampled() const { return sampled; }
+
+    // Окно (log2 байт) и уровень усилий поиска совпадений для ALGO_LZ77
+    void setLz77Options(int windowLog, int level) { lz77.configure(windowLog, level); }
+    const Lz77Code& lz77Stats() const { return lz77; }
+
+    // Размер блока и число потоков (0 - по числу ядер) для ALGO_BWT
+    void setBwtOptions(size_t blockSize, unsigned threads) { bwt.configure(blockSize, threads); }
+
+    // Таблица кодовых точек и число байт в escape последнего ALGO_UTF8
+    const Utf8Code& utf8Stats() const { return utf8; }
+    // Словарь и разбор на лексемы последнего ALGO_WORD
+    const WordCode& wordStats() const { return word; }
+
+    // Индекс произвольного доступа (SeekIndex) с точкой каждые interval байт
+    // входа, 0 - без индекса (по умолчанию). Только для ALGO_HUFFMAN,
+    // ALGO_SHANNON_FANO и ALGO_ALPHABETIC, interval - до 2^32-1 (иначе std::invalid_argument).
+    // Фильтры меняют данные с накоплением по всему входу, поэтому вместе с
+    // индексом не применяются: AUTO означает NONE, явно заданный фильтр -
+    // std::invalid_argument в compress(). Несжатый вход индекса не получает:
+    // в нём смещение и так известно.
+    void setIndexInterval(size_t interval);
+    // Индекс последнего compress(); пуст, если он не записан
+    const SeekIndex& lastIndex() const { return index; }
+
+    // Обученная таблица вместо частот входа: гистограмма не считается, в
+    // архив вместо таблицы пишется её номер. Только для ALGO_HUFFMAN,
+    // ALGO_SHANNON_FANO и ALGO_ALPHABETIC (иначе std::invalid_argument); nullptr - своя
+    // таблица (по умолчанию). Таблица должна жить, пока она задана.
+    // Фильтры с ней, как и с индексом, не применяются. Если вход с этой
+    // таблицей не сжимается, он сохраняется как есть.
+    void setPretrainedTable(const PretrainedTable* table);
+
+    static const size_t SAMPLE_BLOCK = 64;
+    // Меньшие входы всегда считаются целиком: выигрыш по времени ничтожен
+    static const size_t SAMPLING_MIN_SIZE = 64 * 1024;
+
+private:
+    void buildCode(const uint64_t* freqs);
+    bool incompressible(size_t srcSize, size_t tableSize) const;
+    size_t storeBody(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                     uint64_t& payloadSize);
+    size_t encodeAlgorithm(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                           uint64_t& payloadSize);
+    void countExact(const uint8_t* src, size_t srcSize);
+    void countSampled(const uint8_t* src, size_t srcSize);
+    size_t encodeBody(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                      uint64_t& payloadSize);
+    size_t encodePrefix(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                        uint64_t& payloadSize);
+    // Таблица normFreqs разрядности frequencyBits и данные, закодированные code
+    size_t writePrefix(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                       uint64_t& payloadSize);
+    size_t encodeTans(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                      uint64_t& payloadSize);
+
+    static const size_t SCRATCH_SIZE = 32 * 1024;
+    // Самая короткая компактная таблица: байт формы и хотя бы байт данных
+    static const size_t MIN_TABLE_SIZE = 2;
+
+    Common::Algorithm algorithm;
+    // Долгоживущие таблицы - в пуле, временные массивы одного вызова -
+    // в монотонной арене поверх заранее выделенного буфера
+    std::pmr::unsynchronized_pool_resource pool;
+    std::unique_ptr<std::byte[]> scratchBuffer;
+    std::pmr::monotonic_buffer_resource scratch;
+    std::pmr::vector<uint64_t> counts;
+    std::pmr::vector<uint64_t> normFreqs;
+    PrefixCode code;
+    TansCode tans;
+    Lz77Code lz77;
+    BwtCode bwt;
+    Utf8Code utf8;
+    WordCode word;
+    int frequencyBits;
+    size_t sampleStride;
+    bool sampled;
+    bool stored;
+    uint8_t filterMode;
+    uint8_t appliedFilter;
+    std::pmr::vector<uint8_t> filtered;
+    std::pmr::vector<uint8_t> filterTemp;
+    std::pmr::vector<uint8_t> filterSample;
+    size_t indexInterval;
+    SeekIndex index;
+    const PretrainedTable* pretrained;
+    bool pretrainedReady;   // code построен по pretrained
+};
+
+// Контекст распаковки архивов VERSION_2 (Хаффман, tANS, интервальный кодер,
+// адаптивный Хаффман, LZ77, BWT, UTF-8, словный и алфавитный код) и VERSION_3 (Шеннон-Фано).
+// Как и CompressContext, после прогрева работает без выделений памяти.
+class DecompressContext {
+public:
+    DecompressContext();
+
+    // Возвращает число байт, записанных в dst
+    size_t decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+
+    // Байты [offset, offset + length) несжатых данных; length урезается до
+    // конца данных, возвращается число записанных байт. Хаффман и
+    // Шеннон-Фано с индексом (CompressContext::setIndexInterval) декодируются
+    // с ближайшей контрольной точки, несжатые данные копируются со смещения -
+    // из src читаются только таблица, индекс и данные рядом с диапазоном.
+    // Остальные архивы распаковываются целиком во временный буфер.
+    // offset за концом данных - std::out_of_range
+    size_t decodeRange(const uint8_t* src, size_t srcSize, uint64_t offset, uint64_t length, uint8_t* dst,
+                       size_t dstCapacity);
+
+    // Откуда брать таблицы архивов, записанных с обученной таблицей
+    // (CompressContext::setPretrainedTable); без библиотеки такие архивы -
+    // std::runtime_error. Библиотека должна жить, пока она задана
+    void setTableLibrary(TableLibrary* library) {
+        tables = library;
+        codeTable = nullptr;
+    }
+
+    // Брать префиксные коды (Хаффман, Шеннон-Фано, алфавитный) из кэша (например,
+    // DecodeTableCache::instance()), а не строить их для каждого архива;
+    // nullptr - строить самому (по умолчанию). Промах кэша выделяет память
+    void setDecodeCache(DecodeTableCache* cache) {
+        decodeCache = cache;
+        codeTable = nullptr;
+    }
+
+    // Число потоков распаковки блоков BWT (0 - по числу ядер)
+    void setBwtThreads(unsigned threads) { bwt.configure(bwt.blockSize(), threads); }
+
+    // Тело блока: таблица частот (tableSize байт в формате frequencyBits,
+    // см. ArchiveWriter::readTableSize) и payloadSize байт сжатых данных,
+    // из которых декодируется originalSize байт
+    void decompressBody(Common::Algorithm algorithm, int frequencyBits, const uint8_t* src, size_t tableSize,
+                        uint64_t payloadSize, uint8_t* dst, uint64_t originalSize);
+    // Тело блока BLOCK_REPEAT: только данные, код - от последнего тела
+    // ALGO_HUFFMAN; std::runtime_error, если такого ещё не было
+    void decompressRepeat(const uint8_t* src, uint64_t payloadSize, uint8_t* dst, uint64_t originalSize);
+
+private:
+    // Проверяет заголовок и размеры архива, возвращает размер таблицы частот
+    static size_t parseArchive(const uint8_t* src, size_t srcSize, ArchiveHeader& header);
+    // Код Хаффмана или Шеннона-Фано по таблице архива или по обученной
+    // таблице из библиотеки. Код по обученной таблице остаётся от прошлого
+    // вызова, если таблица и алгоритм те же: для коротких сообщений его
+    // построение дороже самого декодирования
+    void buildPrefixCode(Common::Algorithm algorithm, int frequencyBits, const uint8_t* table, size_t tableSize);
+
+    std::pmr::unsynchronized_pool_resource pool;
+    std::pmr::vector<uint64_t> freqs;
+    PrefixCode code;
+    TansCode tans;
+    Lz77Code lz77;
+    BwtCode bwt;
+    Utf8Code utf8;
+    WordCode word;
+    bool huffmanReady;
+    std::pmr::vector<uint8_t> filterTemp;
+    std::pmr::vector<uint8_t> rangeTemp;
+    TableLibrary* tables;
+    const PretrainedTable* codeTable;   // по какой обученной таблице построен activeCode
+    Common::Algorithm codeAlgorithm;
+    DecodeTableCache* decodeCache;
+    std::shared_ptr<const PrefixCode> cachedCode;
+    const PrefixCode* activeCode;       // code или cachedCode
+};
+
+namespace Codec {
+    // Максимальный размер архива для входа из srcSize байт: заголовок,
+    // 64-битная таблица частот и данные. С точными частотами код Хаффмана
+    // не длиннее 8 бит на символ в среднем; запас в 1/8 покрывает Шеннона-Фано.
+    // indexInterval - шаг индекса произвольного доступа, если он нужен.
+    size_t compressBound(size_t srcSize, size_t indexInterval = 0);
+
+    // Размер распакованных данных по заголовку архива
+    uint64_t decompressedSize(const uint8_t* src, size_t srcSize);
+
+    // Разовые вызовы с временным контекстом
+    size_t compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+    size_t decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+    size_t decodeRange(const uint8_t* src, size_t srcSize, uint64_t offset, uint64_t length, uint8_t* dst,
+                       size_t dstCapacity);
+}
@@ -8,12 +8,32 @@ namespace Common {
     const uint8_t VERSION_1 = 1;
     const uint8_t VERSION_2 = 2;
     const uint8_t VERSION_3 = 3; // Версия для Шеннона-Фано
+    const uint8_t VERSION_4 = 4; // Потоковый формат: последовательность блоков
+    const uint8_t VERSION_5 = 5; // Контейнер из многих файлов с каталогом в конце (container.h)
     
     enum Algorithm : uint8_t {
         ALGO_HUFFMAN = 1,
         ALGO_HUFFMAN_CANONICAL = 2,
-        ALGO_SHANNON_FANO = 3
+        ALGO_SHANNON_FANO = 3,
+        ALGO_TANS = 4,          // Табличная ANS, формат VERSION_2
+        ALGO_RANGE = 5,         // Интервальный кодер с адаптивной моделью, VERSION_2 без таблицы
+        ALGO_ADAPTIVE_HUFFMAN = 6, // Однопроходный адаптивный Хаффман, VERSION_2 без таблицы
+        ALGO_LZ77 = 7,          // LZ77 с кодами Хаффмана, VERSION_2, таблицы внутри данных
+        ALGO_BWT = 8,           // BWT + MTF + серии нулей + Хаффман по блокам, VERSION_2, таблицы внутри данных
+        ALGO_STORED = 9,        // Данные без сжатия, VERSION_2 без таблицы
+        ALGO_UTF8 = 10,         // Хаффман по кодовым точкам UTF-8, VERSION_2, таблица внутри данных
+        ALGO_WORD = 11,         // Хаффман по словам, VERSION_2, словарь и длины кодов внутри данных
+        ALGO_ALPHABETIC = 12    // Алфавитный код Ху-Такера (порядок кодов - порядок байтов), VERSION_2
+    };
+    
+    // Типы блоков потокового формата
+    enum BlockType : uint8_t {
+        BLOCK_END = 0,
+        BLOCK_HUFFMAN = 1,
+        BLOCK_STORED = 2,   // несжатые данные, originalSize == compressedSize
+        BLOCK_REPEAT = 3    // код Хаффмана последнего блока BLOCK_HUFFMAN, без таблицы
     };
     
     const size_t ALPHABET_SIZE = 256;
+    const size_t DEFAULT_BLOCK_SIZE = 1 << 16;
 }
\ No newline at end of file
@@ -2,10 +2,79 @@
 #include "huffman.h"
 #include "shannon_fano.h"
 #include "frequency.h"
+#include "codec.h"
 #include <fstream>
 #include <iostream>
 #include <vector>
 #include <iomanip>
+#include <chrono>
+#include <string>
+
+// Реальное сжатие библиотекой: размер архива и скорость в обе стороны.
+// Для алгоритмов с адаптивной моделью таблица частот не хранится,
+// поэтому их нельзя оценить по таблице, как в разделах выше.
+void measureCodecs(const std::vector<uint8_t>& data) {
+    struct Entry {
+        Common::Algorithm algorithm;
+        const char* name;
+    };
+    const Entry entries[] = {
+        {Common::ALGO_HUFFMAN, "Huffman"},
+        {Common::ALGO_SHANNON_FANO, "ShannonFano"},
+        {Common::ALGO_TANS, "tANS"},
+        {Common::ALGO_RANGE, "Range"},
+        {Common::ALGO_ADAPTIVE_HUFFMAN, "Adaptive"},
+        {Common::ALGO_LZ77, "LZ77"},
+        {Common::ALGO_BWT, "BWT"},
+        {Common::ALGO_UTF8, "UTF-8"},
+        {Common::ALGO_WORD, "Word"},
+        {Common::ALGO_ALPHABETIC, "Alphabetic"},
+    };
+    
+    std::cout << "Library codecs (archive includes header and table):" << std::endl;
+    std::cout << std::string(90, '-') << std::endl;
+    std::cout << std::setw(15) << "Algorithm"
+              << std::setw(15) << "Archive"
+              << std::setw(15) << "Ratio (%)"
+              << std::setw(15) << "Bits/symbol"
+              << std::setw(15) << "Comp MB/s"
+              << std::setw(15) << "Decomp MB/s" << std::endl;
+    std::cout << std::string(90, '-') << std::endl;
+    
+    std::vector<uint8_t> archive(Codec::compressBound(data.size()));
+    std::vector<uint8_t> restored(data.size());
+    double megabytes = data.size() / (1024.0 * 1024.0);
+    
+    for (const Entry& entry : entries) {
+        try {
+            CompressContext compressor(entry.algorithm);
+            DecompressContext decompressor;
+            
+            auto start = std::chrono::steady_clock::now();
+            size_t archiveSize = compressor.compress(data.data(), data.size(), archive.data(), archive.size());
+            auto middle = std::chrono::steady_clock::now();
+            decompressor.decompress(archive.data(), archiveSize, restored.data(), restored.size());
+            auto end = std::chrono::steady_clock::now();
+            
+            if (restored != data) {
+                std::cout << entry.name << " ERROR: round trip mismatch" << std::endl;
+                continue;
+            }
+            
+            double compressSeconds = std::chrono::duration<double>(middle - start).count();
+            double decompressSeconds = std::chrono::duration<double>(end - middle).count();
+            std::cout << std::setw(15) << entry.name
+                      << std::setw(15) << archiveSize
+                      << std::setw(15) << std::fixed << std::setprecision(2) << (archiveSize * 100.0) / data.size()
+                      << std::setw(15) << std::setprecision(3) << (archiveSize * 8.0) / data.size()
+                      << std::setw(15) << std::setprecision(1) << megabytes / compressSeconds
+                      << std::setw(15) << megabytes / decompressSeconds << std::endl;
+        } catch (const std::exception& e) {
+            std::cout << entry.name << " ERROR: " << e.what() << std::endl;
+        }
+    }
+    std::cout << std::endl;
+}
 
 void compareAlgorithms(const std::string& filename) {
     std::ifstream file(filename, std::ios::binary);
@@ -96,6 +165,8 @@ void compareAlgorithms(const std::string& filename) {
         
         std::cout << std::endl;
     }
+    
+    measureCodecs(data);
 }
 
 int main(int argc, char* argv[]) {
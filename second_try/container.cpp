@@ -0,0 +1,372 @@
+#include "container.h"
+#include "archive_format.h"
+#include "frequency.h"
+#include "bitstream.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    struct Crc32Table {
+        uint32_t values[256];
+
+        Crc32Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; bit++) {
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+                }
+                values[i] = crc;
+            }
+        }
+    };
+
+    const Crc32Table CRC32_TABLE;
+
+    // Верхняя граница записи каталога без имени: три байта и пять varint
+    const size_t ENTRY_BOUND = 3 + 5 * 10 + 4 + 10;
+
+    bool supportedAlgorithm(uint8_t algorithm) {
+        return algorithm == Common::ALGO_HUFFMAN || algorithm == Common::ALGO_SHANNON_FANO ||
+               algorithm == Common::ALGO_TANS || algorithm == Common::ALGO_RANGE ||
+               algorithm == Common::ALGO_ADAPTIVE_HUFFMAN || algorithm == Common::ALGO_LZ77 ||
+               algorithm == Common::ALGO_BWT || algorithm == Common::ALGO_STORED ||
+               algorithm == Common::ALGO_UTF8 || algorithm == Common::ALGO_WORD ||
+               algorithm == Common::ALGO_ALPHABETIC;
+    }
+}
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = CRC32_TABLE.values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+ContainerWriter::ContainerWriter(std::ostream& out, Common::Algorithm algorithm)
+    : out(out),
+      algorithm(algorithm),
+      solid(false),
+      finished(false),
+      context(algorithm),
+      groupCounts(Common::ALPHABET_SIZE, 0),
+      groupNormalized(Common::ALPHABET_SIZE, 0),
+      position(0),
+      totalSize(0),
+      sharedTableCount(0) {
+    ArchiveHeader header;
+    header.signature = Common::SIGNATURE;
+    header.version = Common::VERSION_5;
+    header.algorithm = algorithm;
+    header.frequencyBits = 0;
+    header.filter = 0;
+    header.originalSize = 0;
+    header.compressedSize = 0;
+    uint8_t bytes[ArchiveHeader::SIZE];
+    ArchiveWriter::writeHeader(bytes, header);
+    write(bytes, sizeof(bytes));
+}
+
+void ContainerWriter::setSolid(bool enabled) {
+    if (enabled && algorithm != Common::ALGO_HUFFMAN) {
+        throw std::invalid_argument("Solid mode requires Huffman coding");
+    }
+    solid = enabled;
+}
+
+void ContainerWriter::write(const uint8_t* data, size_t size) {
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    if (!out) {
+        throw std::runtime_error("Write error");
+    }
+    position += size;
+}
+
+void ContainerWriter::add(const std::string& name, const uint8_t* data, size_t size) {
+    if (finished) {
+        throw std::logic_error("Container is already finished");
+    }
+    if (name.empty() || !names.emplace(name, directory.size()).second) {
+        throw std::invalid_argument("Entry name is empty or duplicate: " + name);
+    }
+
+    ContainerEntry entry = {name, Common::ALGO_STORED, 0, 0, size, position, 0, position, 0, crc32(data, size)};
+    directory.push_back(entry);
+    totalSize += size;
+    if (solid && size > 0 && size < SOLID_FILE_SIZE) {
+        if (groupData.size() + size > SOLID_GROUP_SIZE) flushGroup();
+        groupData.insert(groupData.end(), data, data + size);
+        groupEntries.push_back(directory.size() - 1);
+        return;
+    }
+    addSingle(directory.back(), data, size);
+}
+
+void ContainerWriter::addSingle(ContainerEntry& entry, const uint8_t* data, size_t size) {
+    entry.tableOffset = position;
+    entry.payloadOffset = position;
+    if (size == 0) return;
+
+    buffer.resize(Codec::compressBound(size));
+    uint64_t payloadSize = 0;
+    size_t bodySize = context.compressBody(data, size, buffer.data(), buffer.size(), payloadSize);
+    entry.algorithm = context.lastStored() ? Common::ALGO_STORED : algorithm;
+    entry.frequencyBits = static_cast<uint8_t>(context.lastFrequencyBits());
+    entry.tableSize = bodySize - payloadSize;
+    entry.payloadOffset = position + entry.tableSize;
+    entry.payloadSize = payloadSize;
+    write(buffer.data(), bodySize);
+}
+
+void ContainerWriter::flushGroup() {
+    if (groupEntries.empty()) return;
+    if (groupEntries.size() == 1) {
+        // Одному файлу общая таблица ничего не даёт
+        addSingle(directory[groupEntries[0]], groupData.data(), groupData.size());
+        groupData.clear();
+        groupEntries.clear();
+        return;
+    }
+
+    std::fill(groupCounts.begin(), groupCounts.end(), 0);
+    for (uint8_t byte : groupData) {
+        groupCounts[byte]++;
+    }
+    int bits = FrequencyAnalyzer::selectTableBits(groupCounts.data(), Common::ALPHABET_SIZE, groupNormalized.data(),
+                                                  groupCode, std::pmr::get_default_resource());
+    uint64_t tableOffset = position;
+    uint64_t tableSize = ArchiveWriter::tableSize(groupNormalized.data(), bits);
+    buffer.resize(std::max<size_t>(tableSize, Codec::compressBound(SOLID_FILE_SIZE)));
+    ArchiveWriter::writeFrequencies(buffer.data(), groupNormalized.data(), bits);
+    write(buffer.data(), tableSize);
+    sharedTableCount++;
+
+    const uint8_t* data = groupData.data();
+    for (size_t index : groupEntries) {
+        ContainerEntry& entry = directory[index];
+        size_t size = entry.originalSize;
+        uint64_t payloadBits = 0;
+        for (size_t i = 0; i < size; i++) {
+            payloadBits += groupCode.code(data[i]).length;
+        }
+        entry.payloadOffset = position;
+        if ((payloadBits + 7) / 8 >= size) {
+            // Общая таблица не подошла этому файлу - храним как есть
+            entry.tableOffset = position;
+            write(data, size);
+            entry.payloadSize = size;
+        } else {
+            BitWriter writer(buffer.data(), buffer.size());
+            groupCode.encode(data, size, writer);
+            writer.flush();
+            entry.algorithm = Common::ALGO_HUFFMAN;
+            entry.frequencyBits = static_cast<uint8_t>(bits);
+            entry.flags = ContainerEntry::SHARED_TABLE;
+            entry.tableOffset = tableOffset;
+            entry.tableSize = tableSize;
+            entry.payloadSize = writer.bytesWritten();
+            write(buffer.data(), writer.bytesWritten());
+        }
+        data += size;
+    }
+    groupData.clear();
+    groupEntries.clear();
+}
+
+void ContainerWriter::finish() {
+    if (finished) return;
+    flushGroup();
+    finished = true;
+
+    uint64_t directoryOffset = position;
+    size_t bound = 10;
+    for (const ContainerEntry& entry : directory) {
+        bound += 10 + entry.name.size() + ENTRY_BOUND;
+    }
+    buffer.resize(bound);
+    size_t size = 0;
+    ArchiveWriter::writeVarint(buffer.data(), bound, size, directory.size());
+    for (const ContainerEntry& entry : directory) {
+        ArchiveWriter::writeVarint(buffer.data(), bound, size, entry.name.size());
+        std::memcpy(buffer.data() + size, entry.name.data(), entry.name.size());
+        size += entry.name.size();
+        buffer[size++] = entry.algorithm;
+        buffer[size++] = entry.frequencyBits;
+        buffer[size++] = entry.flags;
+        ArchiveWriter::writeVarint(buffer.data(), bound, size, entry.originalSize);
+        ArchiveWriter::writeVarint(buffer.data(), bound, size, entry.tableOffset);
+        ArchiveWriter::writeVarint(buffer.data(), bound, size, entry.tableSize);
+        ArchiveWriter::writeVarint(buffer.data(), bound, size, entry.payloadOffset);
+        ArchiveWriter::writeVarint(buffer.data(), bound, size, entry.payloadSize);
+        std::memcpy(buffer.data() + size, &entry.checksum, sizeof(entry.checksum));
+        size += sizeof(entry.checksum);
+    }
+
+    uint8_t trailer[ContainerFormat::TRAILER_SIZE];
+    uint32_t directoryCrc = crc32(buffer.data(), size);
+    std::memcpy(trailer, &directoryOffset, sizeof(directoryOffset));
+    std::memcpy(trailer + 8, &directoryCrc, sizeof(directoryCrc));
+    std::memcpy(trailer + 12, &ContainerFormat::DIRECTORY_SIGNATURE, sizeof(uint32_t));
+    write(buffer.data(), size);
+    write(trailer, sizeof(trailer));
+
+    // Размеры в заголовке - только если поток позволяет вернуться назад
+    std::streampos end = out.tellp();
+    if (end != std::streampos(-1)) {
+        uint64_t dataSize = directoryOffset - ArchiveHeader::SIZE;
+        out.seekp(static_cast<std::streamoff>(end) - static_cast<std::streamoff>(position) + 8);
+        out.write(reinterpret_cast<const char*>(&totalSize), sizeof(totalSize));
+        out.write(reinterpret_cast<const char*>(&dataSize), sizeof(dataSize));
+        out.seekp(end);
+    }
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Write error");
+    }
+}
+
+ContainerReader::ContainerReader(std::istream& in)
+    : in(in), decodeCache(&DecodeTableCache::instance()), sharedTableOffset(UINT64_MAX),
+      freqs(Common::ALPHABET_SIZE, 0) {
+    context.setDecodeCache(decodeCache);
+    in.seekg(0, std::ios::end);
+    std::streamoff fileSize = in.tellg();
+    if (fileSize < 0) {
+        throw std::runtime_error("Container must be a seekable file");
+    }
+    uint64_t size = static_cast<uint64_t>(fileSize);
+    if (size < ArchiveHeader::SIZE + ContainerFormat::TRAILER_SIZE) {
+        throw std::runtime_error("Container is truncated");
+    }
+
+    std::vector<uint8_t> bytes;
+    read(0, ArchiveHeader::SIZE, bytes);
+    archiveHeader = ArchiveWriter::readHeader(bytes.data());
+    if (archiveHeader.signature != Common::SIGNATURE || archiveHeader.version != Common::VERSION_5) {
+        throw std::runtime_error("Not a container archive");
+    }
+
+    read(size - ContainerFormat::TRAILER_SIZE, ContainerFormat::TRAILER_SIZE, bytes);
+    uint64_t directoryOffset;
+    uint32_t directoryCrc;
+    uint32_t signature;
+    std::memcpy(&directoryOffset, bytes.data(), sizeof(directoryOffset));
+    std::memcpy(&directoryCrc, bytes.data() + 8, sizeof(directoryCrc));
+    std::memcpy(&signature, bytes.data() + 12, sizeof(signature));
+    if (signature != ContainerFormat::DIRECTORY_SIGNATURE || directoryOffset < ArchiveHeader::SIZE ||
+        directoryOffset > size - ContainerFormat::TRAILER_SIZE) {
+        throw std::runtime_error("Container directory is missing or corrupted");
+    }
+
+    read(directoryOffset, size - ContainerFormat::TRAILER_SIZE - directoryOffset, bytes);
+    if (crc32(bytes.data(), bytes.size()) != directoryCrc) {
+        throw std::runtime_error("Container directory checksum mismatch");
+    }
+    parseDirectory(bytes, directoryOffset);
+}
+
+void ContainerReader::read(uint64_t offset, uint64_t size, std::vector<uint8_t>& dst) {
+    dst.resize(size);
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(offset));
+    in.read(reinterpret_cast<char*>(dst.data()), static_cast<std::streamsize>(size));
+    if (static_cast<uint64_t>(in.gcount()) != size) {
+        throw std::runtime_error("Container is truncated");
+    }
+}
+
+void ContainerReader::parseDirectory(const std::vector<uint8_t>& data, uint64_t directoryOffset) {
+    const uint8_t* src = data.data();
+    size_t size = data.size();
+    size_t offset = 0;
+    uint64_t count = ArchiveWriter::readVarint(src, size, offset);
+    if (count > size) {
+        throw std::runtime_error("Container directory is corrupted");
+    }
+    directory.reserve(count);
+
+    // Таблица и данные должны лежать между заголовком и каталогом
+    auto inside = [directoryOffset](uint64_t start, uint64_t length) {
+        return start >= ArchiveHeader::SIZE && start <= directoryOffset && length <= directoryOffset - start;
+    };
+    for (uint64_t i = 0; i < count; i++) {
+        ContainerEntry entry;
+        uint64_t nameLength = ArchiveWriter::readVarint(src, size, offset);
+        if (nameLength > size - offset || size - offset - nameLength < 3) {
+            throw std::runtime_error("Container directory is corrupted");
+        }
+        entry.name.assign(reinterpret_cast<const char*>(src + offset), nameLength);
+        offset += nameLength;
+        entry.algorithm = src[offset++];
+        entry.frequencyBits = src[offset++];
+        entry.flags = src[offset++];
+        entry.originalSize = ArchiveWriter::readVarint(src, size, offset);
+        entry.tableOffset = ArchiveWriter::readVarint(src, size, offset);
+        entry.tableSize = ArchiveWriter::readVarint(src, size, offset);
+        entry.payloadOffset = ArchiveWriter::readVarint(src, size, offset);
+        entry.payloadSize = ArchiveWriter::readVarint(src, size, offset);
+        if (size - offset < sizeof(entry.checksum)) {
+            throw std::runtime_error("Container directory is corrupted");
+        }
+        std::memcpy(&entry.checksum, src + offset, sizeof(entry.checksum));
+        offset += sizeof(entry.checksum);
+
+        bool valid = supportedAlgorithm(entry.algorithm) && inside(entry.tableOffset, entry.tableSize) &&
+                     inside(entry.payloadOffset, entry.payloadSize) &&
+                     (entry.sharedTable() ? entry.algorithm == Common::ALGO_HUFFMAN
+                                          : entry.tableOffset + entry.tableSize == entry.payloadOffset);
+        if (!valid || !names.emplace(entry.name, directory.size()).second) {
+            throw std::runtime_error("Container entry is corrupted: " + entry.name);
+        }
+        directory.push_back(std::move(entry));
+    }
+    if (offset != size) {
+        throw std::runtime_error("Container directory is corrupted");
+    }
+}
+
+size_t ContainerReader::find(const std::string& name) const {
+    auto it = names.find(name);
+    return it == names.end() ? directory.size() : it->second;
+}
+
+void ContainerReader::setDecodeCache(DecodeTableCache* cache) {
+    decodeCache = cache;
+    context.setDecodeCache(cache);
+    sharedCode.reset();
+    sharedTableOffset = UINT64_MAX;
+}
+
+void ContainerReader::extract(size_t index, uint8_t* dst) {
+    const ContainerEntry& entry = directory.at(index);
+    if (entry.sharedTable()) {
+        if (sharedTableOffset != entry.tableOffset) {
+            sharedTableOffset = UINT64_MAX;
+            read(entry.tableOffset, entry.tableSize, table);
+            size_t tableSize = ArchiveWriter::readFrequencies(table.data(), table.size(), entry.frequencyBits,
+                                                              freqs.data());
+            if (tableSize != entry.tableSize) {
+                throw std::runtime_error("Container entry is corrupted: " + entry.name);
+            }
+            if (decodeCache) {
+                sharedCode = decodeCache->acquire(Common::ALGO_HUFFMAN, freqs.data());
+            } else {
+                auto code = std::make_shared<PrefixCode>();
+                code->buildHuffman(freqs.data(), Common::ALPHABET_SIZE);
+                sharedCode = code;
+            }
+            sharedTableOffset = entry.tableOffset;
+        }
+        read(entry.payloadOffset, entry.payloadSize, body);
+        BitReader reader(body.data(), body.size());
+        sharedCode->decode(reader, dst, entry.originalSize);
+    } else {
+        read(entry.tableOffset, entry.tableSize + entry.payloadSize, body);
+        context.decompressBody(static_cast<Common::Algorithm>(entry.algorithm), entry.frequencyBits, body.data(),
+                               entry.tableSize, entry.payloadSize, dst, entry.originalSize);
+    }
+    if (crc32(dst, entry.originalSize) != entry.checksum) {
+        throw std::runtime_error("Checksum mismatch in entry: " + entry.name);
+    }
+}
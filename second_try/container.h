@@ -0,0 +1,135 @@
+// container.h - контейнер из многих файлов с центральным каталогом
+#pragma once
+#include "common.h"
+#include "codec.h"
+#include "prefix_code.h"
+#include "decode_cache.h"
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// CRC-32 (многочлен 0xEDB88320, как в zip и gzip); crc - значение по
+// предыдущей части данных для подсчёта порциями
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+// Элемент каталога. Смещения - от начала файла контейнера
+struct ContainerEntry {
+    static const uint8_t SHARED_TABLE = 0x01;   // таблица общая для группы файлов
+
+    std::string name;
+    uint8_t algorithm;       // Common::Algorithm, ALGO_STORED - без сжатия
+    uint8_t frequencyBits;   // формат таблицы (ArchiveWriter::readTableSize)
+    uint8_t flags;
+    uint64_t originalSize;
+    uint64_t tableOffset;
+    uint64_t tableSize;      // 0 - таблицы нет или она внутри данных
+    uint64_t payloadOffset;
+    uint64_t payloadSize;
+    uint32_t checksum;       // crc32 несжатых данных
+
+    bool sharedTable() const { return (flags & SHARED_TABLE) != 0; }
+};
+
+// Контейнер (VERSION_5): заголовок архива, тела файлов, каталог и хвост.
+// В заголовке algorithm - алгоритм по умолчанию, originalSize - сумма
+// размеров файлов, compressedSize - число байт между заголовком и
+// каталогом (0, если выход не позволял вернуться и дописать заголовок).
+// Тело файла - таблица частот и данные без своего заголовка, как у блока
+// потокового формата. Каталог: varint числа элементов, затем для каждого
+// varint длины имени и имя, байты algorithm, frequencyBits, flags, varint
+// originalSize, tableOffset, tableSize, payloadOffset, payloadSize и
+// uint32 checksum. Хвост (TRAILER_SIZE байт): uint64 смещение каталога,
+// uint32 crc32 каталога и сигнатура "HDIR". Список файлов читается по
+// хвосту и каталогу, не касаясь данных; файл извлекается по смещениям.
+namespace ContainerFormat {
+    const uint32_t DIRECTORY_SIGNATURE = 0x52494448; // "HDIR" в little-endian
+    const size_t TRAILER_SIZE = 16;
+}
+
+// Пишет контейнер в поток по мере добавления файлов. В сплошном режиме
+// (только ALGO_HUFFMAN) файлы меньше SOLID_FILE_SIZE собираются в группы
+// до SOLID_GROUP_SIZE байт с одной таблицей на группу; каждый файл группы
+// кодируется с границы байта и по-прежнему извлекается отдельно.
+class ContainerWriter {
+public:
+    static const size_t SOLID_FILE_SIZE = 64 * 1024;
+    static const size_t SOLID_GROUP_SIZE = 1 << 20;
+
+    explicit ContainerWriter(std::ostream& out, Common::Algorithm algorithm = Common::ALGO_HUFFMAN);
+
+    // std::invalid_argument, если алгоритм не ALGO_HUFFMAN
+    void setSolid(bool enabled);
+
+    // Имена уникальны и непусты (иначе std::invalid_argument)
+    void add(const std::string& name, const uint8_t* data, size_t size);
+    // Дописывает отложенную группу, каталог и хвост; для потока с
+    // произвольным доступом исправляет размеры в заголовке
+    void finish();
+
+    const std::vector<ContainerEntry>& entries() const { return directory; }
+    uint64_t bytesWritten() const { return position; }
+    uint64_t sharedTables() const { return sharedTableCount; }
+
+private:
+    void write(const uint8_t* data, size_t size);
+    void addSingle(ContainerEntry& entry, const uint8_t* data, size_t size);
+    void flushGroup();
+
+    std::ostream& out;
+    Common::Algorithm algorithm;
+    bool solid;
+    bool finished;
+    CompressContext context;
+    PrefixCode groupCode;
+    std::vector<uint64_t> groupCounts;
+    std::vector<uint64_t> groupNormalized;
+    std::vector<uint8_t> groupData;
+    std::vector<size_t> groupEntries;   // номера элементов каталога в группе
+    std::vector<uint8_t> buffer;
+    std::vector<ContainerEntry> directory;
+    std::unordered_map<std::string, size_t> names;
+    uint64_t position;
+    uint64_t totalSize;
+    uint64_t sharedTableCount;
+};
+
+// Читает каталог контейнера из потока с произвольным доступом. Извлечение
+// файла читает только его таблицу и данные. Коды берутся из общего кэша
+// процесса (DecodeTableCache::instance()): одинаковые таблицы в разных
+// файлах и контейнерах пакетного восстановления строятся один раз.
+// Испорченный контейнер - std::runtime_error
+class ContainerReader {
+public:
+    explicit ContainerReader(std::istream& in);
+
+    const ArchiveHeader& header() const { return archiveHeader; }
+    const std::vector<ContainerEntry>& entries() const { return directory; }
+    // Номер элемента с именем name; entries().size(), если такого нет
+    size_t find(const std::string& name) const;
+
+    // Распаковывает элемент index в dst (originalSize байт) и сверяет crc32
+    void extract(size_t index, uint8_t* dst);
+
+    // Другой кэш кодов; nullptr - строить код для каждого файла
+    void setDecodeCache(DecodeTableCache* cache);
+
+private:
+    void read(uint64_t offset, uint64_t size, std::vector<uint8_t>& dst);
+    void parseDirectory(const std::vector<uint8_t>& data, uint64_t directoryOffset);
+
+    std::istream& in;
+    ArchiveHeader archiveHeader;
+    std::vector<ContainerEntry> directory;
+    std::unordered_map<std::string, size_t> names;
+    DecompressContext context;
+    DecodeTableCache* decodeCache;
+    std::shared_ptr<const PrefixCode> sharedCode;
+    uint64_t sharedTableOffset;   // таблица, по которой получен sharedCode
+    std::vector<uint64_t> freqs;
+    std::vector<uint8_t> table;
+    std::vector<uint8_t> body;
+};
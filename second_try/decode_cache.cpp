@@ -0,0 +1,107 @@
+#include "decode_cache.h"
+#include <algorithm>
+#include <stdexcept>
+
+DecodeTableCache::DecodeTableCache(size_t capacity) : limit(capacity), hits(0), misses(0), evictions(0) {}
+
+DecodeTableCache& DecodeTableCache::instance() {
+    static DecodeTableCache cache;
+    return cache;
+}
+
+uint64_t DecodeTableCache::hash(Common::Algorithm algorithm, const uint64_t* freqs) {
+    // FNV-1a по 64-битным словам с перемешиванием в конце
+    uint64_t h = 0xcbf29ce484222325ULL ^ algorithm;
+    for (size_t i = 0; i < Common::ALPHABET_SIZE; i++) {
+        h = (h ^ freqs[i]) * 0x100000001b3ULL;
+    }
+    h ^= h >> 29;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    return h ^ (h >> 32);
+}
+
+DecodeTableCache::EntryList::iterator DecodeTableCache::find(uint64_t key, Common::Algorithm algorithm,
+                                                             const uint64_t* freqs) {
+    auto range = index.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        const Entry& entry = *it->second;
+        if (entry.algorithm == algorithm && std::equal(entry.freqs.begin(), entry.freqs.end(), freqs)) {
+            return it->second;
+        }
+    }
+    return entries.end();
+}
+
+void DecodeTableCache::trim() {
+    while (entries.size() > limit) {
+        const Entry& oldest = entries.back();
+        auto range = index.equal_range(oldest.key);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (&*it->second == &oldest) {
+                index.erase(it);
+                break;
+            }
+        }
+        entries.pop_back();
+        evictions++;
+    }
+}
+
+std::shared_ptr<const PrefixCode> DecodeTableCache::acquire(Common::Algorithm algorithm, const uint64_t* freqs) {
+    if (algorithm != Common::ALGO_HUFFMAN && algorithm != Common::ALGO_SHANNON_FANO &&
+        algorithm != Common::ALGO_ALPHABETIC) {
+        throw std::invalid_argument("Decode cache holds only Huffman, Shannon-Fano and alphabetic codes");
+    }
+    uint64_t key = hash(algorithm, freqs);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = find(key, algorithm, freqs);
+        if (found != entries.end()) {
+            hits++;
+            entries.splice(entries.begin(), entries, found);
+            return found->code;
+        }
+        misses++;
+    }
+
+    auto code = std::make_shared<PrefixCode>();
+    if (algorithm == Common::ALGO_HUFFMAN) {
+        code->buildHuffman(freqs, Common::ALPHABET_SIZE);
+    } else if (algorithm == Common::ALGO_ALPHABETIC) {
+        code->buildAlphabetic(freqs, Common::ALPHABET_SIZE);
+    } else {
+        code->buildShannonFano(freqs, Common::ALPHABET_SIZE);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // Пока код строился, его мог добавить другой поток
+    auto found = find(key, algorithm, freqs);
+    if (found != entries.end()) {
+        entries.splice(entries.begin(), entries, found);
+        return found->code;
+    }
+    if (limit == 0) {
+        return code;
+    }
+    entries.push_front({key, algorithm, std::vector<uint64_t>(freqs, freqs + Common::ALPHABET_SIZE), code});
+    index.emplace(key, entries.begin());
+    trim();
+    return code;
+}
+
+void DecodeTableCache::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex);
+    limit = capacity;
+    trim();
+}
+
+void DecodeTableCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    index.clear();
+    entries.clear();
+}
+
+DecodeTableCache::Stats DecodeTableCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return {hits, misses, evictions, entries.size(), limit};
+}
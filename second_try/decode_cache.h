@@ -0,0 +1,71 @@
+// decode_cache.h - общий кэш построенных кодов распаковки
+#pragma once
+#include "common.h"
+#include "prefix_code.h"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Кэш кодов Хаффмана, Шеннона-Фано и алфавитных вместе с таблицами декодирования.
+// Архивы одного источника часто несут одну и ту же таблицу частот, а
+// построение кода для короткого архива дороже самого декодирования.
+// Ключ - алгоритм и таблица в том виде, в каком она записана в архиве
+// (кодер уже нормировал её); сравниваются хэш и затем сама таблица.
+// Вытесняется давно не использованный код, когда их больше capacity
+// (код с таблицами декодирования занимает порядка 20 КБ).
+// Все методы потокобезопасны; коды неизменяемы, и выданный код живёт,
+// пока на него есть ссылка, даже после вытеснения.
+class DecodeTableCache {
+public:
+    static const size_t DEFAULT_CAPACITY = 256;
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        size_t entries;
+        size_t capacity;
+    };
+
+    explicit DecodeTableCache(size_t capacity = DEFAULT_CAPACITY);
+
+    // Кэш на весь процесс
+    static DecodeTableCache& instance();
+
+    // Код для таблицы freqs (ALPHABET_SIZE значений); algorithm -
+    // ALGO_HUFFMAN, ALGO_SHANNON_FANO или ALGO_ALPHABETIC (иначе std::invalid_argument).
+    // Промах строит код вне блокировки: другие потоки в это время не ждут
+    std::shared_ptr<const PrefixCode> acquire(Common::Algorithm algorithm, const uint64_t* freqs);
+
+    // 0 - коды не хранятся, каждый запрос - промах
+    void setCapacity(size_t capacity);
+    void clear();
+    Stats stats() const;
+
+    static uint64_t hash(Common::Algorithm algorithm, const uint64_t* freqs);
+
+private:
+    struct Entry {
+        uint64_t key;
+        Common::Algorithm algorithm;
+        std::vector<uint64_t> freqs;
+        std::shared_ptr<const PrefixCode> code;
+    };
+    using EntryList = std::list<Entry>;
+
+    // Вызываются под mutex
+    EntryList::iterator find(uint64_t key, Common::Algorithm algorithm, const uint64_t* freqs);
+    void trim();
+
+    mutable std::mutex mutex;
+    size_t limit;
+    EntryList entries;   // в начале - последний использованный
+    std::unordered_multimap<uint64_t, EntryList::iterator> index;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+};
@@ -1,93 +1,330 @@
 #include "common.h"
-#include "huffman.h"
-#include "shannon_fano.h"
+#include "codec.h"
 #include "archive_format.h"
+#include "mapped_output.h"
+#include "stream.h"
+#include "adaptive_huffman.h"
 #include "bitstream.h"
+#include "filter.h"
+#include "table_library.h"
 #include <fstream>
 #include <iostream>
 #include <vector>
 #include <sstream>
 #include <string>
 #include <stdexcept>
+#include <cerrno>
+#include <unistd.h>
+
+// Буфер чтения стандартного входа: каждый underflow - один вызов read(),
+// поэтому доступные данные отдаются сразу, без ожидания заполнения буфера.
+class FdInputBuffer : public std::streambuf {
+public:
+    explicit FdInputBuffer(int fd) : fd(fd), buffer(Common::DEFAULT_BLOCK_SIZE) {}
+    
+protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+        ssize_t n;
+        do {
+            n = read(fd, buffer.data(), buffer.size());
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) return traits_type::eof();
+        setg(buffer.data(), buffer.data(), buffer.data() + n);
+        return traits_type::to_int_type(*gptr());
+    }
+    
+private:
+    int fd;
+    std::vector<char> buffer;
+};
+
+// Читает то, что уже доступно (но хотя бы один байт, если поток не закончился)
+static size_t readAvailable(std::istream& in, char* dst, size_t capacity) {
+    std::streambuf* buf = in.rdbuf();
+    std::streamsize avail = buf->in_avail();
+    if (avail <= 0) {
+        if (std::streambuf::traits_type::eq_int_type(buf->sgetc(), std::streambuf::traits_type::eof())) {
+            return 0;
+        }
+        avail = buf->in_avail();
+    }
+    return static_cast<size_t>(buf->sgetn(dst, std::min(static_cast<std::streamsize>(capacity), avail)));
+}
+
+// Обученные таблицы для архивов encoder --table (каталог - ключ --tables)
+static TableLibrary* pretrainedTables = nullptr;
+
+// '-' в качестве выходного файла - стандартный вывод; отчёт тогда идёт в stderr
+static std::string outputPath(const std::string& outputFile) {
+    return outputFile == "-" ? "/dev/stdout" : outputFile;
+}
+
+static std::ostream& report(const std::string& outputFile) {
+    return outputFile == "-" ? std::cerr : std::cout;
+}
 
 void decodeVersion1(std::istream& in, const std::string& outputFile) {
     std::cerr << "Version 1 format not supported in this implementation" << std::endl;
     throw std::runtime_error("Unsupported version");
 }
 
-void decodeVersion2Huffman(std::istream& in, const ArchiveHeader& header, const std::string& outputFile) {
-    auto freqs = ArchiveWriter::readFrequencies(in, header.frequencyBits);
-    HuffmanDecoder decoder(freqs);
+// Архив целиком в памяти: заголовок (уже прочитан) и остаток потока
+static std::vector<uint8_t> readArchive(std::istream& in, const ArchiveHeader& header) {
+    std::vector<uint8_t> archive(ArchiveHeader::SIZE);
+    ArchiveWriter::writeHeader(archive.data(), header);
+    archive.insert(archive.end(), std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return archive;
+}
+
+// Фильтр обращается по всему результату, поэтому однопроходные режимы
+// (адаптивный Хаффман, копирование несжатых данных) уступают общему пути
+static void decodeFiltered(std::istream& in, const ArchiveHeader& header, const std::string& outputFile) {
+    std::vector<uint8_t> archive = readArchive(in, header);
     
-    std::stringstream compressedStream;
-    char buffer[4096];
-    uint64_t remaining = header.compressedSize;
+    MappedOutput output(outputPath(outputFile), header.originalSize);
+    DecompressContext context;
+    context.decompress(archive.data(), archive.size(), output.data(), output.size());
+    output.commit();
     
-    while (remaining > 0 && in.read(buffer, std::min(sizeof(buffer), static_cast<size_t>(remaining)))) {
-        size_t read = in.gcount();
-        compressedStream.write(buffer, read);
-        remaining -= read;
+    report(outputFile) << "Decompression completed (filter " << DataFilter::name(header.filter) << "): "
+                       << header.originalSize << " bytes written" << std::endl;
+}
+
+// Алгоритмы VERSION_2, которые распаковывает DecompressContext, и их
+// названия для отчёта; nullptr - алгоритм не поддерживается
+static const char* libraryAlgorithmName(uint8_t algorithm) {
+    switch (algorithm) {
+        case Common::ALGO_HUFFMAN: return "Huffman";
+        case Common::ALGO_TANS: return "tANS";
+        case Common::ALGO_RANGE: return "Range";
+        case Common::ALGO_LZ77: return "LZ77";
+        case Common::ALGO_BWT: return "BWT";
+        case Common::ALGO_UTF8: return "UTF-8";
+        case Common::ALGO_WORD: return "Word";
+        case Common::ALGO_ALPHABETIC: return "Alphabetic";
+        default: return nullptr;
     }
+}
+
+// Размер результата известен из заголовка: декодируем прямо в выходной файл
+// (блоки BWT - параллельно, каждый в свою область отображения)
+void decodeVersion2Library(std::istream& in, const ArchiveHeader& header, const std::string& outputFile) {
+    std::vector<uint8_t> archive = readArchive(in, header);
     
-    compressedStream.seekg(0);
-    BitInputStream bitIn(compressedStream);
-    
-    auto decodedData = decoder.decodeData(bitIn, header.originalSize);
+    MappedOutput output(outputPath(outputFile), header.originalSize);
+    DecompressContext context;
+    context.setTableLibrary(pretrainedTables);
+    context.decompress(archive.data(), archive.size(), output.data(), output.size());
+    output.commit();
     
-    std::ofstream output(outputFile, std::ios::binary);
-    if (!output) {
-        std::cerr << "Cannot create output file: " << outputFile << std::endl;
+    report(outputFile) << libraryAlgorithmName(header.algorithm) << " decompression completed: "
+                       << header.originalSize << " bytes written" << std::endl;
+}
+
+// Несжатые данные копируются из входа прямо в выходной файл
+void decodeVersion2Stored(std::istream& in, const ArchiveHeader& header, const std::string& outputFile) {
+    if (header.filter != 0) {
+        decodeFiltered(in, header, outputFile);
         return;
     }
+    if (header.compressedSize != header.originalSize) {
+        throw std::runtime_error("Corrupted stored archive: size mismatch");
+    }
     
-    output.write(reinterpret_cast<const char*>(decodedData.data()), decodedData.size());
-    output.close();
+    MappedOutput output(outputPath(outputFile), header.originalSize);
+    in.read(reinterpret_cast<char*>(output.data()), static_cast<std::streamsize>(header.originalSize));
+    if (static_cast<uint64_t>(in.gcount()) != header.originalSize) {
+        throw std::runtime_error("Archive is truncated");
+    }
+    output.commit();
     
-    std::cout << "Huffman decompression completed: " << decodedData.size() << " bytes written" << std::endl;
+    report(outputFile) << "Stored data copied: " << header.originalSize << " bytes written" << std::endl;
 }
 
-void decodeVersion3ShannonFano(std::istream& in, const ArchiveHeader& header, const std::string& outputFile) {
-    auto freqs = ArchiveWriter::readFrequencies(in, header.frequencyBits);
-    ShannonFanoDecoder decoder(freqs);
+// Адаптивный Хаффман декодируется за один проход прямо из входного потока:
+// архив, записанный в канал, не содержит размеров, конец данных отмечен маркером
+void decodeVersion2AdaptiveHuffman(std::istream& in, const ArchiveHeader& header, const std::string& outputFile) {
+    if (header.filter != 0) {
+        decodeFiltered(in, header, outputFile);
+        return;
+    }
+    std::ofstream file;
+    bool toStdout = outputFile == "-";
+    if (!toStdout) {
+        file.open(outputFile, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot create output file: " + outputFile);
+        }
+    }
+    std::ostream& output = toStdout ? std::cout : file;
     
-    std::stringstream compressedStream;
-    char buffer[4096];
-    uint64_t remaining = header.compressedSize;
+    const std::streamsize SYMBOL_MARGIN = AdaptiveHuffman::MAX_CODE_BYTES;
+    BitInputStream bits(in);
+    AdaptiveHuffman model;
+    std::vector<uint8_t> outBuf(Common::DEFAULT_BLOCK_SIZE);
+    size_t pending = 0;
+    uint64_t total = 0;
     
-    while (remaining > 0 && in.read(buffer, std::min(sizeof(buffer), static_cast<size_t>(remaining)))) {
-        size_t read = in.gcount();
-        compressedStream.write(buffer, read);
-        remaining -= read;
+    for (;;) {
+        // Если во входном буфере меньше, чем может занять код символа, его
+        // декодирование может ждать данных: сначала отдаём уже декодированное
+        if (pending == outBuf.size() || (pending > 0 && in.rdbuf()->in_avail() < SYMBOL_MARGIN)) {
+            output.write(reinterpret_cast<const char*>(outBuf.data()), pending);
+            output.flush();
+            pending = 0;
+        }
+        uint32_t symbol = model.decodeSymbol(bits);
+        if (bits.eof()) {
+            throw std::runtime_error("Unexpected end of stream");
+        }
+        if (symbol == AdaptiveHuffman::END_OF_STREAM) break;
+        outBuf[pending++] = static_cast<uint8_t>(symbol);
+        total++;
     }
+    output.write(reinterpret_cast<const char*>(outBuf.data()), pending);
+    output.flush();
     
-    compressedStream.seekg(0);
-    BitInputStream bitIn(compressedStream);
+    if (header.compressedSize != 0 && total != header.originalSize) {
+        throw std::runtime_error("Decoded size does not match header");
+    }
+    report(outputFile) << "Adaptive Huffman decompression completed: " << total << " bytes written" << std::endl;
+}
+
+void decodeVersion3ShannonFano(std::istream& in, const ArchiveHeader& header, const std::string& outputFile) {
+    std::vector<uint8_t> archive = readArchive(in, header);
     
-    auto decodedData = decoder.decodeData(bitIn, header.originalSize);
+    MappedOutput output(outputPath(outputFile), header.originalSize);
+    DecompressContext context;
+    context.setTableLibrary(pretrainedTables);
+    context.decompress(archive.data(), archive.size(), output.data(), output.size());
+    output.commit();
     
-    std::ofstream output(outputFile, std::ios::binary);
-    if (!output) {
-        std::cerr << "Cannot create output file: " << outputFile << std::endl;
-        return;
+    report(outputFile) << "Shannon-Fano decompression completed: " << header.originalSize << " bytes written" << std::endl;
+}
+
+void decodeVersion4Stream(std::istream& in, const ArchiveHeader& header, const std::string& outputFile) {
+    std::ofstream file;
+    bool toStdout = outputFile == "-";
+    if (!toStdout) {
+        file.open(outputFile, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot create output file: " + outputFile);
+        }
     }
+    std::ostream& output = toStdout ? std::cout : file;
     
-    output.write(reinterpret_cast<const char*>(decodedData.data()), decodedData.size());
-    output.close();
+    StreamDecompressor decompressor(header);
+    std::vector<char> inBuf(Common::DEFAULT_BLOCK_SIZE);
+    std::vector<uint8_t> outBuf(Common::DEFAULT_BLOCK_SIZE);
+    StreamBuffers strm;
     
-    std::cout << "Shannon-Fano decompression completed: " << decodedData.size() << " bytes written" << std::endl;
+    while (!decompressor.finished()) {
+        size_t n = readAvailable(in, inBuf.data(), inBuf.size());
+        if (n == 0) {
+            throw std::runtime_error("Unexpected end of stream");
+        }
+        strm.nextIn = reinterpret_cast<const uint8_t*>(inBuf.data());
+        strm.availIn = n;
+        
+        bool done;
+        do {
+            strm.nextOut = outBuf.data();
+            strm.availOut = outBuf.size();
+            done = decompressor.decompress(strm);
+            output.write(reinterpret_cast<const char*>(outBuf.data()), outBuf.size() - strm.availOut);
+        } while (!done && strm.availOut == 0);
+        // Отдаём получателю всё, что уже декодировано
+        output.flush();
+    }
+    
+    report(outputFile) << "Stream decompression completed: " << strm.totalOut << " bytes written" << std::endl;
 }
 
-int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <input archive> <output file>" << std::endl;
+// Диапазон несжатых данных. Архив отображается в память: если в нём есть
+// индекс, читаются только таблица, индекс и данные рядом с диапазоном
+int decodeRange(const std::string& inputFile, uint64_t offset, uint64_t length, const std::string& outputFile) {
+    try {
+        MappedInput archive(inputFile == "-" ? "/dev/stdin" : inputFile);
+        uint64_t originalSize = Codec::decompressedSize(archive.data(), archive.size());
+        if (offset > originalSize) {
+            std::cerr << "Range starts past the end of data (" << originalSize << " bytes)" << std::endl;
+            return 1;
+        }
+        length = std::min(length, originalSize - offset);
+        
+        MappedOutput output(outputPath(outputFile), length);
+        DecompressContext context;
+        context.setTableLibrary(pretrainedTables);
+        context.decodeRange(archive.data(), archive.size(), offset, length, output.data(), output.size());
+        output.commit();
+        
+        report(outputFile) << "Range decompression completed: " << length << " bytes from offset " << offset
+                           << " written" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Decompression error: " << e.what() << std::endl;
         return 1;
     }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    // Необязательные ключи: только диапазон несжатых данных, каталог таблиц
+    bool range = false;
+    std::string tableDirectory = ".";
+    uint64_t rangeOffset = 0;
+    uint64_t rangeLength = 0;
+    int arg = 1;
+    while (arg < argc && std::string(argv[arg]).rfind("--", 0) == 0) {
+        std::string option = argv[arg];
+        if (option == "--range" && arg + 2 < argc) {
+            try {
+                rangeOffset = std::stoull(argv[arg + 1]);
+                rangeLength = std::stoull(argv[arg + 2]);
+            } catch (const std::exception&) {
+                std::cerr << "Invalid range: " << argv[arg + 1] << " " << argv[arg + 2] << std::endl;
+                return 1;
+            }
+            range = true;
+            arg += 3;
+        } else if (option == "--tables" && arg + 1 < argc) {
+            tableDirectory = argv[arg + 1];
+            arg += 2;
+        } else {
+            std::cerr << "Unknown option: " << option << std::endl;
+            return 1;
+        }
+    }
     
-    std::ifstream input(argv[1], std::ios::binary);
-    if (!input) {
-        std::cerr << "Cannot open input archive: " << argv[1] << std::endl;
+    if (argc - arg != 2) {
+        std::cerr << "Usage: " << argv[0] << " [--range OFFSET LENGTH] [--tables DIR] <input archive|-> <output file|->"
+                  << std::endl;
+        std::cerr << "  --range OFFSET LENGTH extracts LENGTH bytes starting at OFFSET; archives written" << std::endl;
+        std::cerr << "    with encoder --index are decoded from the nearest checkpoint" << std::endl;
+        std::cerr << "  --tables DIR: where pretrained tables of encoder --table archives live (.)" << std::endl;
         return 1;
     }
+    std::string inputFile = argv[arg];
+    std::string outputFile = argv[arg + 1];
+    TableLibrary library(tableDirectory);
+    pretrainedTables = &library;
+    if (range) {
+        return decodeRange(inputFile, rangeOffset, rangeLength, outputFile);
+    }
+    
+    // '-' - стандартный вход/выход
+    FdInputBuffer stdinBuffer(STDIN_FILENO);
+    std::istream stdinStream(&stdinBuffer);
+    std::ifstream file;
+    bool fromStdin = inputFile == "-";
+    if (!fromStdin) {
+        file.open(inputFile, std::ios::binary);
+        if (!file) {
+            std::cerr << "Cannot open input archive: " << inputFile << std::endl;
+            return 1;
+        }
+    }
+    std::istream& input = fromStdin ? stdinStream : file;
     
     try {
         ArchiveHeader header = ArchiveWriter::readHeader(input);
@@ -99,11 +336,15 @@ int main(int argc, char* argv[]) {
         
         switch (header.version) {
             case Common::VERSION_1:
-                decodeVersion1(input, argv[2]);
+                decodeVersion1(input, outputFile);
                 break;
             case Common::VERSION_2:
-                if (header.algorithm == Common::ALGO_HUFFMAN) {
-                    decodeVersion2Huffman(input, header, argv[2]);
+                if (header.algorithm == Common::ALGO_ADAPTIVE_HUFFMAN) {
+                    decodeVersion2AdaptiveHuffman(input, header, outputFile);
+                } else if (header.algorithm == Common::ALGO_STORED) {
+                    decodeVersion2Stored(input, header, outputFile);
+                } else if (libraryAlgorithmName(header.algorithm)) {
+                    decodeVersion2Library(input, header, outputFile);
                 } else {
                     std::cerr << "Unsupported algorithm for version 2: " << static_cast<int>(header.algorithm) << std::endl;
                     return 1;
@@ -111,12 +352,18 @@ int main(int argc, char* argv[]) {
                 break;
             case Common::VERSION_3:
                 if (header.algorithm == Common::ALGO_SHANNON_FANO) {
-                    decodeVersion3ShannonFano(input, header, argv[2]);
+                    decodeVersion3ShannonFano(input, header, outputFile);
                 } else {
                     std::cerr << "Unsupported algorithm for version 3: " << static_cast<int>(header.algorithm) << std::endl;
                     return 1;
                 }
                 break;
+            case Common::VERSION_4:
+                decodeVersion4Stream(input, header, outputFile);
+                break;
+            case Common::VERSION_5:
+                std::cerr << "Multi-file container: use 'archiver list' and 'archiver extract'" << std::endl;
+                return 1;
             default:
                 std::cerr << "Unsupported version: " << static_cast<int>(header.version) << std::endl;
                 return 1;
@@ -127,6 +374,5 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    input.close();
     return 0;
 }
\ No newline at end of file
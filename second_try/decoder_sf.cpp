@@ -2,6 +2,7 @@
 #include "shannon_fano.h"
 #include "archive_format.h"
 #include "bitstream.h"
+#include "mapped_output.h"
 #include <fstream>
 #include <iostream>
 #include <vector>
@@ -26,18 +27,12 @@ void decodeShannonFano(std::istream& in, const ArchiveHeader& header, const std:
     compressedStream.seekg(0);
     BitInputStream bitIn(compressedStream);
     
-    auto decodedData = decoder.decodeData(bitIn, header.originalSize);
+    // Размер результата известен из заголовка: декодируем прямо в выходной файл
+    MappedOutput output(outputFile, header.originalSize);
+    decoder.decodeData(bitIn, output.region(0, header.originalSize), header.originalSize);
+    output.commit();
     
-    std::ofstream output(outputFile, std::ios::binary);
-    if (!output) {
-        std::cerr << "Cannot create output file: " << outputFile << std::endl;
-        return;
-    }
-    
-    output.write(reinterpret_cast<const char*>(decodedData.data()), decodedData.size());
-    output.close();
-    
-    std::cout << "Shannon-Fano decompression completed: " << decodedData.size() << " bytes written" << std::endl;
+    std::cout << "Shannon-Fano decompression completed: " << header.originalSize << " bytes written" << std::endl;
 }
 
 int main(int argc, char* argv[]) {
@@ -1,24 +1,425 @@
 #include "common.h"
-#include "huffman.h"
+#include "codec.h"
 #include "archive_format.h"
-#include "frequency.h"
+#include "stream.h"
+#include "table_library.h"
+#include "adaptive_huffman.h"
 #include "bitstream.h"
 #include <fstream>
 #include <iostream>
 #include <vector>
+#include <chrono>
 #include <sstream>
 #include <string>
+#include <stdexcept>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+// Есть ли на дескрипторе данные, которые можно прочитать без ожидания
+static bool inputReady(int fd) {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    return poll(&pfd, 1, 0) > 0;
+}
+
+// Накопленный вход, который делится на блоки по стоимости (--split)
+static const size_t SPLIT_CHUNK_SIZE = 4 << 20;
+
+// Сжатие стандартного входа (или файла) в потоковый формат. Если источник
+// замолкает, текущий блок закрывается синхронным сбросом, чтобы получатель
+// мог декодировать всё полученное, не дожидаясь заполнения блока.
+int compressStream(int fd, const std::string& outputFile, bool split) {
+    std::ofstream file;
+    std::ostream* out = &std::cout;
+    if (outputFile != "-") {
+        file.open(outputFile, std::ios::binary);
+        if (!file) {
+            std::cerr << "Cannot create output file: " << outputFile << std::endl;
+            return 1;
+        }
+        out = &file;
+    }
+    
+    StreamCompressor compressor(split ? SPLIT_CHUNK_SIZE : Common::DEFAULT_BLOCK_SIZE);
+    compressor.setSplitBlocks(split);
+    // Индекс блоков нужен для дописывания (--append), а оно возможно только в файл
+    compressor.setBlockIndex(file.is_open());
+    std::vector<uint8_t> inBuf(Common::DEFAULT_BLOCK_SIZE);
+    std::vector<uint8_t> outBuf(Common::DEFAULT_BLOCK_SIZE);
+    StreamBuffers strm;
+    bool eof = false;
+    
+    while (!compressor.finished()) {
+        FlushMode flush = FlushMode::NONE;
+        if (!eof) {
+            ssize_t n = read(fd, inBuf.data(), inBuf.size());
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "Read error on input" << std::endl;
+                return 1;
+            }
+            eof = (n == 0);
+            strm.nextIn = inBuf.data();
+            strm.availIn = static_cast<size_t>(n);
+            if (!eof && !inputReady(fd)) flush = FlushMode::SYNC;
+        }
+        if (eof) flush = FlushMode::FINISH;
+        
+        bool done;
+        do {
+            strm.nextOut = outBuf.data();
+            strm.availOut = outBuf.size();
+            done = compressor.compress(strm, flush);
+            out->write(reinterpret_cast<const char*>(outBuf.data()), outBuf.size() - strm.availOut);
+        } while (!done);
+        out->flush();
+        
+        if (!*out) {
+            std::cerr << "Write error" << std::endl;
+            return 1;
+        }
+    }
+    
+    // В файл можно дописать итоговые размеры в заголовок
+    if (file.is_open()) {
+        uint64_t compressedSize = strm.totalOut - ArchiveHeader::SIZE;
+        file.seekp(8);
+        file.write(reinterpret_cast<const char*>(&strm.totalIn), sizeof(strm.totalIn));
+        file.write(reinterpret_cast<const char*>(&compressedSize), sizeof(compressedSize));
+        file.close();
+    }
+    
+    std::cerr << "Stream compression completed: " << strm.totalIn << " -> " << strm.totalOut
+              << " bytes" << std::endl;
+    if (split) {
+        const BlockSplitter& stats = compressor.splitStats();
+        std::cerr << "Blocks: " << stats.newTables() << " with new tables, " << stats.reusedTables()
+                  << " reusing the previous table, " << stats.storedBlocks() << " stored" << std::endl;
+    }
+    return 0;
+}
+
+// Дописывание входа в существующий потоковый архив: прежние блоки не
+// перекодируются, меняются только хвост архива и размеры в заголовке
+int appendStream(const std::string& inputFile, const std::string& archiveFile) {
+    int fd = STDIN_FILENO;
+    if (inputFile != "-") {
+        fd = open(inputFile.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Cannot open input file: " << inputFile << std::endl;
+            return 1;
+        }
+    }
+    
+    int result = 0;
+    try {
+        StreamAppender appender(archiveFile);
+        std::vector<uint8_t> inBuf(Common::DEFAULT_BLOCK_SIZE);
+        for (;;) {
+            ssize_t n = read(fd, inBuf.data(), inBuf.size());
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("Read error on input");
+            }
+            if (n == 0) break;
+            appender.append(inBuf.data(), static_cast<size_t>(n));
+        }
+        appender.finish();
+        
+        const BlockSplitter& stats = appender.splitStats();
+        std::cout << "Appended " << appender.appendedBytes() << " bytes to " << appender.previousSize()
+                  << ": archive is now " << appender.archiveSize() << " bytes" << std::endl;
+        std::cout << "Blocks: " << stats.newTables() << " with new tables, " << stats.reusedTables()
+                  << " reusing the previous table, " << stats.storedBlocks() << " stored" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Append error: " << e.what() << std::endl;
+        result = 1;
+    }
+    if (fd != STDIN_FILENO) close(fd);
+    return result;
+}
+
+// Однопроходное сжатие адаптивным Хаффманом: вход читается порциями и
+// кодируется сразу, без гистограммы и таблицы. Подходит для каналов и
+// сокетов; размеры в заголовке дописываются, только если выход - файл.
+// Прочитанный вход не сохраняется, поэтому перейти на хранение без
+// кодирования нельзя: несжимаемые данные становятся больше.
+int compressAdaptive(const std::string& inputFile, const std::string& outputFile) {
+    int fd = STDIN_FILENO;
+    if (inputFile != "-") {
+        fd = open(inputFile.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Cannot open input file: " << inputFile << std::endl;
+            return 1;
+        }
+    }
+    
+    int result = 0;
+    try {
+        std::ofstream file;
+        std::ostream* out = &std::cout;
+        if (outputFile != "-") {
+            file.open(outputFile, std::ios::binary);
+            if (!file) {
+                throw std::runtime_error("Cannot create output file: " + outputFile);
+            }
+            out = &file;
+        }
+        
+        ArchiveHeader header;
+        header.signature = Common::SIGNATURE;
+        header.version = Common::VERSION_2;
+        header.algorithm = Common::ALGO_ADAPTIVE_HUFFMAN;
+        header.frequencyBits = 0;
+        header.filter = 0;
+        header.originalSize = 0;
+        header.compressedSize = 0;
+        ArchiveWriter::writeHeader(*out, header);
+        
+        // Запас на один символ: путь от листа до корня и сырые биты нового символа
+        const size_t SYMBOL_MARGIN = AdaptiveHuffman::MAX_CODE_BYTES;
+        std::vector<uint8_t> inBuf(Common::DEFAULT_BLOCK_SIZE);
+        std::vector<uint8_t> outBuf(Common::DEFAULT_BLOCK_SIZE + SYMBOL_MARGIN);
+        BitWriter writer(outBuf.data(), outBuf.size());
+        AdaptiveHuffman model;
+        uint64_t totalIn = 0;
+        uint64_t totalOut = 0;
+        
+        auto drain = [&]() {
+            out->write(reinterpret_cast<const char*>(outBuf.data()), writer.bytesWritten());
+            totalOut += writer.bytesWritten();
+            writer.rewind();
+        };
+        
+        for (;;) {
+            ssize_t n = read(fd, inBuf.data(), inBuf.size());
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("Read error on input");
+            }
+            if (n == 0) break;
+            for (ssize_t i = 0; i < n; i++) {
+                model.encodeSymbol(inBuf[i], writer);
+                if (writer.bytesWritten() + SYMBOL_MARGIN > outBuf.size()) drain();
+            }
+            totalIn += n;
+            // Готовые байты отдаются сразу; неполный байт остаётся в BitWriter
+            drain();
+            out->flush();
+            if (!*out) {
+                throw std::runtime_error("Write error");
+            }
+        }
+        
+        model.encodeSymbol(AdaptiveHuffman::END_OF_STREAM, writer);
+        writer.flush();
+        drain();
+        out->flush();
+        
+        if (file.is_open()) {
+            file.seekp(8);
+            file.write(reinterpret_cast<const char*>(&totalIn), sizeof(totalIn));
+            file.write(reinterpret_cast<const char*>(&totalOut), sizeof(totalOut));
+            file.close();
+        }
+        
+        std::ostream& report = outputFile == "-" ? std::cerr : std::cout;
+        report << "Adaptive Huffman compression completed: " << totalIn << " -> " << totalOut
+               << " bytes" << std::endl;
+        if (totalOut > totalIn) {
+            report << "Warning: the input does not compress; one-pass mode cannot store it as is" << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Compression error: " << e.what() << std::endl;
+        result = 1;
+    }
+    if (fd != STDIN_FILENO) close(fd);
+    return result;
+}
 
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <input file> <output file>" << std::endl;
+    // Необязательные ключи: алгоритм и его настройки, оценка частот по
+    // выборке, однопроходный и потоковые режимы
+    Common::Algorithm algorithm = Common::ALGO_HUFFMAN;
+    int windowLog = Lz77Code::DEFAULT_WINDOW_LOG;
+    int level = Lz77Code::DEFAULT_LEVEL;
+    size_t bwtBlockSize = BwtCode::DEFAULT_BLOCK_SIZE;
+    unsigned bwtThreads = 0;
+    size_t sampleStride = 0;
+    size_t indexInterval = 0;
+    bool adaptive = false;
+    bool split = false;
+    bool append = false;
+    bool pretrained = false;
+    uint32_t tableId = 0;
+    std::string tableDirectory = ".";
+    uint8_t filter = DataFilter::AUTO;
+    int arg = 1;
+    while (arg < argc && std::string(argv[arg]).rfind("--", 0) == 0) {
+        std::string option = argv[arg];
+        if (option == "--algorithm" && arg + 1 < argc) {
+            if (!ArchiveWriter::parseAlgorithm(argv[arg + 1], algorithm)) {
+                std::cerr << "Unknown algorithm: " << argv[arg + 1] << std::endl;
+                return 1;
+            }
+            arg += 2;
+        } else if ((option == "--window" || option == "--level" || option == "--block" || option == "--threads") &&
+                   arg + 1 < argc) {
+            try {
+                unsigned long value = std::stoul(argv[arg + 1]);
+                if (option == "--window") windowLog = static_cast<int>(value);
+                if (option == "--level") level = static_cast<int>(value);
+                if (option == "--block") bwtBlockSize = value * 1024;
+                if (option == "--threads") bwtThreads = static_cast<unsigned>(value);
+            } catch (const std::exception&) {
+                std::cerr << "Invalid value for " << option << ": " << argv[arg + 1] << std::endl;
+                return 1;
+            }
+            arg += 2;
+        } else if (option == "--adaptive") {
+            adaptive = true;
+            arg++;
+        } else if (option == "--split") {
+            split = true;
+            arg++;
+        } else if (option == "--append") {
+            append = true;
+            arg++;
+        } else if (option == "--table" && arg + 1 < argc) {
+            try {
+                size_t end = 0;
+                unsigned long value = std::stoul(argv[arg + 1], &end, 16);
+                if (argv[arg + 1][end] != '\0' || value > UINT32_MAX) throw std::out_of_range("id");
+                tableId = static_cast<uint32_t>(value);
+            } catch (const std::exception&) {
+                std::cerr << "Invalid table id: " << argv[arg + 1] << std::endl;
+                return 1;
+            }
+            pretrained = true;
+            arg += 2;
+        } else if (option == "--tables" && arg + 1 < argc) {
+            tableDirectory = argv[arg + 1];
+            arg += 2;
+        } else if (option == "--filter" && arg + 1 < argc) {
+            std::string name = argv[arg + 1];
+            try {
+                filter = name == "auto" ? DataFilter::AUTO : DataFilter::parse(name);
+            } catch (const std::exception&) {
+                std::cerr << "Unknown filter: " << name << std::endl;
+                return 1;
+            }
+            arg += 2;
+        } else if (option == "--sample" && arg + 1 < argc) {
+            try {
+                sampleStride = std::stoul(argv[arg + 1]);
+            } catch (const std::exception&) {
+                std::cerr << "Invalid sample stride: " << argv[arg + 1] << std::endl;
+                return 1;
+            }
+            arg += 2;
+        } else if (option == "--index" && arg + 1 < argc) {
+            try {
+                indexInterval = std::stoul(argv[arg + 1]) * 1024;
+            } catch (const std::exception&) {
+                indexInterval = 0;
+            }
+            if (indexInterval == 0) {
+                std::cerr << "Invalid index interval: " << argv[arg + 1] << std::endl;
+                return 1;
+            }
+            arg += 2;
+        } else {
+            std::cerr << "Unknown option: " << option << std::endl;
+            return 1;
+        }
+    }
+    
+    if (argc - arg != 2) {
+        std::cerr << "Usage: " << argv[0] << " [--algorithm NAME] [--sample N] [--filter NAME] [--index KB]"
+                  << " [--adaptive] [--split] [--append] [--table ID] [--tables DIR] <input file|-> <output file|->"
+                  << std::endl;
+        std::cerr << "  '-' as input reads standard input and writes a stream archive" << std::endl;
+        std::cerr << "  --algorithm NAME: huffman (default), sf, tans, range, adaptive, lz77, bwt, utf8, word," << std::endl;
+        std::cerr << "    alphabetic; stream archives (standard input, --split, --append) are Huffman only" << std::endl;
+        std::cerr << "  --window LOG, --level N: LZ77 window of 2^LOG bytes (" << Lz77Code::MIN_WINDOW_LOG << ".."
+                  << Lz77Code::MAX_WINDOW_LOG << ", default " << Lz77Code::DEFAULT_WINDOW_LOG << ") and search effort ("
+                  << Lz77Code::MIN_LEVEL << ".." << Lz77Code::MAX_LEVEL << ", default " << Lz77Code::DEFAULT_LEVEL << ")"
+                  << std::endl;
+        std::cerr << "  --block KB, --threads N: BWT block size (" << BwtCode::MIN_BLOCK_SIZE / 1024 << ".."
+                  << BwtCode::MAX_BLOCK_SIZE / 1024 << ", default " << BwtCode::DEFAULT_BLOCK_SIZE / 1024
+                  << ") and worker threads (0 - one per core)" << std::endl;
+        std::cerr << "  --sample N estimates frequencies from every N-th block of the input" << std::endl;
+        std::cerr << "  --filter NAME preprocesses 16/32-bit arrays: auto (default), none, delta16, delta32," << std::endl;
+        std::cerr << "    xor16, xor32, planes16, planes32 or a predictor with +planes, e.g. delta16+planes" << std::endl;
+        std::cerr << "  --index KB adds a seek index with a checkpoint every KB kilobytes, so that" << std::endl;
+        std::cerr << "    decoder --range can start near the requested bytes (disables filters)" << std::endl;
+        std::cerr << "  --adaptive is --algorithm adaptive; a file that does not compress is stored as is," << std::endl;
+        std::cerr << "    standard input is coded in one pass and can grow on incompressible data" << std::endl;
+        std::cerr << "  --split writes a stream archive with blocks chosen by cost; a block either" << std::endl;
+        std::cerr << "    carries its own table or reuses the previous one" << std::endl;
+        std::cerr << "  --append adds the input to an existing stream archive (the output file)" << std::endl;
+        std::cerr << "    without re-encoding it; new blocks may reuse its last table" << std::endl;
+        std::cerr << "  --table ID codes with a pretrained table (see trainer) instead of the input's" << std::endl;
+        std::cerr << "    frequencies; the archive keeps only the id. --tables DIR: where tables live (.)" << std::endl;
         return 1;
     }
+    std::string inputFile = argv[arg];
+    std::string outputFile = argv[arg + 1];
+    
+    // Файл сжимает библиотека: она проверяет сжимаемость и при необходимости
+    // хранит вход без кодирования. Однопроходный режим - только для потока
+    if (adaptive) algorithm = Common::ALGO_ADAPTIVE_HUFFMAN;
+    adaptive = algorithm == Common::ALGO_ADAPTIVE_HUFFMAN && inputFile == "-";
+    
+    if (algorithm != Common::ALGO_HUFFMAN && !adaptive && (split || append || inputFile == "-")) {
+        std::cerr << "Stream archives support only the Huffman algorithm" << std::endl;
+        return 1;
+    }
+    if (indexInterval > 0 && (adaptive || split || inputFile == "-")) {
+        std::cerr << "--index applies only to whole-file Huffman archives" << std::endl;
+        return 1;
+    }
+    if (indexInterval > 0 && filter != DataFilter::AUTO && filter != DataFilter::NONE) {
+        std::cerr << "Filters cannot be combined with --index" << std::endl;
+        return 1;
+    }
+    if (pretrained && (adaptive || split || append || inputFile == "-")) {
+        std::cerr << "--table applies only to whole-file Huffman archives" << std::endl;
+        return 1;
+    }
+    if (pretrained && filter != DataFilter::AUTO && filter != DataFilter::NONE) {
+        std::cerr << "Filters cannot be combined with --table" << std::endl;
+        return 1;
+    }
+    if (append) {
+        if (adaptive || indexInterval > 0 || outputFile == "-") {
+            std::cerr << "--append needs an existing stream archive file as output" << std::endl;
+            return 1;
+        }
+        return appendStream(inputFile, outputFile);
+    }
+    if (adaptive) {
+        return compressAdaptive(inputFile, outputFile);
+    }
+    if (inputFile == "-") {
+        return compressStream(STDIN_FILENO, outputFile, split);
+    }
+    if (split) {
+        int fd = open(inputFile.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Cannot open input file: " << inputFile << std::endl;
+            return 1;
+        }
+        int result = compressStream(fd, outputFile, true);
+        close(fd);
+        return result;
+    }
     
     // Чтение входного файла
-    std::ifstream input(argv[1], std::ios::binary);
+    std::ifstream input(inputFile, std::ios::binary);
     if (!input) {
-        std::cerr << "Cannot open input file: " << argv[1] << std::endl;
+        std::cerr << "Cannot open input file: " << inputFile << std::endl;
         return 1;
     }
     
@@ -31,64 +432,98 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    // Анализ и выбор оптимальной разрядности
-    auto freqs = FrequencyAnalyzer::calculateFrequencies(data);
-    int bestBits = 8; // По умолчанию используем 8 бит
-    
-    // Простой подбор лучшей разрядности
-    std::vector<int> bitOptions = {64, 32, 8, 4};
-    uint64_t bestSize = UINT64_MAX;
-    
-    for (int bits : bitOptions) {
-        auto normFreqs = FrequencyAnalyzer::normalizeFrequencies(freqs, bits);
-        uint64_t compressedBits = FrequencyAnalyzer::calculateCompressedSize(freqs, normFreqs);
-        uint64_t totalSize = (compressedBits + 7) / 8 + 32 * bits;
-        
-        if (totalSize < bestSize) {
-            bestSize = totalSize;
-            bestBits = bits;
+    // Сжатие библиотекой в буфер гарантированного размера
+    std::vector<uint8_t> archive(Codec::compressBound(data.size(), indexInterval));
+    CompressContext context(algorithm);
+    TableLibrary library(tableDirectory);
+    const PretrainedTable* table = nullptr;
+    size_t archiveSize;
+    double seconds;
+    try {
+        context.setSampleStride(sampleStride);
+        context.setIndexInterval(indexInterval);
+        context.setFilter(filter);
+        if (algorithm == Common::ALGO_LZ77) context.setLz77Options(windowLog, level);
+        if (algorithm == Common::ALGO_BWT) context.setBwtOptions(bwtBlockSize, bwtThreads);
+        if (pretrained) {
+            table = &library.get(tableId);
+            context.setPretrainedTable(table);
         }
-    }
-    
-    // Кодирование с выбранной разрядностью
-    auto normFreqs = FrequencyAnalyzer::normalizeFrequencies(freqs, bestBits);
-    HuffmanEncoder encoder(normFreqs);
-    
-    // Временный поток для измерения размера сжатых данных
-    std::stringstream tempStream;
-    BitOutputStream tempOut(tempStream);
-    encoder.encodeData(data, tempOut);
-    tempOut.flush();
-    
-    std::string compressedData = tempStream.str();
-    uint64_t compressedSize = compressedData.size();
-    
-    // Запись архива
-    std::ofstream output(argv[2], std::ios::binary);
-    if (!output) {
-        std::cerr << "Cannot create output file: " << argv[2] << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        archiveSize = context.compress(data.data(), data.size(), archive.data(), archive.size());
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } catch (const std::exception& e) {
+        std::cerr << "Compression error: " << e.what() << std::endl;
         return 1;
     }
+    uint64_t compressedSize = ArchiveWriter::readHeader(archive.data()).compressedSize;
+    int bestBits = context.lastFrequencyBits();
     
-    ArchiveHeader header;
-    header.signature = Common::SIGNATURE;
-    header.version = Common::VERSION_2;
-    header.algorithm = Common::ALGO_HUFFMAN;
-    header.frequencyBits = bestBits;
-    header.reserved = 0;
-    header.originalSize = data.size();
-    header.compressedSize = compressedSize;
+    // Запись архива ('-' - стандартный вывод, тогда отчёт идёт в stderr)
+    bool toStdout = outputFile == "-";
+    std::ofstream file;
+    if (!toStdout) {
+        file.open(outputFile, std::ios::binary);
+        if (!file) {
+            std::cerr << "Cannot create output file: " << outputFile << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& output = toStdout ? std::cout : file;
+    std::ostream& report = toStdout ? std::cerr : std::cout;
     
-    ArchiveWriter::writeHeader(output, header);
-    ArchiveWriter::writeFrequencies(output, normFreqs, bestBits);
-    output.write(compressedData.c_str(), compressedSize);
+    output.write(reinterpret_cast<const char*>(archive.data()), archiveSize);
+    output.flush();
     
-    output.close();
+    if (file.is_open()) file.close();
     
     double ratio = (compressedSize * 100.0) / data.size();
-    std::cout << "Compression completed: " << data.size() << " -> " << compressedSize 
-              << " bytes (" << ratio << "%)" << std::endl;
-    std::cout << "Frequency bits: " << bestBits << std::endl;
+    report << "Compression completed: " << data.size() << " -> " << compressedSize 
+           << " bytes (" << ratio << "%)" << std::endl;
+    if (algorithm != Common::ALGO_HUFFMAN) {
+        report << "Algorithm: " << ArchiveWriter::algorithmName(algorithm) << ", "
+               << (data.size() / (1024.0 * 1024.0)) / seconds << " MB/s" << std::endl;
+    }
+    if (context.lastFilter() != DataFilter::NONE) {
+        report << "Filter: " << DataFilter::name(context.lastFilter()) << std::endl;
+    }
+    // Таблица частот в заголовке архива есть только у префиксных кодов и tANS
+    bool frequencyTable = algorithm == Common::ALGO_HUFFMAN || algorithm == Common::ALGO_SHANNON_FANO ||
+                          algorithm == Common::ALGO_ALPHABETIC || algorithm == Common::ALGO_TANS;
+    if (context.lastStored()) {
+        report << "Input is incompressible, stored without coding" << std::endl;
+    } else if (frequencyTable) {
+        report << "Frequency bits: " << ArchiveWriter::tableBitsName(bestBits) << std::endl;
+    }
+    if (!context.lastStored()) {
+        if (algorithm == Common::ALGO_TANS) {
+            report << "Table log: " << TansCode::TABLE_LOG << std::endl;
+        } else if (algorithm == Common::ALGO_LZ77) {
+            report << "Matches: " << context.lz77Stats().lastMatches() << " covering "
+                   << (context.lz77Stats().lastMatchedBytes() * 100.0) / data.size() << "% of input (window "
+                   << (1u << windowLog) << ", level " << level << ")" << std::endl;
+        } else if (algorithm == Common::ALGO_BWT) {
+            report << "Blocks: " << (data.size() + bwtBlockSize - 1) / bwtBlockSize << " of "
+                   << bwtBlockSize / 1024 << " KiB" << std::endl;
+        } else if (algorithm == Common::ALGO_UTF8) {
+            report << "Codepoint table: " << context.utf8Stats().lastCodepoints() << " entries, "
+                   << context.utf8Stats().lastEscapedBytes() << " bytes coded bytewise" << std::endl;
+        } else if (algorithm == Common::ALGO_WORD) {
+            report << "Vocabulary: " << context.wordStats().lastWords() << " words for "
+                   << context.wordStats().lastTokens() << " tokens, " << context.wordStats().lastEscapedBytes()
+                   << " bytes of rare tokens coded bytewise" << std::endl;
+        }
+    }
+    if (table && !context.lastStored()) {
+        report << "Table: " << TableLibrary::fileName(table->id) << " (" << table->name << ")" << std::endl;
+    }
+    if (!context.lastIndex().empty()) {
+        report << "Seek index: " << context.lastIndex().entries().size() << " checkpoints every "
+               << context.lastIndex().interval() / 1024 << " KB" << std::endl;
+    }
+    if (context.lastSampled()) {
+        report << "Frequencies estimated from 1/" << sampleStride << " of the input" << std::endl;
+    }
     
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,369 @@
+#include "filter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FILTER_SSE2 1
+#endif
+
+namespace {
+    // Фильтр принимается, если энтропия выборки падает хотя бы на 1/32
+    const double MIN_GAIN = 1.0 - 1.0 / 32;
+
+    template <typename T>
+    T load(const uint8_t* p, size_t index) {
+        T value;
+        std::memcpy(&value, p + index * sizeof(T), sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void store(uint8_t* p, size_t index, T value) {
+        std::memcpy(p + index * sizeof(T), &value, sizeof(T));
+    }
+
+#ifdef FILTER_SSE2
+    __m128i loadVector(const uint8_t* p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+
+    void storeVector(uint8_t* p, __m128i value) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), value);
+    }
+
+    template <bool Xor, typename T>
+    __m128i forwardVector(__m128i current, __m128i previous) {
+        if constexpr (Xor) return _mm_xor_si128(current, previous);
+        else if constexpr (sizeof(T) == 2) return _mm_sub_epi16(current, previous);
+        else return _mm_sub_epi32(current, previous);
+    }
+
+    template <bool Xor, typename T>
+    __m128i inverseVector(__m128i value, __m128i previous) {
+        if constexpr (Xor) return _mm_xor_si128(value, previous);
+        else if constexpr (sizeof(T) == 2) return _mm_add_epi16(value, previous);
+        else return _mm_add_epi32(value, previous);
+    }
+
+    // Последний элемент вектора во всех позициях
+    template <typename T>
+    __m128i broadcastLast(__m128i value) {
+        if constexpr (sizeof(T) == 2) {
+            __m128i high = _mm_shufflehi_epi16(value, 0xFF);
+            return _mm_unpackhi_epi64(high, high);
+        } else {
+            return _mm_shuffle_epi32(value, 0xFF);
+        }
+    }
+#endif
+
+    template <bool Xor, typename T>
+    void predict(const uint8_t* src, uint8_t* dst, size_t count) {
+        if (count == 0) return;
+        store<T>(dst, 0, load<T>(src, 0));
+        size_t k = 1;
+#ifdef FILTER_SSE2
+        const size_t lanes = 16 / sizeof(T);
+        for (; k + lanes <= count; k += lanes) {
+            __m128i current = loadVector(src + k * sizeof(T));
+            __m128i previous = loadVector(src + (k - 1) * sizeof(T));
+            storeVector(dst + k * sizeof(T), forwardVector<Xor, T>(current, previous));
+        }
+#endif
+        for (; k < count; k++) {
+            T current = load<T>(src, k);
+            T previous = load<T>(src, k - 1);
+            store<T>(dst, k, static_cast<T>(Xor ? current ^ previous : current - previous));
+        }
+    }
+
+    // Префиксная сумма (XOR); src и dst могут совпадать
+    template <bool Xor, typename T>
+    void unpredict(const uint8_t* src, uint8_t* dst, size_t count) {
+        if (count == 0) return;
+        T previous = load<T>(src, 0);
+        store<T>(dst, 0, previous);
+        size_t k = 1;
+#ifdef FILTER_SSE2
+        // Внутри вектора - сдвиги на 1, 2, 4 элемента, затем перенос из предыдущего вектора
+        const size_t lanes = 16 / sizeof(T);
+        __m128i carry = sizeof(T) == 2 ? _mm_set1_epi16(static_cast<short>(previous))
+                                       : _mm_set1_epi32(static_cast<int>(previous));
+        for (; k + lanes <= count; k += lanes) {
+            __m128i value = loadVector(src + k * sizeof(T));
+            value = inverseVector<Xor, T>(value, _mm_slli_si128(value, sizeof(T)));
+            value = inverseVector<Xor, T>(value, _mm_slli_si128(value, 2 * sizeof(T)));
+            if constexpr (sizeof(T) == 2) {
+                value = inverseVector<Xor, T>(value, _mm_slli_si128(value, 8));
+            }
+            value = inverseVector<Xor, T>(value, carry);
+            storeVector(dst + k * sizeof(T), value);
+            carry = broadcastLast<T>(value);
+        }
+        previous = load<T>(dst, k - 1);
+#endif
+        for (; k < count; k++) {
+            T value = load<T>(src, k);
+            previous = static_cast<T>(Xor ? value ^ previous : value + previous);
+            store<T>(dst, k, previous);
+        }
+    }
+
+    // Байт p элемента k -> плоскость p, позиция k
+    template <int Stride>
+    void split(const uint8_t* src, uint8_t* dst, size_t count) {
+        size_t k = 0;
+#ifdef FILTER_SSE2
+        const __m128i low = _mm_set1_epi16(0x00FF);
+        for (; k + 16 <= count; k += 16) {
+            const uint8_t* in = src + k * Stride;
+            if constexpr (Stride == 2) {
+                __m128i a = loadVector(in);
+                __m128i b = loadVector(in + 16);
+                storeVector(dst + k, _mm_packus_epi16(_mm_and_si128(a, low), _mm_and_si128(b, low)));
+                storeVector(dst + count + k, _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+            } else {
+                // Два шага разделения чётных и нечётных байт: (b0 b2), (b1 b3), затем по плоскостям
+                __m128i a0 = loadVector(in);
+                __m128i a1 = loadVector(in + 16);
+                __m128i a2 = loadVector(in + 32);
+                __m128i a3 = loadVector(in + 48);
+                __m128i even0 = _mm_packus_epi16(_mm_and_si128(a0, low), _mm_and_si128(a1, low));
+                __m128i odd0 = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8));
+                __m128i even1 = _mm_packus_epi16(_mm_and_si128(a2, low), _mm_and_si128(a3, low));
+                __m128i odd1 = _mm_packus_epi16(_mm_srli_epi16(a2, 8), _mm_srli_epi16(a3, 8));
+                storeVector(dst + k, _mm_packus_epi16(_mm_and_si128(even0, low), _mm_and_si128(even1, low)));
+                storeVector(dst + count + k, _mm_packus_epi16(_mm_and_si128(odd0, low), _mm_and_si128(odd1, low)));
+                storeVector(dst + 2 * count + k,
+                            _mm_packus_epi16(_mm_srli_epi16(even0, 8), _mm_srli_epi16(even1, 8)));
+                storeVector(dst + 3 * count + k,
+                            _mm_packus_epi16(_mm_srli_epi16(odd0, 8), _mm_srli_epi16(odd1, 8)));
+            }
+        }
+#endif
+        for (; k < count; k++) {
+            for (int p = 0; p < Stride; p++) {
+                dst[p * count + k] = src[k * Stride + p];
+            }
+        }
+    }
+
+    template <int Stride>
+    void merge(const uint8_t* src, uint8_t* dst, size_t count) {
+        size_t k = 0;
+#ifdef FILTER_SSE2
+        for (; k + 16 <= count; k += 16) {
+            uint8_t* out = dst + k * Stride;
+            if constexpr (Stride == 2) {
+                __m128i lo = loadVector(src + k);
+                __m128i hi = loadVector(src + count + k);
+                storeVector(out, _mm_unpacklo_epi8(lo, hi));
+                storeVector(out + 16, _mm_unpackhi_epi8(lo, hi));
+            } else {
+                __m128i p0 = loadVector(src + k);
+                __m128i p1 = loadVector(src + count + k);
+                __m128i p2 = loadVector(src + 2 * count + k);
+                __m128i p3 = loadVector(src + 3 * count + k);
+                __m128i evenLo = _mm_unpacklo_epi8(p0, p2);
+                __m128i evenHi = _mm_unpackhi_epi8(p0, p2);
+                __m128i oddLo = _mm_unpacklo_epi8(p1, p3);
+                __m128i oddHi = _mm_unpackhi_epi8(p1, p3);
+                storeVector(out, _mm_unpacklo_epi8(evenLo, oddLo));
+                storeVector(out + 16, _mm_unpackhi_epi8(evenLo, oddLo));
+                storeVector(out + 32, _mm_unpacklo_epi8(evenHi, oddHi));
+                storeVector(out + 48, _mm_unpackhi_epi8(evenHi, oddHi));
+            }
+        }
+#endif
+        for (; k < count; k++) {
+            for (int p = 0; p < Stride; p++) {
+                dst[k * Stride + p] = src[p * count + k];
+            }
+        }
+    }
+
+    // Диспетчеризация по предсказателю и размеру элемента; хвост копируется как есть
+    void predictAny(DataFilter::Predictor predictor, int stride, const uint8_t* src, uint8_t* dst, size_t size) {
+        size_t count = size / stride;
+        bool isXor = predictor == DataFilter::PREDICT_XOR;
+        if (stride == 2) {
+            isXor ? predict<true, uint16_t>(src, dst, count) : predict<false, uint16_t>(src, dst, count);
+        } else {
+            isXor ? predict<true, uint32_t>(src, dst, count) : predict<false, uint32_t>(src, dst, count);
+        }
+        std::memcpy(dst + count * stride, src + count * stride, size - count * stride);
+    }
+
+    void unpredictAny(DataFilter::Predictor predictor, int stride, const uint8_t* src, uint8_t* dst, size_t size) {
+        size_t count = size / stride;
+        bool isXor = predictor == DataFilter::PREDICT_XOR;
+        if (stride == 2) {
+            isXor ? unpredict<true, uint16_t>(src, dst, count) : unpredict<false, uint16_t>(src, dst, count);
+        } else {
+            isXor ? unpredict<true, uint32_t>(src, dst, count) : unpredict<false, uint32_t>(src, dst, count);
+        }
+        if (src != dst) {
+            std::memcpy(dst + count * stride, src + count * stride, size - count * stride);
+        }
+    }
+
+    void splitAny(int stride, const uint8_t* src, uint8_t* dst, size_t size) {
+        size_t count = size / stride;
+        stride == 2 ? split<2>(src, dst, count) : split<4>(src, dst, count);
+        std::memcpy(dst + count * stride, src + count * stride, size - count * stride);
+    }
+
+    void mergeAny(int stride, const uint8_t* src, uint8_t* dst, size_t size) {
+        size_t count = size / stride;
+        stride == 2 ? merge<2>(src, dst, count) : merge<4>(src, dst, count);
+        std::memcpy(dst + count * stride, src + count * stride, size - count * stride);
+    }
+
+    double entropyBits(const uint64_t* counts, uint64_t total) {
+        double bits = 0;
+        for (size_t c = 0; c < Common::ALPHABET_SIZE; c++) {
+            if (counts[c] > 0) {
+                bits += counts[c] * std::log2(static_cast<double>(total) / counts[c]);
+            }
+        }
+        return bits;
+    }
+
+    // Энтропия всего потока и сумма энтропий байтовых плоскостей (в битах)
+    void measure(const uint8_t* data, size_t size, int stride, double& mixed, double& planes) {
+        uint64_t counts[4][Common::ALPHABET_SIZE] = {};
+        for (size_t i = 0; i < size; i++) {
+            counts[i % stride][data[i]]++;
+        }
+        uint64_t total[Common::ALPHABET_SIZE] = {};
+        planes = 0;
+        for (int p = 0; p < stride; p++) {
+            uint64_t planeTotal = 0;
+            for (size_t c = 0; c < Common::ALPHABET_SIZE; c++) {
+                total[c] += counts[p][c];
+                planeTotal += counts[p][c];
+            }
+            planes += entropyBits(counts[p], planeTotal);
+        }
+        mixed = entropyBits(total, size);
+    }
+}
+
+uint8_t DataFilter::make(Predictor predictor, int stride, bool transpose) {
+    if (predictor == PREDICT_NONE && !transpose) return NONE;
+    uint8_t strideLog = stride == 2 ? 1 : 2;
+    return static_cast<uint8_t>(predictor | (transpose ? TRANSPOSE : 0) | (strideLog << 4));
+}
+
+void DataFilter::validate(uint8_t filter) {
+    if (filter == NONE) return;
+    int strideLog = filter >> 4;
+    bool known = (filter & 0x08) == 0 && predictor(filter) <= PREDICT_XOR && (strideLog == 1 || strideLog == 2) &&
+                 (predictor(filter) != PREDICT_NONE || transposed(filter));
+    if (!known) {
+        throw std::runtime_error("Unsupported filter: " + std::to_string(filter));
+    }
+}
+
+std::string DataFilter::name(uint8_t filter) {
+    if (filter == NONE) return "none";
+    std::string bits = std::to_string(8 * stride(filter));
+    switch (predictor(filter)) {
+        case PREDICT_DELTA: return "delta" + bits + (transposed(filter) ? "+planes" : "");
+        case PREDICT_XOR: return "xor" + bits + (transposed(filter) ? "+planes" : "");
+        default: return "planes" + bits;
+    }
+}
+
+uint8_t DataFilter::parse(const std::string& text) {
+    const Predictor predictors[] = {PREDICT_NONE, PREDICT_DELTA, PREDICT_XOR};
+    for (Predictor p : predictors) {
+        for (int stride : {2, 4}) {
+            for (bool transpose : {false, true}) {
+                uint8_t filter = make(p, stride, transpose);
+                if (name(filter) == text) return filter;
+            }
+        }
+    }
+    throw std::invalid_argument("Unknown filter: " + text);
+}
+
+void DataFilter::apply(uint8_t filter, const uint8_t* src, size_t size, uint8_t* dst, uint8_t* temp) {
+    validate(filter);
+    if (filter == NONE) {
+        std::memcpy(dst, src, size);
+        return;
+    }
+    const uint8_t* current = src;
+    if (predictor(filter) != PREDICT_NONE) {
+        uint8_t* out = transposed(filter) ? temp : dst;
+        predictAny(predictor(filter), stride(filter), src, out, size);
+        current = out;
+    }
+    if (transposed(filter)) {
+        splitAny(stride(filter), current, dst, size);
+    }
+}
+
+void DataFilter::invert(uint8_t filter, uint8_t* data, size_t size, uint8_t* temp) {
+    validate(filter);
+    if (filter == NONE) return;
+    if (!transposed(filter)) {
+        unpredictAny(predictor(filter), stride(filter), data, data, size);
+        return;
+    }
+    mergeAny(stride(filter), data, temp, size);
+    if (predictor(filter) != PREDICT_NONE) {
+        unpredictAny(predictor(filter), stride(filter), temp, data, size);
+    } else {
+        std::memcpy(data, temp, size);
+    }
+}
+
+uint8_t DataFilter::detect(const uint8_t* src, size_t size, bool contextCoder, uint8_t* workspace) {
+    if (size < MIN_SIZE) return NONE;
+
+    // Куски выборки равномерно по входу; смещения кратны 4, чтобы не сбить
+    // выравнивание элементов
+    size_t chunk = std::min(SAMPLE_CHUNK, size / SAMPLE_CHUNKS / 4 * 4);
+    if (chunk == 0) chunk = size / 4 * 4;
+    size_t chunks = std::min(SAMPLE_CHUNKS, size / chunk);
+    size_t step = (size - chunk) / std::max<size_t>(chunks - 1, 1) / 4 * 4;
+    size_t sampleSize = chunk * chunks;
+    uint8_t* sample = workspace;
+    uint8_t* filtered = workspace + sampleSize;
+    for (size_t i = 0; i < chunks; i++) {
+        std::memcpy(sample + i * chunk, src + i * step, chunk);
+    }
+
+    double mixed, planes;
+    measure(sample, sampleSize, 2, mixed, planes);
+    double baseCost = mixed;
+    double bestCost = baseCost * MIN_GAIN;
+    uint8_t best = NONE;
+
+    const Predictor predictors[] = {PREDICT_NONE, PREDICT_DELTA, PREDICT_XOR};
+    for (int stride : {2, 4}) {
+        for (Predictor p : predictors) {
+            const uint8_t* data = sample;
+            if (p != PREDICT_NONE) {
+                predictAny(p, stride, sample, filtered, sampleSize);
+                data = filtered;
+            }
+            measure(data, sampleSize, stride, mixed, planes);
+            if (p != PREDICT_NONE && mixed < bestCost) {
+                bestCost = mixed;
+                best = make(p, stride, false);
+            }
+            // Плоскости выгодны, только если заметно отличаются друг от друга
+            if (contextCoder && planes < mixed * MIN_GAIN && planes < bestCost) {
+                bestCost = planes;
+                best = make(p, stride, true);
+            }
+        }
+    }
+    return best;
+}
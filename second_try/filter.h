@@ -0,0 +1,59 @@
+// filter.h - обратимые фильтры для массивов 16/32-битных чисел
+#pragma once
+#include "common.h"
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Фильтр переводит вход в поток с более выраженной статистикой перед
+// кодированием. Вход рассматривается как массив элементов по stride байт
+// (2 или 4, порядок байт - как у хоста); хвост короче элемента не меняется.
+//   delta  - разность с предыдущим элементом по модулю 2^(8*stride);
+//   xor    - XOR с предыдущим элементом (числа с плавающей точкой);
+//   planes - транспонирование: сначала все младшие байты, затем следующие и т.д.
+// Предсказатель и транспонирование комбинируются. Описание фильтра - один
+// байт заголовка архива: биты 0-1 - предсказатель, бит 2 - транспонирование,
+// биты 4-5 - log2(stride). Нулевой байт - фильтра нет.
+class DataFilter {
+public:
+    enum Predictor : uint8_t {
+        PREDICT_NONE = 0,
+        PREDICT_DELTA = 1,
+        PREDICT_XOR = 2
+    };
+
+    static const uint8_t NONE = 0;
+    static const uint8_t TRANSPOSE = 0x04;
+    // Не описание, а режим CompressContext: выбрать фильтр по выборке
+    static const uint8_t AUTO = 0xFF;
+
+    // Меньшие входы не фильтруются: выборка слишком мала для оценки
+    static const size_t MIN_SIZE = 1024;
+    // constexpr: std::min принимает по ссылке, нужно определение и без -O2
+    static constexpr size_t SAMPLE_CHUNK = 4096;
+    static constexpr size_t SAMPLE_CHUNKS = 16;
+    // Рабочий буфер detect(): выборка и её отфильтрованная копия
+    static const size_t WORKSPACE_SIZE = 2 * SAMPLE_CHUNK * SAMPLE_CHUNKS;
+
+    static uint8_t make(Predictor predictor, int stride, bool transpose);
+    static Predictor predictor(uint8_t filter) { return static_cast<Predictor>(filter & 0x03); }
+    static bool transposed(uint8_t filter) { return (filter & TRANSPOSE) != 0; }
+    static int stride(uint8_t filter) { return 1 << (filter >> 4); }
+
+    // std::runtime_error для неизвестного описания
+    static void validate(uint8_t filter);
+    static std::string name(uint8_t filter);
+    // Обратно к name(); std::invalid_argument для неизвестного имени
+    static uint8_t parse(const std::string& name);
+
+    // src -> dst; temp (size байт) нужен только при предсказателе вместе с транспонированием
+    static void apply(uint8_t filter, const uint8_t* src, size_t size, uint8_t* dst, uint8_t* temp);
+    // Обращение на месте; temp (size байт) нужен при транспонировании
+    static void invert(uint8_t filter, uint8_t* data, size_t size, uint8_t* temp);
+
+    // Выбор фильтра по энтропии нулевого порядка на выборке из SAMPLE_CHUNKS
+    // кусков. Транспонирование не меняет гистограмму, поэтому рассматривается
+    // только для кодеров с контекстом (contextCoder): их выигрыш оценивается
+    // суммой энтропий отдельных байтовых плоскостей. workspace - WORKSPACE_SIZE байт.
+    static uint8_t detect(const uint8_t* src, size_t size, bool contextCoder, uint8_t* workspace);
+};
@@ -0,0 +1,68 @@
+// fixed_decoder.h - код Хаффмана для таблицы, известной при сборке
+#pragma once
+#include "bitstream.h"
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+// Элемент таблицы декодирования. subBits == 0 - символ value, код которого
+// занимает length бит (во вторичной таблице - length бит после первых
+// PRIMARY_BITS). Иначе код длиннее PRIMARY_BITS: следующие subBits бит -
+// индекс во вторичной таблице, начиная с элемента value
+struct FixedDecodeEntry {
+    uint32_t value;
+    uint8_t length;
+    uint8_t subBits;
+};
+
+// Кодер и декодер по constexpr-таблицам, которые gen_decoder пишет в
+// заголовок (struct Table в своём пространстве имён):
+//   ID                 - номер таблицы (PretrainedTable::id);
+//   MAX_CODE_LENGTH    - длина самого длинного кода;
+//   PRIMARY_BITS       - бит в индексе первичной таблицы;
+//   SECONDARY_SIZE     - элементов во вторичных таблицах (0 - не нужны);
+//   frequencies[256]   - таблица частот;
+//   codes[256], lengths[256] - коды Хаффмана, бит в бит как у HuffmanEncoder;
+//   primary[1 << PRIMARY_BITS], secondary[max(SECONDARY_SIZE, 1)].
+// Все размеры - константы времени компиляции: ничего не строится при
+// запуске, а для коротких кодов вторичная ветка исчезает из цикла
+template <typename Table>
+class FixedHuffmanCode {
+public:
+    static_assert(Table::PRIMARY_BITS > 0 && Table::PRIMARY_BITS <= Table::MAX_CODE_LENGTH,
+                  "Primary table must not be wider than the longest code");
+    static_assert(Table::MAX_CODE_LENGTH - Table::PRIMARY_BITS <= 32, "Secondary index must fit peekBits");
+
+    static void encodeSymbol(uint8_t symbol, BitWriter& out) {
+        out.writeBits(Table::codes[symbol], Table::lengths[symbol]);
+    }
+
+    static void encode(const uint8_t* src, size_t size, BitWriter& out) {
+        for (size_t i = 0; i < size; i++) {
+            encodeSymbol(src[i], out);
+        }
+    }
+
+    static uint8_t decodeSymbol(BitReader& in) {
+        const FixedDecodeEntry& entry = Table::primary[in.peekBits(Table::PRIMARY_BITS)];
+        if constexpr (Table::SECONDARY_SIZE > 0) {
+            if (entry.subBits != 0) {
+                in.skipBits(Table::PRIMARY_BITS);
+                const FixedDecodeEntry& tail = Table::secondary[entry.value + in.peekBits(entry.subBits)];
+                in.skipBits(tail.length);
+                return static_cast<uint8_t>(tail.value);
+            }
+        }
+        in.skipBits(entry.length);
+        return static_cast<uint8_t>(entry.value);
+    }
+
+    static void decode(BitReader& in, uint8_t* dst, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            dst[i] = decodeSymbol(in);
+        }
+        if (in.overrun()) {
+            throw std::runtime_error("Unexpected end of stream during decoding");
+        }
+    }
+};
@@ -1,5 +1,6 @@
 #include "frequency.h"
 #include "huffman.h"
+#include "archive_format.h"
 #include <fstream>
 #include <iostream>
 #include <algorithm>
@@ -14,28 +15,65 @@ std::vector<uint64_t> FrequencyAnalyzer::calculateFrequencies(const std::vector<
 }
 
 std::vector<uint64_t> FrequencyNormalizer::normalizeToBits(const std::vector<uint64_t>& freqs, int targetBits) {
-    if (targetBits >= 64) return freqs;
+    std::vector<uint64_t> normalized(freqs.size(), 0);
+    normalizeToBits(freqs.data(), freqs.size(), targetBits, normalized.data(), std::pmr::get_default_resource());
+    return normalized;
+}
+
+void FrequencyNormalizer::normalizeToBits(const uint64_t* freqs, size_t count, int targetBits,
+                                          uint64_t* normalized, std::pmr::memory_resource* scratch) {
+    if (targetBits >= 64) {
+        std::copy(freqs, freqs + count, normalized);
+        return;
+    }
+    
+    std::pmr::vector<uint32_t> order(count, scratch);
+    rankByFrequency(freqs, count, order.data());
+    normalizeToBits(freqs, count, targetBits, normalized, order.data());
+}
+
+void FrequencyNormalizer::normalizeToBits(const uint64_t* freqs, size_t count, int targetBits,
+                                          uint64_t* normalized, const uint32_t* order) {
+    if (targetBits >= 64) {
+        std::copy(freqs, freqs + count, normalized);
+        return;
+    }
     
     uint64_t maxValue = (1ULL << targetBits) - 1;
-    return normalizeToMaxValue(freqs, maxValue);
+    normalizeToMaxValue(freqs, count, maxValue, normalized, order);
 }
 
-std::vector<uint64_t> FrequencyNormalizer::normalizeToMaxValue(const std::vector<uint64_t>& freqs, uint64_t targetMax) {
-    std::vector<uint64_t> normalized(freqs.size(), 0);
-    uint64_t total = std::accumulate(freqs.begin(), freqs.end(), 0ULL);
+void FrequencyNormalizer::normalizeToSum(const uint64_t* freqs, size_t count, uint64_t targetSum,
+                                         uint64_t* normalized, std::pmr::memory_resource* scratch) {
+    std::pmr::vector<uint32_t> order(count, scratch);
+    rankByFrequency(freqs, count, order.data());
+    normalizeToMaxValue(freqs, count, targetSum, normalized, order.data());
+}
+
+void FrequencyNormalizer::rankByFrequency(const uint64_t* freqs, size_t count, uint32_t* order) {
+    for (size_t i = 0; i < count; i++) order[i] = static_cast<uint32_t>(i);
+    std::sort(order, order + count, [&](uint32_t a, uint32_t b) {
+        return freqs[a] > freqs[b];
+    });
+}
+
+void FrequencyNormalizer::normalizeToMaxValue(const uint64_t* freqs, size_t count, uint64_t targetMax,
+                                              uint64_t* normalized, const uint32_t* order) {
+    std::fill(normalized, normalized + count, 0);
+    uint64_t total = std::accumulate(freqs, freqs + count, 0ULL);
     
-    if (total == 0) return normalized;
+    if (total == 0) return;
     
     // Гарантируем, что ненулевые частоты остаются ненулевыми
     uint64_t nonZeroCount = 0;
-    for (uint64_t f : freqs) {
-        if (f > 0) nonZeroCount++;
+    for (size_t i = 0; i < count; i++) {
+        if (freqs[i] > 0) nonZeroCount++;
     }
     
     if (nonZeroCount > targetMax) {
         // Слишком много ненулевых частот - используем пропорциональное масштабирование
         double scale = static_cast<double>(targetMax) / total;
-        for (size_t i = 0; i < freqs.size(); i++) {
+        for (size_t i = 0; i < count; i++) {
             uint64_t scaledValue = static_cast<uint64_t>(freqs[i] * scale);
             normalized[i] = (scaledValue > 0) ? scaledValue : 1;
         }
@@ -47,21 +85,21 @@ std::vector<uint64_t> FrequencyNormalizer::normalizeToMaxValue(const std::vector
         if (total > nonZeroCount) {
             double scale = static_cast<double>(remaining) / (total - nonZeroCount);
             
-            for (size_t i = 0; i < freqs.size(); i++) {
+            for (size_t i = 0; i < count; i++) {
                 if (freqs[i] > 0) {
                     normalized[i] = 1 + static_cast<uint64_t>((freqs[i] - 1) * scale);
                 }
             }
         } else {
             // Все символы встречаются одинаково - равномерное распределение
-            for (size_t i = 0; i < freqs.size(); i++) {
+            for (size_t i = 0; i < count; i++) {
                 if (freqs[i] > 0) {
                     normalized[i] = 1;
                 }
             }
             // Распределяем оставшееся равномерно
             uint64_t extra = targetMax - nonZeroCount;
-            for (size_t i = 0; i < freqs.size() && extra > 0; i++) {
+            for (size_t i = 0; i < count && extra > 0; i++) {
                 if (freqs[i] > 0) {
                     normalized[i]++;
                     extra--;
@@ -71,13 +109,11 @@ std::vector<uint64_t> FrequencyNormalizer::normalizeToMaxValue(const std::vector
     }
     
     // Корректируем сумму до targetMax
-    uint64_t currentSum = std::accumulate(normalized.begin(), normalized.end(), 0ULL);
+    uint64_t currentSum = std::accumulate(normalized, normalized + count, 0ULL);
     if (currentSum != targetMax) {
         int64_t diff = static_cast<int64_t>(targetMax) - static_cast<int64_t>(currentSum);
-        distributeRemainder(normalized, freqs, diff);
+        distributeRemainder(normalized, count, diff, order);
     }
-    
-    return normalized;
 }
 
 std::vector<uint64_t> FrequencyAnalyzer::normalizeFrequencies(const std::vector<uint64_t>& freqs, int bits) {
@@ -117,6 +153,81 @@ uint64_t FrequencyAnalyzer::calculateCompressedSize(const std::vector<uint64_t>&
     return totalBits;
 }
 
+int FrequencyAnalyzer::normalizationWidths(const uint64_t* freqs, size_t count, int* widths) {
+    uint64_t total = 0;
+    uint64_t present = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += freqs[i];
+        present += freqs[i] > 0 ? 1 : 0;
+    }
+    int limit = total == 0 ? 1 : 64 - __builtin_clzll(total);
+    // Если сумма 2^bits - 1 меньше числа символов, все частоты становятся
+    // около 1 при любой такой разрядности - достаточно самой широкой из них
+    int first = present < 2 ? 1 : std::max(1, 63 - __builtin_clzll(present));
+    int number = 0;
+    widths[number++] = 64;
+    for (int bits = first; bits <= limit && bits < 64; bits++) {
+        widths[number++] = bits;
+    }
+    return number;
+}
+
+int FrequencyAnalyzer::selectBestBits(const std::vector<uint64_t>& freqs) {
+    int widths[MAX_WIDTHS];
+    int number = normalizationWidths(freqs.data(), freqs.size(), widths);
+    int bestBits = 64;
+    uint64_t bestSize = UINT64_MAX;
+    
+    for (int i = 0; i < number; i++) {
+        auto normFreqs = normalizeFrequencies(freqs, widths[i]);
+        uint64_t compressedBits = calculateCompressedSize(freqs, normFreqs);
+        int tableBits = ArchiveWriter::compactTableBits(normFreqs.data(), normFreqs.size());
+        uint64_t totalSize = (compressedBits + 7) / 8 +
+                             ArchiveWriter::tableSize(normFreqs.data(), tableBits, normFreqs.size());
+        
+        if (totalSize < bestSize) {
+            bestSize = totalSize;
+            bestBits = widths[i];
+        }
+    }
+    
+    return bestBits;
+}
+
+int FrequencyAnalyzer::selectTableBits(const uint64_t* freqs, size_t count, uint64_t* norm, PrefixCode& target,
+                                       std::pmr::memory_resource* scratch) {
+    // Код Хаффмана по точным частотам (первая ширина) - самый короткий, поэтому
+    // его размер данных - нижняя граница для любой нормировки: если с ним не
+    // окупается уже сама таблица, код для этой ширины не строится. Порядок
+    // раздачи остатка нормировки от ширины не зависит и считается один раз
+    std::pmr::vector<uint32_t> order(count, scratch);
+    FrequencyNormalizer::rankByFrequency(freqs, count, order.data());
+    int widths[MAX_WIDTHS];
+    int number = normalizationWidths(freqs, count, widths);
+    uint64_t bestSize = UINT64_MAX;
+    uint64_t exactBytes = 0;
+    int bestBits = 64;
+    for (int i = 0; i < number; i++) {
+        FrequencyNormalizer::normalizeToBits(freqs, count, widths[i], norm, order.data());
+        int tableBits = ArchiveWriter::compactTableBits(norm, count);
+        uint64_t tableBytes = ArchiveWriter::tableSize(norm, tableBits, count);
+        if (exactBytes + tableBytes >= bestSize) continue;
+        target.buildHuffmanCodes(norm, count);
+        uint64_t payloadBits = target.encodedBits(freqs, count);
+        if (payloadBits == UINT64_MAX) continue;
+        if (widths[i] == 64) exactBytes = (payloadBits + 7) / 8;
+        uint64_t totalSize = (payloadBits + 7) / 8 + tableBytes;
+        if (totalSize < bestSize) {
+            bestSize = totalSize;
+            bestBits = widths[i];
+        }
+    }
+
+    FrequencyNormalizer::normalizeToBits(freqs, count, bestBits, norm, order.data());
+    target.buildHuffmanCodes(norm, count);
+    return ArchiveWriter::compactTableBits(norm, count);
+}
+
 void FrequencyAnalyzer::analyzeFile(const std::string& filename) {
     std::ifstream file(filename, std::ios::binary);
     if (!file) {
@@ -137,21 +248,26 @@ void FrequencyAnalyzer::analyzeFile(const std::string& filename) {
     uint64_t fileSize = data.size();
     
     std::cout << "File: " << filename << " (size: " << fileSize << " bytes)" << std::endl;
-    std::cout << "Bits\tEB (bytes)\tGB (bytes)\tOverhead" << std::endl;
+    std::cout << "Bits\tEB (bytes)\tTable\tGB (bytes)\tOverhead" << std::endl;
     
-    std::vector<int> bitOptions = {64, 32, 8, 4};
+    int widths[MAX_WIDTHS];
+    int number = normalizationWidths(origFreqs.data(), origFreqs.size(), widths);
     uint64_t bestGB = UINT64_MAX;
     int bestBits = 0;
     
-    for (int bits : bitOptions) {
+    for (int i = 0; i < number; i++) {
+        int bits = widths[i];
         try {
             auto normFreqs = normalizeFrequencies(origFreqs, bits);
             uint64_t compressedBits = calculateCompressedSize(origFreqs, normFreqs);
             uint64_t EB = (compressedBits + 7) / 8;
-            uint64_t GB = EB + 32 * bits; // 256 * bits/8 = 32*bits
+            int tableBits = ArchiveWriter::compactTableBits(normFreqs.data(), normFreqs.size());
+            uint64_t table = ArchiveWriter::tableSize(normFreqs.data(), tableBits, normFreqs.size());
+            uint64_t GB = EB + table;
             double overhead = (GB * 100.0) / fileSize - 100;
             
-            std::cout << bits << "\t" << EB << "\t\t" << GB << "\t\t" << overhead << "%" << std::endl;
+            std::cout << bits << "\t" << EB << "\t\t" << table << "\t" << GB << "\t\t" << overhead << "%"
+                      << std::endl;
             
             if (GB < bestGB) {
                 bestGB = GB;
@@ -165,34 +281,31 @@ void FrequencyAnalyzer::analyzeFile(const std::string& filename) {
     std::cout << "Best bits: " << bestBits << " (GB = " << bestGB << " bytes)" << std::endl << std::endl;
 }
 
-void FrequencyNormalizer::distributeRemainder(std::vector<uint64_t>& normalized, 
-                                            const std::vector<uint64_t>& freqs, int64_t remainder) {
+void FrequencyNormalizer::distributeRemainder(uint64_t* normalized, size_t count, int64_t remainder,
+                                              const uint32_t* order) {
     if (remainder == 0) return;
     
-    // Сортируем индексы по убыванию исходных частот
-    std::vector<size_t> indices(freqs.size());
-    for (size_t i = 0; i < indices.size(); i++) indices[i] = i;
-    
-    std::sort(indices.begin(), indices.end(), [&](size_t a, size_t b) {
-        return freqs[a] > freqs[b];
-    });
-    
+    // order - индексы по убыванию исходных частот
     if (remainder > 0) {
-        // Добавляем к самым частым символам
-        for (size_t i = 0; i < static_cast<size_t>(remainder); i++) {
-            normalized[indices[i % indices.size()]]++;
+        // Добавляем к самым частым символам по кругу. Остаток может быть порядка
+        // targetMax (2^32 при малом числе символов), поэтому полные круги
+        // добавляются сразу, а не по единице.
+        uint64_t rounds = static_cast<uint64_t>(remainder) / count;
+        size_t rest = static_cast<size_t>(static_cast<uint64_t>(remainder) % count);
+        for (size_t i = 0; i < count; i++) {
+            normalized[order[i]] += rounds + (i < rest ? 1 : 0);
         }
     } else {
         // Убираем у самых частых символов, но не ниже 1
         size_t absRemainder = static_cast<size_t>(-remainder);
         for (size_t i = 0; i < absRemainder; i++) {
-            size_t idx = indices[i % indices.size()];
+            size_t idx = order[i % count];
             if (normalized[idx] > 1) {
                 normalized[idx]--;
             } else {
                 // Если нельзя уменьшить, пропускаем этот символ
                 absRemainder++;
-                if (absRemainder > indices.size() * 2) break; // Защита от бесконечного цикла
+                if (absRemainder > count * 2) break; // Защита от бесконечного цикла
             }
         }
     }
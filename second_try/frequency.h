@@ -1,9 +1,11 @@
 #pragma once
 #include "common.h"
+#include "prefix_code.h"
 #include <vector>
 #include <cmath>
 #include <cstring>
 #include <string>
+#include <memory_resource>
 
 class FrequencyAnalyzer {
 public:
@@ -13,15 +15,43 @@ public:
     static uint64_t calculateCompressedSize(const std::vector<uint64_t>& origFreqs, 
                                           const std::vector<uint64_t>& normFreqs);
     
+    // Разрядность нормировки с минимальным итоговым размером (данные + таблица)
+    static int selectBestBits(const std::vector<uint64_t>& freqs);
+    // Разрядности нормировки, которые стоит перебирать: сначала 64 - точные
+    // частоты, затем все подряд до числа бит в сумме частот (шире - частоты
+    // только растягиваются), начиная с последней, где сумма меньше числа
+    // символов (уже неё таблица та же - из единиц).
+    // widths вмещает MAX_WIDTHS значений; возвращает их число
+    static const int MAX_WIDTHS = 64;
+    static int normalizationWidths(const uint64_t* freqs, size_t count, int* widths);
+    // Перебор normalizationWidths для алфавита из count символов. Возвращает
+    // разрядность таблицы для записи (ArchiveWriter::COMPACT_TABLE | ...);
+    // normalized и коды code (buildHuffmanCodes) остаются от лучшей нормировки
+    static int selectTableBits(const uint64_t* freqs, size_t count, uint64_t* normalized, PrefixCode& code,
+                               std::pmr::memory_resource* scratch);
+    
     static void analyzeFile(const std::string& filename);
 };
 
 class FrequencyNormalizer {
 public:
     static std::vector<uint64_t> normalizeToBits(const std::vector<uint64_t>& freqs, int targetBits);
+    // То же в буфер вызывающей стороны; временные массивы берутся из scratch
+    static void normalizeToBits(const uint64_t* freqs, size_t count, int targetBits,
+                                uint64_t* normalized, std::pmr::memory_resource* scratch);
+    // Нормировка к точной сумме targetSum (для tANS - степень двойки);
+    // ненулевые частоты остаются ненулевыми, если targetSum не меньше их числа
+    static void normalizeToSum(const uint64_t* freqs, size_t count, uint64_t targetSum,
+                               uint64_t* normalized, std::pmr::memory_resource* scratch);
+    // Номера символов по убыванию частоты: в этом порядке раздаётся остаток округления
+    static void rankByFrequency(const uint64_t* freqs, size_t count, uint32_t* order);
+    // normalizeToBits с порядком от rankByFrequency - для перебора многих
+    // разрядностей без временных массивов
+    static void normalizeToBits(const uint64_t* freqs, size_t count, int targetBits,
+                                uint64_t* normalized, const uint32_t* order);
     
 private:
-    static std::vector<uint64_t> normalizeToMaxValue(const std::vector<uint64_t>& freqs, uint64_t targetMax);
-    static void distributeRemainder(std::vector<uint64_t>& normalized, 
-                                  const std::vector<uint64_t>& freqs, int64_t remainder);
+    static void normalizeToMaxValue(const uint64_t* freqs, size_t count, uint64_t targetMax,
+                                    uint64_t* normalized, const uint32_t* order);
+    static void distributeRemainder(uint64_t* normalized, size_t count, int64_t remainder, const uint32_t* order);
 };
\ No newline at end of file
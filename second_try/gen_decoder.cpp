@@ -0,0 +1,207 @@
+#include "common.h"
+#include "table_library.h"
+#include "mapped_output.h"
+#include "prefix_code.h"
+#include "fixed_decoder.h"
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+
+// Первичная таблица - как у PrefixCode; вторичные шире 2^MAX_SECONDARY_BITS
+// не строим: такой код лучше декодировать во время выполнения
+static const int PRIMARY_BITS = PrefixCode::LOOKUP_BITS;
+static const int MAX_SECONDARY_BITS = 16;
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--namespace NAME] <output header> <table.htab>" << std::endl;
+    std::cerr << "       " << program << " [--namespace NAME] --samples <output header> <sample files...>" << std::endl;
+    std::cerr << "  Writes constexpr Huffman code and decode tables for a fixed frequency table:" << std::endl;
+    std::cerr << "  a pretrained table file (see trainer) or one trained on the sample files." << std::endl;
+    std::cerr << "  Use them with FixedHuffmanCode<NAME::Table> from fixed_decoder.h" << std::endl;
+}
+
+struct DecodeTables {
+    int maxLength;
+    int primaryBits;
+    std::vector<FixedDecodeEntry> primary;
+    std::vector<FixedDecodeEntry> secondary;
+};
+
+static DecodeTables buildTables(const PrefixCode& code) {
+    DecodeTables tables;
+    tables.maxLength = 0;
+    int present = 0;
+    for (uint32_t symbol = 0; symbol < Common::ALPHABET_SIZE; symbol++) {
+        if (!code.hasCode(symbol)) continue;
+        tables.maxLength = std::max<int>(tables.maxLength, code.code(symbol).length);
+        present++;
+    }
+    if (present < 2) {
+        throw std::runtime_error("Table must have at least two symbols");
+    }
+    tables.primaryBits = std::min(tables.maxLength, PRIMARY_BITS);
+    int primaryBits = tables.primaryBits;
+    tables.primary.assign(size_t(1) << primaryBits, FixedDecodeEntry{0, 0, 0});
+
+    // Короткие коды занимают все индексы со своим префиксом; для длинных
+    // сначала находим ширину вторичной таблицы каждого префикса
+    std::vector<int> subBits(tables.primary.size(), 0);
+    for (uint32_t symbol = 0; symbol < Common::ALPHABET_SIZE; symbol++) {
+        if (!code.hasCode(symbol)) continue;
+        const PrefixCodeEntry& entry = code.code(symbol);
+        if (entry.length <= primaryBits) {
+            int spare = primaryBits - entry.length;
+            uint64_t first = entry.bits << spare;
+            for (uint64_t index = first; index < first + (1ULL << spare); index++) {
+                tables.primary[index] = {symbol, entry.length, 0};
+            }
+        } else {
+            uint64_t prefix = entry.bits >> (entry.length - primaryBits);
+            subBits[prefix] = std::max(subBits[prefix], entry.length - primaryBits);
+        }
+    }
+    for (size_t prefix = 0; prefix < subBits.size(); prefix++) {
+        if (subBits[prefix] == 0) continue;
+        if (subBits[prefix] > MAX_SECONDARY_BITS) {
+            throw std::runtime_error("Codes are too long for fixed decode tables (" +
+                                     std::to_string(tables.maxLength) + " bits)");
+        }
+        tables.primary[prefix] = {static_cast<uint32_t>(tables.secondary.size()), static_cast<uint8_t>(primaryBits),
+                                  static_cast<uint8_t>(subBits[prefix])};
+        tables.secondary.resize(tables.secondary.size() + (size_t(1) << subBits[prefix]), FixedDecodeEntry{0, 0, 0});
+    }
+    for (uint32_t symbol = 0; symbol < Common::ALPHABET_SIZE; symbol++) {
+        if (!code.hasCode(symbol)) continue;
+        const PrefixCodeEntry& entry = code.code(symbol);
+        if (entry.length <= primaryBits) continue;
+        int rest = entry.length - primaryBits;
+        const FixedDecodeEntry& link = tables.primary[entry.bits >> rest];
+        int spare = link.subBits - rest;
+        uint64_t first = link.value + ((entry.bits & ((1ULL << rest) - 1)) << spare);
+        for (uint64_t index = first; index < first + (1ULL << spare); index++) {
+            tables.secondary[index] = {symbol, static_cast<uint8_t>(rest), 0};
+        }
+    }
+    return tables;
+}
+
+template <typename Value, typename Format>
+static void writeArray(std::ostream& out, const char* declaration, const std::vector<Value>& values, size_t perLine,
+                       Format format) {
+    out << "    static constexpr " << declaration << "[" << values.size() << "] = {";
+    for (size_t i = 0; i < values.size(); i++) {
+        out << (i % perLine == 0 ? "\n        " : " ");
+        format(out, values[i]);
+        out << ",";
+    }
+    out << "\n    };\n";
+}
+
+static void writeHeader(std::ostream& out, const std::string& nameSpace, const std::string& source,
+                        const PretrainedTable& table, const PrefixCode& code, const DecodeTables& tables) {
+    std::vector<uint64_t> codes(Common::ALPHABET_SIZE, 0);
+    std::vector<unsigned> lengths(Common::ALPHABET_SIZE, 0);
+    for (uint32_t symbol = 0; symbol < Common::ALPHABET_SIZE; symbol++) {
+        if (!code.hasCode(symbol)) continue;
+        codes[symbol] = code.code(symbol).bits;
+        lengths[symbol] = code.code(symbol).length;
+    }
+    std::vector<FixedDecodeEntry> secondary = tables.secondary;
+    if (secondary.empty()) {
+        secondary.push_back({0, 0, 0});
+    }
+    auto entry = [](std::ostream& out, const FixedDecodeEntry& value) {
+        out << "{" << value.value << ", " << int(value.length) << ", " << int(value.subBits) << "}";
+    };
+
+    out << "// Сгенерировано gen_decoder из " << source << ", не редактировать.\n"
+        << "// Таблица " << TableLibrary::fileName(table.id) << " (" << table.name << ")\n"
+        << "#pragma once\n"
+        << "#include \"fixed_decoder.h\"\n"
+        << "#include <cstdint>\n"
+        << "#include <cstddef>\n\n"
+        << "namespace " << nameSpace << " {\n\n"
+        << "struct Table {\n"
+        << "    static constexpr uint32_t ID = 0x" << std::hex << table.id << std::dec << ";\n"
+        << "    static constexpr int MAX_CODE_LENGTH = " << tables.maxLength << ";\n"
+        << "    static constexpr int PRIMARY_BITS = " << tables.primaryBits << ";\n"
+        << "    static constexpr size_t SECONDARY_SIZE = " << tables.secondary.size() << ";\n\n";
+    writeArray(out, "uint64_t frequencies", table.frequencies, 8,
+               [](std::ostream& out, uint64_t value) { out << value; });
+    writeArray(out, "uint64_t codes", codes, 6, [](std::ostream& out, uint64_t value) {
+        out << "0x" << std::hex << std::setw(8) << std::setfill('0') << value << std::dec << std::setfill(' ');
+    });
+    writeArray(out, "uint8_t lengths", lengths, 16, [](std::ostream& out, unsigned value) { out << value; });
+    writeArray(out, "FixedDecodeEntry primary", tables.primary, 4, entry);
+    writeArray(out, "FixedDecodeEntry secondary", secondary, 4, entry);
+    out << "};\n\n"
+        << "using Code = FixedHuffmanCode<Table>;\n\n"
+        << "} // namespace " << nameSpace << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string nameSpace = "FixedTable";
+    bool samples = false;
+    int arg = 1;
+    while (arg < argc && std::string(argv[arg]).rfind("--", 0) == 0) {
+        std::string option = argv[arg];
+        if (option == "--namespace" && arg + 1 < argc) {
+            nameSpace = argv[arg + 1];
+            arg += 2;
+        } else if (option == "--samples") {
+            samples = true;
+            arg++;
+        } else {
+            std::cerr << "Unknown option: " << option << std::endl;
+            return 1;
+        }
+    }
+    if (argc - arg < 2 || (!samples && argc - arg != 2)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    std::string outputFile = argv[arg];
+
+    try {
+        PretrainedTable table;
+        std::string source = argv[arg + 1];
+        if (samples) {
+            std::vector<uint64_t> counts(Common::ALPHABET_SIZE, 0);
+            for (int i = arg + 1; i < argc; i++) {
+                MappedInput input(argv[i]);
+                for (size_t j = 0; j < input.size(); j++) {
+                    counts[input.data()[j]]++;
+                }
+            }
+            if (argc - arg > 2) source += " and " + std::to_string(argc - arg - 2) + " more";
+            table = PretrainedTable::train(nameSpace, counts.data());
+        } else {
+            table = PretrainedTable::load(source);
+        }
+
+        PrefixCode code;
+        code.buildHuffman(table.frequencies.data(), Common::ALPHABET_SIZE);
+        DecodeTables tables = buildTables(code);
+
+        // Пишем через временную строку: при ошибке не остаётся обрезанного заголовка
+        std::ostringstream text;
+        writeHeader(text, nameSpace, source, table, code, tables);
+        std::ofstream out(outputFile, std::ios::binary);
+        out << text.str();
+        if (!out) {
+            throw std::runtime_error("Cannot write " + outputFile);
+        }
+        std::cout << "Generated " << outputFile << ": table " << TableLibrary::fileName(table.id)
+                  << ", codes up to " << tables.maxLength << " bits, " << tables.primary.size() << " + "
+                  << tables.secondary.size() << " decode entries" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Generation error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -125,13 +125,16 @@ void HuffmanDecoder::buildTree(const std::vector<uint64_t>& frequencies) {
 }
 
 std::vector<uint8_t> HuffmanDecoder::decodeData(BitInputStream& in, size_t originalSize) const {
+    std::vector<uint8_t> result(originalSize);
+    decodeData(in, result.data(), originalSize);
+    return result;
+}
+
+void HuffmanDecoder::decodeData(BitInputStream& in, uint8_t* out, size_t originalSize) const {
     if (!root) {
         throw std::runtime_error("Huffman tree not initialized for decoding");
     }
     
-    std::vector<uint8_t> result;
-    result.reserve(originalSize);
-    
     HuffmanNode* current = root;
     
     for (size_t i = 0; i < originalSize; i++) {
@@ -151,10 +154,8 @@ std::vector<uint8_t> HuffmanDecoder::decodeData(BitInputStream& in, size_t origi
             }
         }
         
-        result.push_back(current->symbol);
+        out[i] = current->symbol;
     }
-    
-    return result;
 }
 
 void HuffmanDecoder::clearTree(HuffmanNode* node) {
@@ -56,6 +56,8 @@ public:
     ~HuffmanDecoder();
     
     std::vector<uint8_t> decodeData(BitInputStream& in, size_t originalSize) const;
+    // Декодирует originalSize символов прямо в out (например, в отображённый файл)
+    void decodeData(BitInputStream& in, uint8_t* out, size_t originalSize) const;
     
 private:
     void buildTree(const std::vector<uint64_t>& frequencies);
@@ -0,0 +1,336 @@
+#include "lz77.h"
+#include "archive_format.h"
+#include "frequency.h"
+#include "bitstream.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    struct LevelParams {
+        uint32_t chainLength;  // сколько кандидатов цепочки просматривается
+        uint32_t goodLength;   // при таком уже найденном совпадении ленивый поиск вчетверо короче
+        uint32_t niceLength;   // совпадение такой длины принимается сразу
+        bool lazy;             // проверять, не лучше ли совпадение со следующей позиции
+        bool insertAll;        // добавлять в цепочки позиции внутри совпадений
+    };
+
+    const LevelParams LEVELS[] = {
+        {4, 4, 16, false, false},
+        {8, 4, 32, false, false},
+        {16, 4, 32, false, true},
+        {16, 4, 32, true, true},
+        {32, 8, 64, true, true},
+        {128, 8, 128, true, true},
+        {256, 8, 258, true, true},
+        {1024, 32, 258, true, true},
+        {4096, 32, 258, true, true},
+    };
+
+    // Совпадение минимальной длины на таком расстоянии обходится дороже литералов
+    const uint32_t MIN_MATCH_MAX_DISTANCE = 4096;
+
+    uint32_t read32(const uint8_t* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint32_t matchLength(const uint8_t* a, const uint8_t* b, uint32_t maxLength) {
+        uint32_t length = 0;
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        // По 8 байт: номер первого различающегося байта - младший ненулевой бит разности
+        while (length + 8 <= maxLength) {
+            uint64_t x, y;
+            std::memcpy(&x, a + length, sizeof(x));
+            std::memcpy(&y, b + length, sizeof(y));
+            if (x != y) {
+                return length + (__builtin_ctzll(x ^ y) >> 3);
+            }
+            length += 8;
+        }
+#endif
+        while (length < maxLength && a[length] == b[length]) {
+            length++;
+        }
+        return length;
+    }
+
+    // Корзина значения: 0..3 - сами значения, дальше по две корзины на степень
+    // двойки (старший бит и следующий за ним), остальные биты - дополнительные
+    struct Bucket {
+        uint32_t code;
+        int extraBits;
+        uint32_t extra;
+    };
+
+    Bucket bucketOf(uint32_t value) {
+        if (value < 4) {
+            return {value, 0, 0};
+        }
+        int high = 31 - __builtin_clz(value);
+        int extraBits = high - 1;
+        return {static_cast<uint32_t>(2 * high) + ((value >> extraBits) & 1), extraBits,
+                value & ((1u << extraBits) - 1)};
+    }
+
+    void writeBucket(BitWriter& out, const Bucket& bucket) {
+        if (bucket.extraBits > 0) {
+            out.writeBits(bucket.extra, bucket.extraBits);
+        }
+    }
+
+    uint32_t readBucket(BitReader& in, uint32_t code) {
+        if (code < 4) {
+            return code;
+        }
+        int extraBits = static_cast<int>(code / 2) - 1;
+        uint32_t value = (2 | (code & 1)) << extraBits;
+        value |= in.peekBits(extraBits);
+        in.skipBits(extraBits);
+        return value;
+    }
+}
+
+Lz77Code::Lz77Code(std::pmr::memory_resource* resource)
+    : window(DEFAULT_WINDOW_LOG),
+      effort(DEFAULT_LEVEL),
+      hashLog(HASH_LOG),
+      chainMask(0),
+      head(resource),
+      chain(resource),
+      tokens(resource),
+      litlenFreqs(LITLEN_SYMBOLS, 0, resource),
+      distanceFreqs(DISTANCE_SYMBOLS, 0, resource),
+      normalized(LITLEN_SYMBOLS, 0, resource),
+      litlenCode(resource),
+      distanceCode(resource),
+      matchCount(0),
+      matchedBytes(0) {}
+
+void Lz77Code::configure(int windowLog, int level) {
+    if (windowLog < MIN_WINDOW_LOG || windowLog > MAX_WINDOW_LOG) {
+        throw std::invalid_argument("LZ77 window log must be in [" + std::to_string(MIN_WINDOW_LOG) + ", " +
+                                    std::to_string(MAX_WINDOW_LOG) + "]");
+    }
+    if (level < MIN_LEVEL || level > MAX_LEVEL) {
+        throw std::invalid_argument("LZ77 level must be in [" + std::to_string(MIN_LEVEL) + ", " +
+                                    std::to_string(MAX_LEVEL) + "]");
+    }
+    window = windowLog;
+    effort = level;
+}
+
+void Lz77Code::insert(const uint8_t* src, uint32_t pos) {
+    uint32_t hash = (read32(src + pos) * 2654435761u) >> (32 - hashLog);
+    chain[pos & chainMask] = head[hash];
+    head[hash] = static_cast<int32_t>(pos);
+}
+
+Lz77Code::Match Lz77Code::findMatch(const uint8_t* src, size_t size, uint32_t pos, uint32_t chainLength) const {
+    Match best = {0, 0};
+    if (size - pos < MIN_MATCH) return best;
+
+    const LevelParams& params = LEVELS[effort - 1];
+    uint32_t maxLength = size - pos < MAX_MATCH ? static_cast<uint32_t>(size - pos) : MAX_MATCH;
+    uint32_t windowSize = 1u << window;
+    const uint8_t* current = src + pos;
+
+    // Позиция pos в цепочки ещё не добавлена, поэтому все кандидаты левее неё
+    int32_t candidate = head[(read32(current) * 2654435761u) >> (32 - hashLog)];
+    for (uint32_t steps = chainLength; candidate >= 0 && steps > 0; steps--) {
+        uint32_t distance = pos - static_cast<uint32_t>(candidate);
+        if (distance >= windowSize) break;
+
+        const uint8_t* previous = src + candidate;
+        // Кандидат не длиннее лучшего, если не совпадает байт сразу за ним
+        if (previous[best.length] == current[best.length]) {
+            uint32_t length = matchLength(previous, current, maxLength);
+            if (length > best.length && (length > MIN_MATCH || distance <= MIN_MATCH_MAX_DISTANCE)) {
+                best = {length, distance};
+                if (length >= params.niceLength || length == maxLength) break;
+            }
+        }
+        candidate = chain[candidate & chainMask];
+    }
+
+    if (best.length < MIN_MATCH) {
+        best.length = 0;
+    }
+    return best;
+}
+
+void Lz77Code::addLiteral(uint8_t literal) {
+    tokens.push_back({literal, 0});
+    litlenFreqs[literal]++;
+}
+
+void Lz77Code::addMatch(const Match& match) {
+    tokens.push_back({match.length, match.distance});
+    litlenFreqs[Common::ALPHABET_SIZE + bucketOf(match.length - MIN_MATCH).code]++;
+    distanceFreqs[bucketOf(match.distance - 1).code]++;
+    matchCount++;
+    matchedBytes += match.length;
+}
+
+void Lz77Code::parse(const uint8_t* src, size_t size) {
+    const LevelParams& params = LEVELS[effort - 1];
+    tokens.clear();
+    std::fill(litlenFreqs.begin(), litlenFreqs.end(), 0);
+    std::fill(distanceFreqs.begin(), distanceFreqs.end(), 0);
+    matchCount = 0;
+    matchedBytes = 0;
+
+    // Кольцо цепочек не больше окна и не больше входа (округлённого до степени двойки)
+    int chainLog = MIN_HASH_LOG;
+    while (chainLog < window && (size_t(1) << chainLog) < size) {
+        chainLog++;
+    }
+    hashLog = std::min(chainLog + 1, HASH_LOG);
+    chainMask = (1u << chainLog) - 1;
+    head.assign(size_t(1) << hashLog, -1);
+    chain.resize(size_t(1) << chainLog);
+
+    // Хеш читает 4 байта, поэтому последние MIN_MATCH - 1 позиций в цепочки не попадают
+    const uint32_t hashable = size >= MIN_MATCH ? static_cast<uint32_t>(size - MIN_MATCH + 1) : 0;
+    uint32_t inserted = 0;  // позиции левее уже добавлены в цепочки
+    auto insertUpTo = [&](uint32_t limit) {
+        limit = std::min(limit, hashable);
+        for (; inserted < limit; inserted++) {
+            insert(src, inserted);
+        }
+    };
+
+    uint32_t pos = 0;
+    Match match = {0, 0};
+    bool pending = false;  // match уже найдено ленивой проверкой
+    while (pos < size) {
+        if (!pending) {
+            insertUpTo(pos);
+            match = findMatch(src, size, pos, params.chainLength);
+        }
+        pending = false;
+
+        if (match.length == 0) {
+            addLiteral(src[pos]);
+            pos++;
+            continue;
+        }
+
+        if (params.lazy && match.length < params.niceLength && pos + 1 < size) {
+            insertUpTo(pos + 1);
+            uint32_t chainLength = match.length >= params.goodLength ? params.chainLength >> 2 : params.chainLength;
+            Match next = findMatch(src, size, pos + 1, chainLength > 0 ? chainLength : 1);
+            if (next.length > match.length) {
+                addLiteral(src[pos]);
+                pos++;
+                match = next;
+                pending = true;
+                continue;
+            }
+        }
+
+        addMatch(match);
+        pos += match.length;
+        if (!params.insertAll) {
+            // Быстрые уровни не индексируют внутренность совпадения
+            inserted = std::max(inserted, pos);
+        }
+    }
+}
+
+size_t Lz77Code::encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity,
+                        std::pmr::memory_resource* scratch) {
+    if (size > INT32_MAX) {
+        throw std::length_error("LZ77 input is limited to 2 GB per call");
+    }
+    parse(src, size);
+
+    size_t offset = 2;
+    if (capacity < offset) {
+        throw std::length_error("Destination buffer too small");
+    }
+
+    int litlenBits = FrequencyAnalyzer::selectTableBits(litlenFreqs.data(), LITLEN_SYMBOLS, normalized.data(),
+                                                        litlenCode, scratch);
+    size_t tableSize = ArchiveWriter::tableSize(normalized.data(), litlenBits, LITLEN_SYMBOLS);
+    if (capacity - offset < tableSize) {
+        throw std::length_error("Destination buffer too small");
+    }
+    dst[0] = static_cast<uint8_t>(litlenBits);
+    offset += ArchiveWriter::writeFrequencies(dst + offset, normalized.data(), litlenBits, LITLEN_SYMBOLS);
+
+    int distanceBits = FrequencyAnalyzer::selectTableBits(distanceFreqs.data(), DISTANCE_SYMBOLS, normalized.data(),
+                                                          distanceCode, scratch);
+    tableSize = ArchiveWriter::tableSize(normalized.data(), distanceBits, DISTANCE_SYMBOLS);
+    if (capacity - offset < tableSize) {
+        throw std::length_error("Destination buffer too small");
+    }
+    dst[1] = static_cast<uint8_t>(distanceBits);
+    offset += ArchiveWriter::writeFrequencies(dst + offset, normalized.data(), distanceBits, DISTANCE_SYMBOLS);
+
+    BitWriter out(dst + offset, capacity - offset);
+    for (const Token& token : tokens) {
+        if (token.distance == 0) {
+            litlenCode.encodeSymbol(token.value, out);
+            continue;
+        }
+        Bucket length = bucketOf(token.value - MIN_MATCH);
+        litlenCode.encodeSymbol(Common::ALPHABET_SIZE + length.code, out);
+        writeBucket(out, length);
+        Bucket distance = bucketOf(token.distance - 1);
+        distanceCode.encodeSymbol(distance.code, out);
+        writeBucket(out, distance);
+    }
+    out.flush();
+    return offset + out.bytesWritten();
+}
+
+void Lz77Code::decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size) {
+    if (srcSize < 2) {
+        throw std::runtime_error("LZ77 stream is truncated");
+    }
+    int litlenBits = src[0];
+    int distanceBits = src[1];
+
+    size_t offset = 2;
+    offset += ArchiveWriter::readFrequencies(src + offset, srcSize - offset, litlenBits, litlenFreqs.data(),
+                                             LITLEN_SYMBOLS);
+    litlenCode.buildHuffman(litlenFreqs.data(), LITLEN_SYMBOLS);
+    offset += ArchiveWriter::readFrequencies(src + offset, srcSize - offset, distanceBits, distanceFreqs.data(),
+                                             DISTANCE_SYMBOLS);
+    distanceCode.buildHuffman(distanceFreqs.data(), DISTANCE_SYMBOLS);
+
+    BitReader in(src + offset, srcSize - offset);
+    size_t pos = 0;
+    while (pos < size) {
+        uint32_t symbol = litlenCode.decodeSymbol(in);
+        if (symbol < Common::ALPHABET_SIZE) {
+            dst[pos++] = static_cast<uint8_t>(symbol);
+            continue;
+        }
+
+        uint32_t length = MIN_MATCH + readBucket(in, symbol - Common::ALPHABET_SIZE);
+        uint32_t distance = 1 + readBucket(in, distanceCode.decodeSymbol(in));
+        if (distance > pos || length > size - pos) {
+            throw std::runtime_error("Corrupted LZ77 stream: match out of range");
+        }
+
+        uint8_t* out = dst + pos;
+        const uint8_t* from = out - distance;
+        if (distance >= length) {
+            std::memcpy(out, from, length);
+        } else {
+            // Перекрывающееся копирование повторяет последние distance байт
+            for (uint32_t i = 0; i < length; i++) {
+                out[i] = from[i];
+            }
+        }
+        pos += length;
+    }
+
+    if (in.overrun()) {
+        throw std::runtime_error("Unexpected end of stream during decoding");
+    }
+}
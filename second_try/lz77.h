@@ -0,0 +1,90 @@
+// lz77.h - поиск повторов LZ77 на хеш-цепочках с кодированием Хаффманом
+#pragma once
+#include "common.h"
+#include "prefix_code.h"
+#include <memory_resource>
+#include <cstdint>
+#include <cstddef>
+
+// Вход разбирается на литералы и совпадения (длина, расстояние).
+// Литералы и длины кодируются общим кодом Хаффмана на алфавите
+// LITLEN_SYMBOLS = 256 литералов + LENGTH_CODES кодов длины, расстояния -
+// отдельным кодом на DISTANCE_SYMBOLS символов. Длина и расстояние
+// разбиваются на логарифмические корзины: код корзины и дополнительные биты.
+//
+// Формат данных: разрядность таблицы литералов/длин (1 байт), разрядность
+// таблицы расстояний (1 байт), обе таблицы частот в формате ArchiveWriter,
+// затем поток кодов старшими битами вперёд.
+class Lz77Code {
+public:
+    static const uint32_t MIN_MATCH = 4;
+    static const uint32_t MAX_MATCH = MIN_MATCH + 65535;
+    static const uint32_t LENGTH_CODES = 32;  // корзины для MAX_MATCH - MIN_MATCH < 2^16
+    static const uint32_t LITLEN_SYMBOLS = Common::ALPHABET_SIZE + LENGTH_CODES;
+
+    static const int MIN_WINDOW_LOG = 10;
+    static const int MAX_WINDOW_LOG = 24;
+    static const int DEFAULT_WINDOW_LOG = 20;
+    static const uint32_t DISTANCE_SYMBOLS = 2 * MAX_WINDOW_LOG;
+
+    // Уровни усилий поиска: длина просматриваемой цепочки, "достаточная"
+    // длина совпадения и ленивый разбор (проверка совпадения со следующей позиции)
+    static const int MIN_LEVEL = 1;
+    static const int MAX_LEVEL = 9;
+    static const int DEFAULT_LEVEL = 5;
+
+    explicit Lz77Code(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // std::invalid_argument при параметрах вне допустимых границ
+    void configure(int windowLog, int level);
+    int windowLog() const { return window; }
+    int level() const { return effort; }
+
+    // Возвращает размер закодированных данных; std::length_error, если не хватает места.
+    // Временные массивы нормировки берутся из scratch.
+    size_t encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity,
+                  std::pmr::memory_resource* scratch);
+    void decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size);
+
+    // Статистика последнего encode
+    uint64_t lastMatches() const { return matchCount; }
+    uint64_t lastMatchedBytes() const { return matchedBytes; }
+
+private:
+    struct Token {
+        uint32_t value;     // литерал или длина совпадения
+        uint32_t distance;  // 0 - литерал
+    };
+
+    struct Match {
+        uint32_t length;
+        uint32_t distance;
+    };
+
+    // constexpr: std::min принимает по ссылке, нужно определение и без -O2
+    static constexpr int HASH_LOG = 17;
+    static const int MIN_HASH_LOG = 8;
+
+    void parse(const uint8_t* src, size_t size);
+    void insert(const uint8_t* src, uint32_t pos);
+    Match findMatch(const uint8_t* src, size_t size, uint32_t pos, uint32_t chainLength) const;
+    void addLiteral(uint8_t literal);
+    void addMatch(const Match& match);
+
+    int window;
+    int effort;
+    // Таблицы поиска подгоняются под размер входа, чтобы короткие сообщения
+    // не платили за очистку полного окна
+    int hashLog;
+    uint32_t chainMask;
+    std::pmr::vector<int32_t> head;
+    std::pmr::vector<int32_t> chain;
+    std::pmr::vector<Token> tokens;
+    std::pmr::vector<uint64_t> litlenFreqs;
+    std::pmr::vector<uint64_t> distanceFreqs;
+    std::pmr::vector<uint64_t> normalized;
+    PrefixCode litlenCode;
+    PrefixCode distanceCode;
+    uint64_t matchCount;
+    uint64_t matchedBytes;
+};
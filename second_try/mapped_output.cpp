@@ -0,0 +1,175 @@
+#include "mapped_output.h"
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Свободное имя рядом с целевым файлом: rename() внутри одной файловой
+// системы атомарен. Файл создаётся с O_EXCL, права - как у нового файла
+static int createTemporary(const std::string& filename, std::string& tempPath) {
+    size_t slash = filename.rfind('/');
+    std::string directory = slash == std::string::npos ? "" : filename.substr(0, slash + 1);
+    std::string base = slash == std::string::npos ? filename : filename.substr(slash + 1);
+    for (unsigned attempt = 0; attempt < 100; attempt++) {
+        tempPath = directory + "." + base + "." + std::to_string(getpid()) + "." + std::to_string(attempt) + ".tmp";
+        int fd = open(tempPath.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd >= 0 || errno != EEXIST) return fd;
+    }
+    return -1;
+}
+
+MappedOutput::MappedOutput(const std::string& filename, uint64_t size)
+    : path(filename), fd(-1), regular(false), length(size), mapping(nullptr), committed(false) {
+    // Обычный файл или новое имя - пишем во временный файл, прежний не трогаем
+    struct stat named;
+    bool exists = lstat(filename.c_str(), &named) == 0;
+    if (!exists || S_ISREG(named.st_mode)) {
+        if (exists && access(filename.c_str(), W_OK) != 0) {
+            throw std::runtime_error("Cannot create output file: " + filename + " (" + std::strerror(errno) + ")");
+        }
+        fd = createTemporary(filename, tempPath);
+        if (fd < 0) {
+            tempPath.clear();
+            throw std::runtime_error("Cannot create output file: " + filename + " (" + std::strerror(errno) + ")");
+        }
+        if (exists) fchmod(fd, named.st_mode & 07777);
+    } else {
+        fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    }
+    if (fd < 0) {
+        // Каналы, открытые только на запись (например, /dev/stdout)
+        fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create output file: " + filename + " (" + std::strerror(errno) + ")");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        discard();
+        close(fd);
+        throw std::runtime_error("Cannot stat output file: " + filename);
+    }
+
+    regular = S_ISREG(st.st_mode);
+    if (regular && length > 0) {
+        if (ftruncate(fd, static_cast<off_t>(length)) != 0) {
+            discard();
+            close(fd);
+            throw std::runtime_error("Cannot resize output file: " + filename + " (" + std::strerror(errno) + ")");
+        }
+        void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ptr != MAP_FAILED) {
+            mapping = static_cast<uint8_t*>(ptr);
+            return;
+        }
+        // Отображение не удалось (например, файловая система без mmap) - буферизуем
+    }
+
+    buffer.resize(length);
+}
+
+MappedOutput::~MappedOutput() {
+    if (mapping) munmap(mapping, length);
+    if (fd >= 0) {
+        if (!committed && regular) discard();
+        close(fd);
+    }
+}
+
+bool MappedOutput::discard() {
+    if (!tempPath.empty()) {
+        return unlink(tempPath.c_str()) == 0;
+    }
+    // Удаляем по имени, только если оно указывает на тот же файл: путь вида
+    // /dev/stdout - ссылка на чужой файл, его достаточно обрезать
+    struct stat own;
+    struct stat named;
+    if (fstat(fd, &own) == 0 && lstat(path.c_str(), &named) == 0 && S_ISREG(named.st_mode) &&
+        own.st_dev == named.st_dev && own.st_ino == named.st_ino) {
+        return unlink(path.c_str()) == 0;
+    }
+    return ftruncate(fd, 0) == 0;
+}
+
+uint8_t* MappedOutput::region(uint64_t offset, uint64_t count) {
+    if (offset > length || count > length - offset) {
+        throw std::out_of_range("Output region exceeds file size");
+    }
+    return data() + offset;
+}
+
+void MappedOutput::commit() {
+    if (committed) return;
+
+    if (mapping) {
+        munmap(mapping, length);
+        mapping = nullptr;
+    } else {
+        const uint8_t* ptr = buffer.data();
+        uint64_t remaining = buffer.size();
+        while (remaining > 0) {
+            ssize_t written = write(fd, ptr, remaining);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(std::string("Write error: ") + std::strerror(errno));
+            }
+            ptr += written;
+            remaining -= static_cast<uint64_t>(written);
+        }
+        buffer.clear();
+        buffer.shrink_to_fit();
+    }
+    committed = true;
+
+    if (close(fd) != 0) {
+        fd = -1;
+        if (!tempPath.empty()) unlink(tempPath.c_str());
+        throw std::runtime_error(std::string("Close error: ") + std::strerror(errno));
+    }
+    fd = -1;
+    if (!tempPath.empty() && rename(tempPath.c_str(), path.c_str()) != 0) {
+        int error = errno;
+        unlink(tempPath.c_str());
+        throw std::runtime_error("Cannot replace output file: " + path + " (" + std::strerror(error) + ")");
+    }
+}
+
+MappedInput::MappedInput(const std::string& filename) : length(0), mapping(nullptr) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open input file: " + filename + " (" + std::strerror(errno) + ")");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* ptr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr != MAP_FAILED) {
+            mapping = static_cast<uint8_t*>(ptr);
+            length = static_cast<uint64_t>(st.st_size);
+            close(fd);
+            return;
+        }
+    }
+
+    uint8_t chunk[1 << 16];
+    for (;;) {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            close(fd);
+            throw std::runtime_error(std::string("Read error: ") + std::strerror(errno));
+        }
+        if (n == 0) break;
+        buffer.insert(buffer.end(), chunk, chunk + n);
+    }
+    close(fd);
+    length = buffer.size();
+}
+
+MappedInput::~MappedInput() {
+    if (mapping) munmap(mapping, length);
+}
@@ -0,0 +1,71 @@
+// mapped_output.h - входной и выходной файлы, отображённые в память
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Выходной файл заранее заданного размера. Для обычных файлов размер
+// выставляется через ftruncate, а файл отображается в память на запись,
+// так что декодеры пишут результат прямо в страницы файла.
+// Для каналов (pipe, FIFO, терминал) используется буфер в памяти,
+// который сбрасывается обычными write в commit().
+// Обычный файл пишется во временный файл рядом с целевым и заменяет его
+// через rename() в commit(): если декодирование прервалось исключением,
+// временный файл удаляется, а прежний файл с этим именем остаётся цел.
+// Устройства и символические ссылки (например, /dev/stdout) пишутся на
+// месте; незавершённый обычный файл за ними обрезается до нуля.
+class MappedOutput {
+public:
+    MappedOutput(const std::string& filename, uint64_t size);
+    ~MappedOutput();
+
+    MappedOutput(const MappedOutput&) = delete;
+    MappedOutput& operator=(const MappedOutput&) = delete;
+
+    uint8_t* data() { return mapping ? mapping : buffer.data(); }
+    uint64_t size() const { return length; }
+    bool isMapped() const { return mapping != nullptr; }
+
+    // Область [offset, offset + count) для отдельного потока декодирования.
+    // Непересекающиеся области можно заполнять параллельно.
+    uint8_t* region(uint64_t offset, uint64_t count);
+
+    // Завершает запись: сбрасывает отображение или буфер в файл и
+    // ставит временный файл на место целевого
+    void commit();
+
+private:
+    // Удаляет временный или обрезает незавершённый файл
+    bool discard();
+
+    std::string path;
+    std::string tempPath;
+    int fd;
+    bool regular;
+    uint64_t length;
+    uint8_t* mapping;
+    std::vector<uint8_t> buffer;
+    bool committed;
+};
+
+// Входной файл только для чтения. Обычный файл отображается в память, и
+// читаются лишь те страницы, к которым обращается декодер; канал или
+// файл, который не удалось отобразить, читается в буфер целиком.
+class MappedInput {
+public:
+    explicit MappedInput(const std::string& filename);
+    ~MappedInput();
+
+    MappedInput(const MappedInput&) = delete;
+    MappedInput& operator=(const MappedInput&) = delete;
+
+    const uint8_t* data() const { return mapping ? mapping : buffer.data(); }
+    uint64_t size() const { return length; }
+    bool isMapped() const { return mapping != nullptr; }
+
+private:
+    uint64_t length;
+    uint8_t* mapping;
+    std::vector<uint8_t> buffer;
+};
@@ -0,0 +1,88 @@
+#include "ordered_key.h"
+#include "bitstream.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+OrderedKeyCodec::OrderedKeyCodec(const PretrainedTable& table, size_t averageKeySize)
+    : code(&pool), id(table.id), maxLength(0) {
+    if (averageKeySize == 0) {
+        throw std::invalid_argument("Average key size must be positive");
+    }
+    std::vector<uint64_t> freqs(KEY_ALPHABET_SIZE);
+    uint64_t total = 0;
+    for (size_t i = 0; i < Common::ALPHABET_SIZE; i++) {
+        freqs[i + 1] = table.frequencies[i];
+        total += table.frequencies[i];
+    }
+    freqs[END_SYMBOL] = std::max<uint64_t>(total / averageKeySize, 1);
+    code.buildAlphabetic(freqs.data(), KEY_ALPHABET_SIZE);
+    for (uint32_t symbol = 0; symbol < KEY_ALPHABET_SIZE; symbol++) {
+        if (!code.hasCode(symbol)) {
+            throw std::invalid_argument("Key table must give every byte a nonzero frequency");
+        }
+        maxLength = std::max<int>(maxLength, code.code(symbol).length);
+    }
+}
+
+size_t OrderedKeyCodec::keyBound(size_t size) const {
+    return ((static_cast<uint64_t>(size) + 1) * maxLength + 7) / 8;
+}
+
+size_t OrderedKeyCodec::encode(const uint8_t* src, size_t size, uint8_t* dst, size_t dstCapacity) const {
+    BitWriter out(dst, dstCapacity);
+    for (size_t i = 0; i < size; i++) {
+        code.encodeSymbol(src[i] + 1u, out);
+    }
+    code.encodeSymbol(END_SYMBOL, out);
+    out.flush();
+    return out.bytesWritten();
+}
+
+size_t OrderedKeyCodec::decode(const uint8_t* src, size_t size, uint8_t* dst, size_t dstCapacity) const {
+    // За концом данных BitReader читает нули, а код из нулей - у символа
+    // конца (он первый по порядку), так что обрезанный ключ тоже кончается
+    BitReader in(src, size);
+    size_t length = 0;
+    for (uint32_t symbol = code.decodeSymbol(in); symbol != END_SYMBOL; symbol = code.decodeSymbol(in)) {
+        if (length >= dstCapacity) {
+            throw std::length_error("Destination buffer too small");
+        }
+        dst[length++] = static_cast<uint8_t>(symbol - 1);
+    }
+    if (in.overrun()) {
+        throw std::runtime_error("Key is truncated");
+    }
+    return length;
+}
+
+int OrderedKeyCodec::compare(const uint8_t* a, size_t aSize, const uint8_t* b, size_t bSize) {
+    // Коды разных ключей расходятся не позже символа конца, то есть внутри
+    // обоих ключей; сравнение длин - на случай ключей разных таблиц
+    int result = std::memcmp(a, b, std::min(aSize, bSize));
+    if (result != 0) return result;
+    return aSize < bSize ? -1 : (aSize > bSize ? 1 : 0);
+}
+
+int OrderedKeyCodec::compareWithKey(const uint8_t* compressed, size_t compressedSize, const uint8_t* key,
+                                    size_t keySize) const {
+    BitReader in(compressed, compressedSize);
+    for (size_t i = 0; i <= keySize; i++) {
+        const PrefixCodeEntry& entry = code.code(i < keySize ? key[i] + 1u : END_SYMBOL);
+        // Коды разных символов не префиксы друг друга: первые entry.length
+        // бит сжатого ключа либо совпадают с кодом, либо упорядочены как символы
+        int length = entry.length;
+        while (length > 0) {
+            int count = std::min(length, 32);
+            uint64_t expected = (entry.bits >> (length - count)) & ((1ULL << count) - 1);
+            uint64_t actual = in.peekBits(count);
+            if (actual != expected) {
+                return actual < expected ? -1 : 1;
+            }
+            in.skipBits(count);
+            length -= count;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+// ordered_key.h - сжатые ключи, которые сравниваются без распаковки
+#pragma once
+#include "common.h"
+#include "prefix_code.h"
+#include "table_library.h"
+#include <memory_resource>
+#include <cstdint>
+#include <cstddef>
+
+// Сжатие ключей (индексы, сортировка, бинарный поиск) алфавитным кодом
+// Ху-Такера по внешней обученной таблице (PretrainedTable). Код сохраняет
+// порядок: memcmp двух сжатых ключей одной таблицы даёт тот же знак, что и
+// сравнение исходных байтов, а равные ключи сжимаются одинаково. За байтами
+// ключа идёт символ конца, меньший любого байта, - поэтому ключ меньше своих
+// продолжений, - и нули до границы байта. Длина не хранится: сжатый ключ
+// кончается символом конца, его размер в байтах хранит вызывающая сторона.
+// Как и RecordCodec, код строится в конструкторе, остальные методы не меняют
+// объект и не выделяют память.
+class OrderedKeyCodec {
+public:
+    // Символ конца встречается раз на ключ, его частота берётся из средней длины ключа
+    static const size_t DEFAULT_KEY_SIZE = 16;
+
+    explicit OrderedKeyCodec(const PretrainedTable& table, size_t averageKeySize = DEFAULT_KEY_SIZE);
+
+    uint32_t tableId() const { return id; }
+
+    // Наибольший размер сжатого ключа из size байт
+    size_t keyBound(size_t size) const;
+
+    // Возвращает размер сжатого ключа в dst; std::length_error, если не хватает места
+    size_t encode(const uint8_t* src, size_t size, uint8_t* dst, size_t dstCapacity) const;
+    // Распаковывает ключ, возвращает его размер. Не хватает места -
+    // std::length_error, ключ обрезан - std::runtime_error
+    size_t decode(const uint8_t* src, size_t size, uint8_t* dst, size_t dstCapacity) const;
+
+    // Сравнение двух сжатых ключей одной таблицы: < 0, 0 или > 0, как у исходных
+    static int compare(const uint8_t* a, size_t aSize, const uint8_t* b, size_t bSize);
+    // Сравнение сжатого ключа с несжатым: коды key сверяются с битами
+    // сжатого ключа по мере кодирования, до первого различия - без буфера
+    // и без распаковки (бинарный поиск по сжатым ключам)
+    int compareWithKey(const uint8_t* compressed, size_t compressedSize, const uint8_t* key, size_t keySize) const;
+
+private:
+    // Символ конца - 0, байт b - символ b + 1
+    static const uint32_t END_SYMBOL = 0;
+    static const size_t KEY_ALPHABET_SIZE = Common::ALPHABET_SIZE + 1;
+
+    std::pmr::unsynchronized_pool_resource pool;
+    PrefixCode code;
+    uint32_t id;
+    int maxLength;
+};
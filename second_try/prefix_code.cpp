@@ -0,0 +1,467 @@
+#include "prefix_code.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+PrefixCode::PrefixCode(std::pmr::memory_resource* resource)
+    : codes(resource), present(resource), trie(resource), lookup(resource),
+      canonical(false), canonicalLength(0), canonicalSymbols(resource),
+      buildNodes(resource), internal(resource), frames(resource), sorted(resource) {}
+
+void PrefixCode::reset(size_t alphabetSize) {
+    codes.assign(alphabetSize, PrefixCodeEntry{0, 0});
+    present.assign(alphabetSize, false);
+    canonical = false;
+    // Ёмкость под самое большое дерево, чтобы повторные построения не выделяли память
+    trie.reserve(2 * alphabetSize + 1);
+    buildNodes.reserve(2 * alphabetSize + 1);
+    internal.reserve(alphabetSize + 1);
+    frames.reserve(2 * alphabetSize + 1);
+    sorted.reserve(alphabetSize + 1);
+}
+
+void PrefixCode::buildHuffman(const uint64_t* frequencies, size_t alphabetSize) {
+    assignHuffman(frequencies, alphabetSize);
+    buildDecoder();
+}
+
+void PrefixCode::assignHuffman(const uint64_t* frequencies, size_t alphabetSize) {
+    reset(alphabetSize);
+    buildNodes.clear();
+    internal.clear();
+
+    for (size_t i = 0; i < alphabetSize; i++) {
+        if (frequencies[i] > 0) {
+            buildNodes.push_back({frequencies[i], static_cast<uint32_t>(i), -1, -1});
+        }
+    }
+    if (buildNodes.empty()) {
+        // Если все частоты нулевые, создаем фиктивный узел для символа 0
+        buildNodes.push_back({1, 0, -1, -1});
+    }
+
+    // Порядок извлечения как у CompareNode: меньшая частота, при равенстве -
+    // меньший минимальный символ поддерева. Порядок полный, поэтому вместо кучи
+    // хватает двух упорядоченных очередей с теми же слияниями: отсортированных
+    // листьев и внутренних узлов. Родитель тяжелее всех уже извлечённых узлов,
+    // так что новый внутренний узел встаёт в хвост очереди вставкой.
+    auto earlier = [](const BuildNode& x, const BuildNode& y) {
+        if (x.frequency != y.frequency) return x.frequency < y.frequency;
+        return x.minSymbol < y.minSymbol;
+    };
+    std::sort(buildNodes.begin(), buildNodes.end(), earlier);
+
+    size_t leaves = buildNodes.size();
+    size_t nextLeaf = 0;
+    size_t nextInternal = 0;
+    auto take = [&]() {
+        if (nextLeaf < leaves && (nextInternal == internal.size() ||
+                                  earlier(buildNodes[nextLeaf], buildNodes[internal[nextInternal]]))) {
+            return static_cast<int32_t>(nextLeaf++);
+        }
+        return internal[nextInternal++];
+    };
+
+    for (size_t merges = leaves - 1; merges > 0; merges--) {
+        int32_t left = take();
+        int32_t right = take();
+        BuildNode parent = {buildNodes[left].frequency + buildNodes[right].frequency,
+                            std::min(buildNodes[left].minSymbol, buildNodes[right].minSymbol),
+                            left, right};
+        buildNodes.push_back(parent);
+        internal.push_back(static_cast<int32_t>(buildNodes.size() - 1));
+        for (size_t j = internal.size() - 1;
+             j > nextInternal && earlier(buildNodes[internal[j]], buildNodes[internal[j - 1]]); j--) {
+            std::swap(internal[j], internal[j - 1]);
+        }
+    }
+    int32_t root = leaves == 1 ? 0 : internal[nextInternal];
+
+    // Обход дерева в глубину: левая ветвь - 0, правая - 1
+    frames.clear();
+    frames.push_back({root, 0, 0});
+    while (!frames.empty()) {
+        Frame frame = frames.back();
+        frames.pop_back();
+        const BuildNode& node = buildNodes[frame.node];
+        if (node.left < 0) {
+            codes[node.minSymbol] = PrefixCodeEntry{frame.bits, static_cast<uint8_t>(frame.length)};
+            present[node.minSymbol] = true;
+            continue;
+        }
+        if (frame.length >= MAX_CODE_LENGTH) {
+            throw std::runtime_error("Huffman code exceeds 64 bits");
+        }
+        frames.push_back({node.right, (frame.bits << 1) | 1, frame.length + 1});
+        frames.push_back({node.left, frame.bits << 1, frame.length + 1});
+    }
+}
+
+void PrefixCode::buildAlphabetic(const uint64_t* frequencies, size_t alphabetSize) {
+    assignAlphabetic(frequencies, alphabetSize);
+    buildDecoder();
+}
+
+void PrefixCode::assignAlphabetic(const uint64_t* frequencies, size_t alphabetSize) {
+    reset(alphabetSize);
+    buildNodes.clear();
+    internal.clear();
+
+    for (size_t i = 0; i < alphabetSize; i++) {
+        if (frequencies[i] > 0) {
+            buildNodes.push_back({frequencies[i], static_cast<uint32_t>(i), -1, -1});
+        }
+    }
+    if (buildNodes.empty()) {
+        buildNodes.push_back({1, 0, -1, -1});
+    }
+    size_t leaves = buildNodes.size();
+    for (size_t i = 0; i < leaves; i++) {
+        internal.push_back(static_cast<int32_t>(i));
+    }
+
+    // Гарсиа-Уокс: в ряду узлов (по краям - бесконечные веса) берём первую
+    // тройку x, y, z с x <= z, сливаем x и y и ставим родителя сразу за
+    // ближайшим слева узлом не легче его. Дерево слияний само не алфавитное,
+    // но глубины его листьев - длины оптимального алфавитного кода
+    auto weight = [&](size_t position) { return buildNodes[internal[position]].frequency; };
+    size_t start = 0;
+    while (internal.size() > 1) {
+        size_t i = start;
+        while (i + 2 < internal.size() && weight(i) > weight(i + 2)) {
+            i++;
+        }
+        BuildNode parent = {weight(i) + weight(i + 1), 0, internal[i], internal[i + 1]};
+        buildNodes.push_back(parent);
+        internal.erase(internal.begin() + i, internal.begin() + i + 2);
+        size_t position = i;
+        while (position > 0 && weight(position - 1) < parent.frequency) {
+            position--;
+        }
+        internal.insert(internal.begin() + position, static_cast<int32_t>(buildNodes.size() - 1));
+        // Тройки левее вставленного узла не изменились и по-прежнему убывают
+        start = position >= 2 ? position - 2 : 0;
+    }
+
+    frames.clear();
+    frames.push_back({internal[0], 0, 0});
+    while (!frames.empty()) {
+        Frame frame = frames.back();
+        frames.pop_back();
+        const BuildNode& node = buildNodes[frame.node];
+        if (node.left < 0) {
+            codes[node.minSymbol].length = static_cast<uint8_t>(frame.length);
+            present[node.minSymbol] = true;
+            continue;
+        }
+        if (frame.length >= MAX_CODE_LENGTH) {
+            throw std::runtime_error("Alphabetic code exceeds 64 bits");
+        }
+        frames.push_back({node.right, 0, frame.length + 1});
+        frames.push_back({node.left, 0, frame.length + 1});
+    }
+
+    // Коды по порядку символов: следующий код - предыдущий плюс один,
+    // приведённый к своей длине (отбрасываемые справа биты нулевые)
+    uint64_t bits = 0;
+    int length = -1;
+    for (size_t symbol = 0; symbol < alphabetSize; symbol++) {
+        if (!present[symbol]) continue;
+        int next = codes[symbol].length;
+        if (length >= 0) {
+            bits++;
+            bits = next >= length ? bits << (next - length) : bits >> (length - next);
+        }
+        codes[symbol].bits = bits;
+        length = next;
+    }
+}
+
+void PrefixCode::buildLimitedHuffman(const uint64_t* frequencies, size_t alphabetSize, int maxLength) {
+    if (maxLength < 1 || maxLength > MAX_LIMITED_LENGTH) {
+        throw std::invalid_argument("Code length limit must be in 1.." + std::to_string(MAX_LIMITED_LENGTH));
+    }
+    assignHuffman(frequencies, alphabetSize);
+    limitLengths(frequencies, maxLength);
+    assignCanonical();
+    buildDecoder();
+}
+
+void PrefixCode::limitLengths(const uint64_t* frequencies, int maxLength) {
+    sorted.clear();
+    for (size_t i = 0; i < codes.size(); i++) {
+        if (present[i]) {
+            sorted.push_back({static_cast<uint32_t>(i), frequencies[i]});
+        }
+    }
+    // Единственный символ получает код длины 1: длина 0 означает отсутствие
+    if (sorted.size() == 1) {
+        codes[sorted[0].symbol].length = 1;
+        return;
+    }
+    if (sorted.size() > (uint64_t(1) << maxLength)) {
+        throw std::runtime_error("Alphabet does not fit into the code length limit");
+    }
+
+    // Сумма Крафта в единицах 2^-maxLength
+    uint64_t kraft = 0;
+    const uint64_t limit = uint64_t(1) << maxLength;
+    bool clamped = false;
+    for (const SymbolFrequency& entry : sorted) {
+        PrefixCodeEntry& code = codes[entry.symbol];
+        if (code.length > maxLength) {
+            code.length = static_cast<uint8_t>(maxLength);
+            clamped = true;
+        }
+        kraft += uint64_t(1) << (maxLength - code.length);
+    }
+    if (!clamped) return;
+
+    // Редкие символы первыми; при равных частотах - больший номер
+    std::sort(sorted.begin(), sorted.end(), [](const SymbolFrequency& a, const SymbolFrequency& b) {
+        if (a.frequency != b.frequency) return a.frequency < b.frequency;
+        return a.symbol > b.symbol;
+    });
+    for (size_t i = 0; i < sorted.size() && kraft > limit; i++) {
+        PrefixCodeEntry& code = codes[sorted[i].symbol];
+        while (code.length < maxLength && kraft > limit) {
+            kraft -= uint64_t(1) << (maxLength - code.length - 1);
+            code.length++;
+        }
+    }
+    // Освободившееся место отдаётся частым символам
+    for (size_t i = sorted.size(); i-- > 0;) {
+        PrefixCodeEntry& code = codes[sorted[i].symbol];
+        while (code.length > 1 && kraft + (uint64_t(1) << (maxLength - code.length)) <= limit) {
+            kraft += uint64_t(1) << (maxLength - code.length);
+            code.length--;
+        }
+    }
+}
+
+void PrefixCode::buildCanonical(const uint8_t* lengths, size_t alphabetSize) {
+    reset(alphabetSize);
+    for (size_t i = 0; i < alphabetSize; i++) {
+        if (lengths[i] > MAX_CODE_LENGTH) {
+            throw std::runtime_error("Prefix code exceeds 64 bits");
+        }
+        codes[i].length = lengths[i];
+        present[i] = lengths[i] > 0;
+    }
+    assignCanonical();
+    buildDecoder();
+}
+
+void PrefixCode::assignCanonical() {
+    uint64_t lengthCounts[MAX_CODE_LENGTH + 1] = {};
+    for (size_t i = 0; i < codes.size(); i++) {
+        if (present[i]) lengthCounts[codes[i].length]++;
+    }
+
+    // Первый код каждой длины. available - число свободных кодов текущей
+    // длины (с насыщением): если символов больше, неравенство Крафта нарушено
+    const uint64_t saturation = uint64_t(1) << 40;
+    uint64_t nextCode[MAX_CODE_LENGTH + 1] = {};
+    uint64_t code = 0;
+    uint64_t available = 2;
+    for (int length = 1; length <= MAX_CODE_LENGTH; length++) {
+        if (lengthCounts[length] > available) {
+            throw std::runtime_error("Code lengths do not form a prefix code");
+        }
+        nextCode[length] = code;
+        code = (code + lengthCounts[length]) << 1;
+        available = std::min((available - lengthCounts[length]) * 2, saturation);
+    }
+    // Для декодирования длинных кодов: символы по (длине, номеру) и начало каждой длины
+    canonicalSymbols.resize(codes.size());
+    uint32_t index = 0;
+    canonicalLength = 0;
+    for (int length = 1; length <= MAX_CODE_LENGTH; length++) {
+        firstCode[length] = nextCode[length];
+        firstIndex[length] = index;
+        lengthCount[length] = static_cast<uint32_t>(lengthCounts[length]);
+        index += lengthCount[length];
+        if (lengthCounts[length] > 0) canonicalLength = length;
+    }
+    for (size_t i = 0; i < codes.size(); i++) {
+        if (present[i]) {
+            uint8_t length = codes[i].length;
+            canonicalSymbols[firstIndex[length] + (nextCode[length] - firstCode[length])] = static_cast<uint32_t>(i);
+            codes[i].bits = nextCode[length]++;
+        }
+    }
+    canonical = true;
+}
+
+void PrefixCode::buildShannonFano(const uint64_t* frequencies, size_t alphabetSize) {
+    reset(alphabetSize);
+    sorted.clear();
+
+    for (size_t i = 0; i < alphabetSize; i++) {
+        if (frequencies[i] > 0) {
+            sorted.push_back({static_cast<uint32_t>(i), frequencies[i]});
+        }
+    }
+    if (sorted.empty()) {
+        sorted.push_back({0, 1});
+    }
+
+    // Та же сортировка, что в ShannonFanoEncoder: при равных частотах
+    // std::sort даёт ту же перестановку, так как сравнения совпадают
+    std::sort(sorted.begin(), sorted.end(),
+              [](const SymbolFrequency& a, const SymbolFrequency& b) {
+                  return a.frequency > b.frequency;
+              });
+
+    uint64_t totalFreq = 0;
+    for (const auto& entry : sorted) {
+        totalFreq += entry.frequency;
+    }
+
+    splitShannonFano(0, sorted.size() - 1, totalFreq, 0, 0);
+    buildDecoder();
+}
+
+void PrefixCode::splitShannonFano(size_t start, size_t end, uint64_t totalFreq, uint64_t bits, int length) {
+    if (start == end) {
+        codes[sorted[start].symbol] = PrefixCodeEntry{bits, static_cast<uint8_t>(length)};
+        present[sorted[start].symbol] = true;
+        return;
+    }
+    if (length >= MAX_CODE_LENGTH) {
+        throw std::runtime_error("Shannon-Fano code exceeds 64 bits");
+    }
+
+    // Точка разделения с минимальной разницей сумм, как в ShannonFanoEncoder::buildCodes
+    uint64_t leftSum = 0;
+    size_t splitIndex = start;
+    uint64_t minDiff = UINT64_MAX;
+
+    for (size_t i = start; i <= end; i++) {
+        leftSum += sorted[i].frequency;
+        uint64_t rightSum = totalFreq - leftSum;
+        uint64_t diff = (leftSum > rightSum) ? (leftSum - rightSum) : (rightSum - leftSum);
+
+        if (diff <= minDiff) {
+            minDiff = diff;
+            splitIndex = i;
+        } else {
+            // Как и в оригинале, leftSum уже включает символ, на котором
+            // остановились: эти суммы определяют дальнейшие разбиения
+            break;
+        }
+    }
+
+    splitShannonFano(start, splitIndex, leftSum, bits << 1, length + 1);
+    if (splitIndex < end) {
+        splitShannonFano(splitIndex + 1, end, totalFreq - leftSum, (bits << 1) | 1, length + 1);
+    }
+}
+
+void PrefixCode::buildFromCodes(const std::map<uint8_t, std::vector<bool>>& symbolCodes, size_t alphabetSize) {
+    reset(alphabetSize);
+
+    for (const auto& entry : symbolCodes) {
+        if (entry.second.size() > MAX_CODE_LENGTH) {
+            throw std::runtime_error("Prefix code exceeds 64 bits");
+        }
+        uint64_t bits = 0;
+        for (bool bit : entry.second) {
+            bits = (bits << 1) | (bit ? 1 : 0);
+        }
+        codes[entry.first] = PrefixCodeEntry{bits, static_cast<uint8_t>(entry.second.size())};
+        present[entry.first] = true;
+    }
+
+    buildDecoder();
+}
+
+uint64_t PrefixCode::encodedBits(const uint64_t* counts, size_t alphabetSize) const {
+    uint64_t totalBits = 0;
+    for (size_t i = 0; i < alphabetSize; i++) {
+        if (counts[i] == 0) continue;
+        if (!hasCode(static_cast<uint32_t>(i))) return UINT64_MAX;
+        totalBits += counts[i] * codes[i].length;
+    }
+    return totalBits;
+}
+
+void PrefixCode::buildDecoder() {
+    trie.clear();
+    trie.push_back(TrieNode{{-1, -1}, 0, false});
+
+    for (size_t symbol = 0; symbol < codes.size(); symbol++) {
+        if (!present[symbol]) continue;
+        const PrefixCodeEntry& entry = codes[symbol];
+
+        int32_t node = 0;
+        for (int i = entry.length - 1; i >= 0; i--) {
+            if (trie[node].leaf) {
+                throw std::runtime_error("Code set is not prefix-free");
+            }
+            int bit = (entry.bits >> i) & 1;
+            if (trie[node].child[bit] < 0) {
+                trie.push_back(TrieNode{{-1, -1}, 0, false});
+                trie[node].child[bit] = static_cast<int32_t>(trie.size() - 1);
+            }
+            node = trie[node].child[bit];
+        }
+        if (trie[node].leaf || trie[node].child[0] >= 0 || trie[node].child[1] >= 0) {
+            throw std::runtime_error("Code set is not prefix-free");
+        }
+        trie[node].leaf = true;
+        trie[node].symbol = static_cast<uint32_t>(symbol);
+    }
+
+    lookup.assign(size_t(1) << LOOKUP_BITS, LookupEntry{0, 0, LOOKUP_INVALID});
+    fillLookup(0, 0, 0);
+}
+
+void PrefixCode::fillLookup(int32_t node, int depth, uint32_t prefix) {
+    const TrieNode& current = trie[node];
+    if (current.leaf) {
+        // Все продолжения короткого кода указывают на один символ
+        uint32_t first = prefix << (LOOKUP_BITS - depth);
+        uint32_t count = 1u << (LOOKUP_BITS - depth);
+        for (uint32_t i = 0; i < count; i++) {
+            lookup[first + i] = LookupEntry{current.symbol, static_cast<uint8_t>(depth), LOOKUP_SYMBOL};
+        }
+        return;
+    }
+    if (depth == LOOKUP_BITS) {
+        lookup[prefix] = LookupEntry{static_cast<uint32_t>(node), LOOKUP_BITS, LOOKUP_NODE};
+        return;
+    }
+    for (int bit = 0; bit < 2; bit++) {
+        if (current.child[bit] >= 0) {
+            fillLookup(current.child[bit], depth + 1, (prefix << 1) | bit);
+        }
+    }
+}
+
+uint32_t PrefixCode::decodeLong(BitReader& in, const LookupEntry& entry) const {
+    if (entry.kind == LOOKUP_INVALID) {
+        throw std::runtime_error("Invalid prefix code encountered");
+    }
+    if (canonical && canonicalLength <= 32) {
+        // Канонический код: длина находится сравнением с первыми кодами длин
+        uint32_t window = in.peekBits(canonicalLength);
+        for (int length = LOOKUP_BITS + 1; length <= canonicalLength; length++) {
+            uint64_t offset = (window >> (canonicalLength - length)) - firstCode[length];
+            if (offset < lengthCount[length]) {
+                in.skipBits(length);
+                return canonicalSymbols[firstIndex[length] + offset];
+            }
+        }
+        throw std::runtime_error("Invalid prefix code encountered");
+    }
+    in.skipBits(LOOKUP_BITS);
+    int32_t node = static_cast<int32_t>(entry.value);
+    while (!trie[node].leaf) {
+        node = trie[node].child[in.readBit() ? 1 : 0];
+        if (node < 0) {
+            throw std::runtime_error("Invalid prefix code encountered");
+        }
+    }
+    return trie[node].symbol;
+}
@@ -0,0 +1,157 @@
+// prefix_code.h - плоская таблица префиксного кода
+#pragma once
+#include "common.h"
+#include "bitstream.h"
+#include <vector>
+#include <map>
+#include <memory_resource>
+#include <stdexcept>
+#include <cstdint>
+
+struct PrefixCodeEntry {
+    uint64_t bits;
+    uint8_t length;
+};
+
+// Префиксный код без динамических узлов: коды символов лежат в массиве,
+// декодирование идёт по таблице на LOOKUP_BITS бит с доходом по
+// плоскому бору для длинных кодов. Используется библиотекой вместо
+// деревьев HuffmanEncoder/HuffmanDecoder, формат данных тот же.
+// Все массивы берутся из переданного memory_resource и при повторных
+// построениях переиспользуют уже выделенную ёмкость.
+class PrefixCode {
+public:
+    static const int LOOKUP_BITS = 11;
+    static const int MAX_CODE_LENGTH = 64;
+    // Наибольшее ограничение длины для buildLimitedHuffman
+    static const int MAX_LIMITED_LENGTH = 32;
+
+    explicit PrefixCode(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Коды Хаффмана, совпадающие бит в бит с HuffmanEncoder
+    // (тот же порядок слияния узлов, что и в CompareNode)
+    void buildHuffman(const uint64_t* frequencies, size_t alphabetSize);
+    // Те же коды без таблиц декодирования: достаточно для encode и encodedBits
+    void buildHuffmanCodes(const uint64_t* frequencies, size_t alphabetSize) { assignHuffman(frequencies, alphabetSize); }
+    // Коды Шеннона-Фано, совпадающие бит в бит с ShannonFanoEncoder
+    void buildShannonFano(const uint64_t* frequencies, size_t alphabetSize);
+    // Оптимальный алфавитный код (Ху-Такер, построение Гарсиа-Уокса): коды
+    // возрастают вместе с номерами символов, поэтому побитовое сравнение
+    // закодированных строк даёт тот же порядок, что и сравнение исходных.
+    // Символы с нулевой частотой кода не получают
+    void buildAlphabetic(const uint64_t* frequencies, size_t alphabetSize);
+    // Те же коды без таблиц декодирования
+    void buildAlphabeticCodes(const uint64_t* frequencies, size_t alphabetSize) {
+        assignAlphabetic(frequencies, alphabetSize);
+    }
+    // Канонические коды Хаффмана не длиннее maxLength бит: длины из дерева
+    // Хаффмана урезаются, неравенство Крафта восстанавливается за счёт
+    // удлинения кодов самых редких символов (maxLength - до MAX_LIMITED_LENGTH).
+    // Коды назначаются по возрастанию длины, при равной длине - по номеру символа.
+    void buildLimitedHuffman(const uint64_t* frequencies, size_t alphabetSize, int maxLength);
+    // Канонические коды по длинам (0 - символа нет); std::runtime_error,
+    // если длины не образуют префиксный код
+    void buildCanonical(const uint8_t* lengths, size_t alphabetSize);
+    // Явно заданные коды
+    void buildFromCodes(const std::map<uint8_t, std::vector<bool>>& symbolCodes, size_t alphabetSize);
+
+    bool hasCode(uint32_t symbol) const { return symbol < present.size() && present[symbol]; }
+    const PrefixCodeEntry& code(uint32_t symbol) const { return codes[symbol]; }
+    size_t alphabetSize() const { return codes.size(); }
+
+    // Размер закодированных данных в битах; UINT64_MAX, если встречается символ без кода
+    uint64_t encodedBits(const uint64_t* counts, size_t alphabetSize) const;
+
+    void encodeSymbol(uint32_t symbol, BitWriter& out) const {
+        const PrefixCodeEntry& entry = codes[symbol];
+        out.writeBits(entry.bits, entry.length);
+    }
+
+    uint32_t decodeSymbol(BitReader& in) const {
+        const LookupEntry& entry = lookup[in.peekBits(LOOKUP_BITS)];
+        if (entry.kind == LOOKUP_SYMBOL) {
+            in.skipBits(entry.length);
+            return entry.value;
+        }
+        return decodeLong(in, entry);
+    }
+
+    // Последовательности символов: uint8_t для байтового алфавита, более
+    // широкие типы - для алфавитов больше 256 (размер алфавита задаётся при построении)
+    template <typename Symbol>
+    void encode(const Symbol* src, size_t size, BitWriter& out) const {
+        for (size_t i = 0; i < size; i++) {
+            encodeSymbol(src[i], out);
+        }
+    }
+
+    template <typename Symbol>
+    void decode(BitReader& in, Symbol* dst, size_t size) const {
+        for (size_t i = 0; i < size; i++) {
+            dst[i] = static_cast<Symbol>(decodeSymbol(in));
+        }
+        if (in.overrun()) {
+            throw std::runtime_error("Unexpected end of stream during decoding");
+        }
+    }
+
+private:
+    enum LookupKind : uint8_t { LOOKUP_INVALID = 0, LOOKUP_SYMBOL = 1, LOOKUP_NODE = 2 };
+
+    struct LookupEntry {
+        uint32_t value;  // символ или узел бора на глубине LOOKUP_BITS
+        uint8_t length;
+        LookupKind kind;
+    };
+
+    struct TrieNode {
+        int32_t child[2];
+        uint32_t symbol;
+        bool leaf;
+    };
+
+    void reset(size_t alphabetSize);
+    void assignHuffman(const uint64_t* frequencies, size_t alphabetSize);
+    void assignAlphabetic(const uint64_t* frequencies, size_t alphabetSize);
+    void limitLengths(const uint64_t* frequencies, int maxLength);
+    void assignCanonical();
+    void buildDecoder();
+    void fillLookup(int32_t node, int depth, uint32_t prefix);
+    uint32_t decodeLong(BitReader& in, const LookupEntry& entry) const;
+    void splitShannonFano(size_t start, size_t end, uint64_t totalFreq, uint64_t bits, int length);
+
+    std::pmr::vector<PrefixCodeEntry> codes;
+    std::pmr::vector<bool> present;
+    std::pmr::vector<TrieNode> trie;
+    std::pmr::vector<LookupEntry> lookup;
+
+    // Канонический код (buildCanonical, buildLimitedHuffman): длинные коды
+    // декодируются по первым кодам длин, без обхода бора
+    bool canonical;
+    int canonicalLength;
+    uint64_t firstCode[MAX_CODE_LENGTH + 1];
+    uint32_t firstIndex[MAX_CODE_LENGTH + 1];
+    uint32_t lengthCount[MAX_CODE_LENGTH + 1];
+    std::pmr::vector<uint32_t> canonicalSymbols;
+
+    // Рабочие массивы построения дерева Хаффмана
+    struct BuildNode {
+        uint64_t frequency;
+        uint32_t minSymbol;
+        int32_t left;
+        int32_t right;
+    };
+    struct Frame {
+        int32_t node;
+        uint64_t bits;
+        int length;
+    };
+    struct SymbolFrequency {
+        uint32_t symbol;
+        uint64_t frequency;
+    };
+    std::pmr::vector<BuildNode> buildNodes;
+    std::pmr::vector<int32_t> internal;   // очередь внутренних узлов (у алфавитного кода - ряд узлов)
+    std::pmr::vector<Frame> frames;
+    std::pmr::vector<SymbolFrequency> sorted;
+};
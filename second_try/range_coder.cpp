@@ -0,0 +1,68 @@
+#include "range_coder.h"
+#include <stdexcept>
+
+RangeEncoder::RangeEncoder(uint8_t* dst, size_t capacity)
+    : out(dst), capacity(capacity), pos(0), low(0), range(0xFFFFFFFF), cache(0), cacheSize(1) {}
+
+void RangeEncoder::put(uint8_t byte) {
+    if (pos >= capacity) {
+        throw std::length_error("Destination buffer too small");
+    }
+    out[pos++] = byte;
+}
+
+void RangeEncoder::shiftLow() {
+    // Старший байт low выводится, только когда перенос в него уже невозможен;
+    // до тех пор байты 0xFF копятся в счётчике cacheSize
+    if (static_cast<uint32_t>(low) < 0xFF000000u || (low >> 32) != 0) {
+        uint8_t carry = static_cast<uint8_t>(low >> 32);
+        uint8_t temp = cache;
+        do {
+            put(static_cast<uint8_t>(temp + carry));
+            temp = 0xFF;
+        } while (--cacheSize != 0);
+        cache = static_cast<uint8_t>(low >> 24);
+    }
+    cacheSize++;
+    low = (low & 0x00FFFFFFu) << 8;
+}
+
+void RangeEncoder::flush() {
+    for (int i = 0; i < 5; i++) {
+        shiftLow();
+    }
+}
+
+RangeDecoder::RangeDecoder(const uint8_t* src, size_t size)
+    : in(src), size(size), pos(0), range(0xFFFFFFFF), code(0) {
+    for (int i = 0; i < 5; i++) {
+        code = (code << 8) | next();
+    }
+}
+
+void AdaptiveByteModel::reset() {
+    for (uint16_t& prob : probs) {
+        prob = RangeEncoder::PROB_INIT;
+    }
+}
+
+size_t RangeCode::encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+    RangeEncoder rc(dst, capacity);
+    AdaptiveByteModel model;
+    for (size_t i = 0; i < size; i++) {
+        model.encode(rc, src[i]);
+    }
+    rc.flush();
+    return rc.bytesWritten();
+}
+
+void RangeCode::decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size) {
+    RangeDecoder rc(src, srcSize);
+    AdaptiveByteModel model;
+    for (size_t i = 0; i < size; i++) {
+        dst[i] = model.decode(rc);
+    }
+    if (rc.overrun()) {
+        throw std::runtime_error("Corrupted range coder stream: unexpected end of data");
+    }
+}
@@ -0,0 +1,125 @@
+// range_coder.h - интервальный (range) кодер с адаптивной моделью нулевого порядка
+#pragma once
+#include "common.h"
+#include <cstdint>
+#include <cstddef>
+
+// Двоичный интервальный кодер с побайтовым выводом и переносом через кэш
+// (схема LZMA). Вероятности - 11-битные, адаптируются сдвигом.
+class RangeEncoder {
+public:
+    static const int PROB_BITS = 11;
+    static const uint32_t PROB_INIT = 1u << (PROB_BITS - 1);
+    static const int MOVE_BITS = 5;
+
+    RangeEncoder(uint8_t* dst, size_t capacity);
+
+    void encodeBit(uint16_t& prob, int bit) {
+        uint32_t bound = (range >> PROB_BITS) * prob;
+        if (bit == 0) {
+            range = bound;
+            prob += ((1u << PROB_BITS) - prob) >> MOVE_BITS;
+        } else {
+            low += bound;
+            range -= bound;
+            prob -= prob >> MOVE_BITS;
+        }
+        while (range < TOP) {
+            range <<= 8;
+            shiftLow();
+        }
+    }
+
+    void flush();
+    size_t bytesWritten() const { return pos; }
+
+private:
+    static const uint32_t TOP = 1u << 24;
+
+    void shiftLow();
+    void put(uint8_t byte);
+
+    uint8_t* out;
+    size_t capacity;
+    size_t pos;
+    uint64_t low;
+    uint32_t range;
+    uint8_t cache;
+    uint64_t cacheSize;
+};
+
+class RangeDecoder {
+public:
+    RangeDecoder(const uint8_t* src, size_t size);
+
+    int decodeBit(uint16_t& prob) {
+        uint32_t bound = (range >> RangeEncoder::PROB_BITS) * prob;
+        int bit;
+        if (code < bound) {
+            range = bound;
+            prob += ((1u << RangeEncoder::PROB_BITS) - prob) >> RangeEncoder::MOVE_BITS;
+            bit = 0;
+        } else {
+            code -= bound;
+            range -= bound;
+            prob -= prob >> RangeEncoder::MOVE_BITS;
+            bit = 1;
+        }
+        while (range < TOP) {
+            range <<= 8;
+            code = (code << 8) | next();
+        }
+        return bit;
+    }
+
+    // Прочитано больше байт, чем записал кодер: данные повреждены
+    bool overrun() const { return pos > size; }
+
+private:
+    static const uint32_t TOP = 1u << 24;
+
+    uint8_t next() { return pos < size ? in[pos++] : (pos++, 0); }
+
+    const uint8_t* in;
+    size_t size;
+    size_t pos;
+    uint32_t range;
+    uint32_t code;
+};
+
+// Адаптивная модель байта: дерево из 255 двоичных вероятностей,
+// байт кодируется восемью решениями от старшего бита к младшему.
+// Таблица частот в архив не пишется - декодер строит ту же модель по ходу.
+class AdaptiveByteModel {
+public:
+    AdaptiveByteModel() { reset(); }
+
+    void reset();
+
+    void encode(RangeEncoder& rc, uint8_t symbol) {
+        uint32_t node = 1;
+        for (int i = 7; i >= 0; i--) {
+            int bit = (symbol >> i) & 1;
+            rc.encodeBit(probs[node], bit);
+            node = (node << 1) | bit;
+        }
+    }
+
+    uint8_t decode(RangeDecoder& rc) {
+        uint32_t node = 1;
+        while (node < Common::ALPHABET_SIZE) {
+            node = (node << 1) | rc.decodeBit(probs[node]);
+        }
+        return static_cast<uint8_t>(node - Common::ALPHABET_SIZE);
+    }
+
+private:
+    uint16_t probs[Common::ALPHABET_SIZE];
+};
+
+class RangeCode {
+public:
+    // Возвращает размер закодированных данных; std::length_error, если не хватает места
+    static size_t encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity);
+    static void decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size);
+};
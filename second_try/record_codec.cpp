@@ -0,0 +1,111 @@
+#include "record_codec.h"
+#include "archive_format.h"
+#include "bitstream.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    const uint64_t RAW_RECORD = 1;
+
+    size_t varintSize(uint64_t value) {
+        size_t size = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            size++;
+        }
+        return size;
+    }
+}
+
+RecordCodec::RecordCodec(const PretrainedTable& table, Common::Algorithm algorithm) : code(&pool), id(table.id) {
+    if (algorithm == Common::ALGO_HUFFMAN) {
+        code.buildHuffman(table.frequencies.data(), Common::ALPHABET_SIZE);
+    } else if (algorithm == Common::ALGO_SHANNON_FANO) {
+        code.buildShannonFano(table.frequencies.data(), Common::ALPHABET_SIZE);
+    } else {
+        throw std::invalid_argument("Records require Huffman or Shannon-Fano coding");
+    }
+}
+
+size_t RecordCodec::recordBound(size_t size) {
+    // Запись, которую код не сокращает, хранится как есть
+    return varintSize(static_cast<uint64_t>(size) * 2 + RAW_RECORD) + size;
+}
+
+size_t RecordCodec::encode(const uint8_t* src, size_t size, uint8_t* dst, size_t dstCapacity) const {
+    // Длина кода считается заранее: решение "сжать или хранить" принимается
+    // до записи, без повторного прохода по выходу
+    uint64_t bits = 0;
+    for (size_t i = 0; i < size; i++) {
+        bits += code.code(src[i]).length;
+    }
+    uint64_t payloadSize = (bits + 7) / 8;
+    bool raw = payloadSize >= size;
+
+    size_t offset = 0;
+    ArchiveWriter::writeVarint(dst, dstCapacity, offset, static_cast<uint64_t>(size) * 2 + (raw ? RAW_RECORD : 0));
+    if (raw) {
+        if (dstCapacity - offset < size) {
+            throw std::length_error("Destination buffer too small");
+        }
+        if (size > 0) {
+            std::memcpy(dst + offset, src, size);
+        }
+        return offset + size;
+    }
+    BitWriter out(dst + offset, dstCapacity - offset);
+    code.encode(src, size, out);
+    out.flush();
+    return offset + out.bytesWritten();
+}
+
+uint64_t RecordCodec::decodedSize(const uint8_t* src, size_t avail) {
+    size_t offset = 0;
+    return ArchiveWriter::readVarint(src, avail, offset) / 2;
+}
+
+size_t RecordCodec::decode(const uint8_t* src, size_t avail, uint8_t* dst, size_t dstCapacity) const {
+    size_t offset = 0;
+    uint64_t value = ArchiveWriter::readVarint(src, avail, offset);
+    uint64_t size = value / 2;
+    if (size > dstCapacity) {
+        throw std::length_error("Destination buffer too small");
+    }
+    if (value & RAW_RECORD) {
+        if (avail - offset < size) {
+            throw std::runtime_error("Record is truncated");
+        }
+        if (size > 0) {
+            std::memcpy(dst, src + offset, size);
+        }
+        return size;
+    }
+    BitReader in(src + offset, avail - offset);
+    code.decode(in, dst, size);
+    return size;
+}
+
+size_t RecordCodec::encodeBatch(const RecordView* records, size_t count, uint8_t* dst, size_t dstCapacity,
+                                uint64_t* offsets) const {
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        offsets[i] = total;
+        total += encode(records[i].data, records[i].size, dst + total, dstCapacity - total);
+    }
+    offsets[count] = total;
+    return total;
+}
+
+size_t RecordCodec::decodeBatch(const uint8_t* src, const uint64_t* offsets, size_t count, uint8_t* dst,
+                                size_t dstCapacity, uint64_t* dstOffsets) const {
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (offsets[i + 1] < offsets[i]) {
+            throw std::runtime_error("Record offsets are not ascending");
+        }
+        dstOffsets[i] = total;
+        total += decode(src + offsets[i], offsets[i + 1] - offsets[i], dst + total, dstCapacity - total);
+    }
+    dstOffsets[count] = total;
+    return total;
+}
@@ -0,0 +1,55 @@
+// record_codec.h - независимо распаковываемые короткие записи с общей таблицей
+#pragma once
+#include "common.h"
+#include "prefix_code.h"
+#include "table_library.h"
+#include <memory_resource>
+#include <cstdint>
+#include <cstddef>
+
+// Запись для пакетного сжатия
+struct RecordView {
+    const uint8_t* data;
+    size_t size;
+};
+
+// Сжатие множества коротких записей (строк журнала и т.п.) одной внешней
+// обученной таблицей (PretrainedTable). Таблица и номер в записи не
+// хранятся - их держит вызывающая сторона. Сжатая запись - varint
+// (размер * 2 + признак несжатой записи) и код с границы байта; запись,
+// которую таблица не сжимает, хранится как есть. Каждая запись
+// распаковывается сама по себе, соседние не нужны. Код строится один раз
+// в конструкторе; encode/decode не меняют объект и не выделяют память,
+// так что один RecordCodec можно использовать из многих потоков.
+class RecordCodec {
+public:
+    // algorithm - ALGO_HUFFMAN или ALGO_SHANNON_FANO (иначе std::invalid_argument)
+    explicit RecordCodec(const PretrainedTable& table, Common::Algorithm algorithm = Common::ALGO_HUFFMAN);
+
+    uint32_t tableId() const { return id; }
+
+    // Наибольший размер сжатой записи из size байт
+    static size_t recordBound(size_t size);
+
+    // Возвращает размер сжатой записи в dst; std::length_error, если не хватает места
+    size_t encode(const uint8_t* src, size_t size, uint8_t* dst, size_t dstCapacity) const;
+    // Распаковывает запись из avail байт src, возвращает её размер.
+    // Не хватает места - std::length_error, запись испорчена или обрезана - std::runtime_error
+    size_t decode(const uint8_t* src, size_t avail, uint8_t* dst, size_t dstCapacity) const;
+    // Размер распакованной записи по её началу
+    static uint64_t decodedSize(const uint8_t* src, size_t avail);
+
+    // Пакет записей подряд в dst: offsets (count + 1 значений) получает
+    // начало каждой сжатой записи и конец последней. Возвращает размер пакета
+    size_t encodeBatch(const RecordView* records, size_t count, uint8_t* dst, size_t dstCapacity,
+                       uint64_t* offsets) const;
+    // Обратное: записи src[offsets[i], offsets[i + 1]) подряд в dst,
+    // dstOffsets (count + 1 значений) - их границы. Возвращает общий размер
+    size_t decodeBatch(const uint8_t* src, const uint64_t* offsets, size_t count, uint8_t* dst,
+                       size_t dstCapacity, uint64_t* dstOffsets) const;
+
+private:
+    std::pmr::unsynchronized_pool_resource pool;
+    PrefixCode code;
+    uint32_t id;
+};
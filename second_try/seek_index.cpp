@@ -0,0 +1,96 @@
+#include "seek_index.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    SeekPoint readPoint(const uint8_t* src, uint64_t index) {
+        SeekPoint point;
+        const uint8_t* entry = src + SeekIndex::HEADER_SIZE + index * SeekIndex::POINT_SIZE;
+        std::memcpy(&point.offset, entry, sizeof(point.offset));
+        std::memcpy(&point.bitOffset, entry + 8, sizeof(point.bitOffset));
+        return point;
+    }
+}
+
+SeekIndex::SeekIndex(std::pmr::memory_resource* resource) : step(0), points(resource) {}
+
+void SeekIndex::reset(uint32_t interval) {
+    step = interval;
+    points.clear();
+}
+
+size_t SeekIndex::bound(uint64_t size, size_t interval) {
+    if (interval == 0) return 0;
+    uint64_t count = size == 0 ? 1 : (size + interval - 1) / interval;
+    return HEADER_SIZE + count * POINT_SIZE;
+}
+
+size_t SeekIndex::write(uint8_t* dst, size_t capacity) const {
+    size_t size = serializedSize();
+    if (capacity < size) {
+        throw std::length_error("Destination buffer too small");
+    }
+    uint64_t count = points.size();
+    std::memcpy(dst, &SIGNATURE, sizeof(SIGNATURE));
+    std::memcpy(dst + 4, &step, sizeof(step));
+    std::memcpy(dst + 8, &count, sizeof(count));
+    uint8_t* entry = dst + HEADER_SIZE;
+    for (const SeekPoint& point : points) {
+        std::memcpy(entry, &point.offset, sizeof(point.offset));
+        std::memcpy(entry + 8, &point.bitOffset, sizeof(point.bitOffset));
+        entry += POINT_SIZE;
+    }
+    return size;
+}
+
+bool SeekIndex::describe(const uint8_t* src, size_t avail, uint32_t& interval, uint64_t& count) {
+    uint32_t signature = 0;
+    if (avail < HEADER_SIZE) return false;
+    std::memcpy(&signature, src, sizeof(signature));
+    if (signature != SIGNATURE) return false;
+    std::memcpy(&interval, src + 4, sizeof(interval));
+    std::memcpy(&count, src + 8, sizeof(count));
+    if (count > (avail - HEADER_SIZE) / POINT_SIZE) {
+        throw std::runtime_error("Corrupted seek index");
+    }
+    return true;
+}
+
+bool SeekIndex::locate(const uint8_t* src, size_t avail, uint64_t offset, SeekPoint& point) {
+    uint32_t interval = 0;
+    uint64_t count = 0;
+    if (!describe(src, avail, interval, count) || count == 0) return false;
+
+    // Последняя точка с point.offset <= offset
+    uint64_t low = 0;
+    uint64_t high = count;
+    while (high - low > 1) {
+        uint64_t middle = low + (high - low) / 2;
+        if (readPoint(src, middle).offset <= offset) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    point = readPoint(src, low);
+    if (point.offset > offset) {
+        throw std::runtime_error("Corrupted seek index");
+    }
+    return true;
+}
+
+bool SeekIndex::read(const uint8_t* src, size_t avail) {
+    uint32_t interval = 0;
+    uint64_t count = 0;
+    if (!describe(src, avail, interval, count)) return false;
+    step = interval;
+    points.clear();
+    for (uint64_t i = 0; i < count; i++) {
+        SeekPoint point = readPoint(src, i);
+        if (!points.empty() && point.offset < points.back().offset) {
+            throw std::runtime_error("Corrupted seek index");
+        }
+        points.push_back(point);
+    }
+    return true;
+}
@@ -0,0 +1,60 @@
+// seek_index.h - индекс произвольного доступа к данным архива
+#pragma once
+#include <memory_resource>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Контрольная точка: символ с номером offset несжатых данных начинается
+// с бита bitOffset сжатых данных (от начала данных, после таблицы частот)
+struct SeekPoint {
+    uint64_t offset;
+    uint64_t bitOffset;
+};
+
+// Индекс лежит сразу за сжатыми данными архива VERSION_2/VERSION_3 или
+// за маркером конца потокового архива (StreamCompressor::setBlockIndex):
+// сигнатура "HIDX", шаг точек в байтах (uint32), число точек (uint64),
+// затем точки по возрастанию offset - пары uint64. Первая точка - (0, 0).
+// Старые декодеры хвост за compressedSize не читают, поэтому архив с
+// индексом распаковывается и без него. Префиксный код не хранит состояния
+// между символами, так что декодирование можно начать с любой точки.
+// В потоковом архиве точка - начало блока (bitOffset - от конца заголовка
+// архива, кратен 8), шаг не задан и записывается как 0.
+class SeekIndex {
+public:
+    static const uint32_t SIGNATURE = 0x58444948; // "HIDX" в little-endian
+    static const size_t HEADER_SIZE = 16;
+    static const size_t POINT_SIZE = 16;
+    static const size_t DEFAULT_INTERVAL = 64 * 1024;
+
+    explicit SeekIndex(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Начать новый индекс с шагом interval байт
+    void reset(uint32_t interval);
+    void add(uint64_t offset, uint64_t bitOffset) { points.push_back({offset, bitOffset}); }
+
+    uint32_t interval() const { return step; }
+    const std::pmr::vector<SeekPoint>& entries() const { return points; }
+    bool empty() const { return points.empty(); }
+
+    size_t serializedSize() const { return HEADER_SIZE + points.size() * POINT_SIZE; }
+    // Размер индекса с шагом interval для size байт несжатых данных
+    static size_t bound(uint64_t size, size_t interval);
+    // Возвращает число записанных байт; std::length_error, если не хватает места
+    size_t write(uint8_t* dst, size_t capacity) const;
+
+    // Ищет в индексе, записанном в src (avail байт), последнюю точку не
+    // дальше offset. Читаются только заголовок и log2(число точек) записей.
+    // false - индекса нет; испорченный индекс - std::runtime_error
+    static bool locate(const uint8_t* src, size_t avail, uint64_t offset, SeekPoint& point);
+    // Шаг и число точек индекса в src; false - индекса нет
+    static bool describe(const uint8_t* src, size_t avail, uint32_t& interval, uint64_t& count);
+    // Загружает все точки индекса из src (например, чтобы дописать новые);
+    // false - индекса нет
+    bool read(const uint8_t* src, size_t avail);
+
+private:
+    uint32_t step;
+    std::pmr::vector<SeekPoint> points;
+};
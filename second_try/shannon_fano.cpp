@@ -161,14 +161,15 @@ void ShannonFanoDecoder::buildTree(const std::vector<uint64_t>& frequencies) {
 }
 
 std::vector<uint8_t> ShannonFanoDecoder::decodeData(BitInputStream& in, size_t originalSize) const {
-    std::vector<uint8_t> result;
-    result.reserve(originalSize);
-    
+    std::vector<uint8_t> result(originalSize);
+    decodeData(in, result.data(), originalSize);
+    return result;
+}
+
+void ShannonFanoDecoder::decodeData(BitInputStream& in, uint8_t* out, size_t originalSize) const {
     for (size_t i = 0; i < originalSize; i++) {
-        result.push_back(decodeSymbol(in));
+        out[i] = decodeSymbol(in);
     }
-    
-    return result;
 }
 
 uint8_t ShannonFanoDecoder::decodeSymbol(BitInputStream& in) const {
@@ -31,6 +31,7 @@ public:
     ShannonFanoDecoder(const std::vector<uint64_t>& frequencies);
     ~ShannonFanoDecoder(); // Добавляем объявление деструктора
     std::vector<uint8_t> decodeData(BitInputStream& in, size_t originalSize) const;
+    void decodeData(BitInputStream& in, uint8_t* out, size_t originalSize) const;
     
 private:
     void buildTree(const std::vector<uint64_t>& frequencies);
@@ -0,0 +1,469 @@
+#include "stream.h"
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+StreamCompressor::StreamCompressor(size_t blockSize)
+    : blockSize(blockSize), splitBlocks(false), blockIndex(false), blocksSize(0), inputSize(0), outputPos(0),
+      headerWritten(false), streamFinished(false) {
+    if (blockSize == 0 || blockSize > UINT32_MAX) {
+        throw std::invalid_argument("Block size must be in range 1..2^32-1");
+    }
+    pending.reserve(blockSize);
+}
+
+void StreamCompressor::resume(const SeekIndex& existing, uint64_t blocksSize, uint64_t inputSize,
+                              const uint64_t* lastFreqs, int lastBits) {
+    if (headerWritten) {
+        throw std::logic_error("Stream has already started");
+    }
+    index.reset(0);
+    for (const SeekPoint& point : existing.entries()) {
+        index.add(point.offset, point.bitOffset);
+    }
+    this->blocksSize = blocksSize;
+    this->inputSize = inputSize;
+    splitter.reset();
+    if (lastFreqs) {
+        splitter.resume(lastFreqs, lastBits);
+    }
+    splitBlocks = true;
+    blockIndex = true;
+    headerWritten = true;
+}
+
+bool StreamCompressor::compress(StreamBuffers& strm, FlushMode flush) {
+    for (;;) {
+        drain(strm);
+        if (outputPos < output.size()) return false;
+        output.clear();
+        outputPos = 0;
+
+        if (!headerWritten) {
+            emitHeader();
+            continue;
+        }
+        if (streamFinished) return true;
+
+        if (strm.availIn > 0) {
+            size_t take = std::min(strm.availIn, blockSize - pending.size());
+            pending.insert(pending.end(), strm.nextIn, strm.nextIn + take);
+            strm.nextIn += take;
+            strm.availIn -= take;
+            strm.totalIn += take;
+            if (pending.size() == blockSize) emitBlock();
+            continue;
+        }
+
+        if (flush == FlushMode::SYNC && !pending.empty()) {
+            emitBlock();
+            continue;
+        }
+        if (flush == FlushMode::FINISH) {
+            if (!pending.empty()) emitBlock();
+            emitEnd();
+            streamFinished = true;
+            continue;
+        }
+        return true;
+    }
+}
+
+void StreamCompressor::emitHeader() {
+    // Размеры потока заранее неизвестны; при записи в файл их можно дописать позже
+    ArchiveHeader header;
+    header.signature = Common::SIGNATURE;
+    header.version = Common::VERSION_4;
+    header.algorithm = Common::ALGO_HUFFMAN;
+    header.frequencyBits = 0;
+    header.filter = 0;
+    header.originalSize = 0;
+    header.compressedSize = 0;
+
+    size_t offset = output.size();
+    output.resize(offset + ArchiveHeader::SIZE);
+    ArchiveWriter::writeHeader(output.data() + offset, header);
+    headerWritten = true;
+}
+
+void StreamCompressor::emitBlock() {
+    // Блок всегда заканчивается на границе байта
+    size_t offset = output.size();
+    if (splitBlocks) {
+        size_t capacity = BlockSplitter::bound(pending.size());
+        output.resize(offset + capacity);
+        size_t written = splitter.encode(pending.data(), pending.size(), output.data() + offset, capacity);
+        output.resize(offset + written);
+        pending.clear();
+        if (blockIndex) indexBlocks(offset);
+        return;
+    }
+    size_t capacity = Codec::compressBound(pending.size());
+    output.resize(offset + BlockHeader::SIZE + capacity);
+
+    uint64_t payloadSize = 0;
+    size_t bodySize = context.compressBody(pending.data(), pending.size(),
+                                           output.data() + offset + BlockHeader::SIZE, capacity, payloadSize);
+
+    BlockHeader block;
+    block.type = context.lastStored() ? Common::BLOCK_STORED : Common::BLOCK_HUFFMAN;
+    block.frequencyBits = context.lastFrequencyBits();
+    block.originalSize = static_cast<uint32_t>(pending.size());
+    block.compressedSize = static_cast<uint32_t>(payloadSize);
+    ArchiveWriter::writeBlockHeader(output.data() + offset, block);
+
+    output.resize(offset + BlockHeader::SIZE + bodySize);
+    pending.clear();
+    if (blockIndex) indexBlocks(offset);
+}
+
+void StreamCompressor::indexBlocks(size_t offset) {
+    while (offset < output.size()) {
+        const uint8_t* data = output.data() + offset;
+        BlockHeader block = ArchiveWriter::readBlockHeader(data);
+        size_t tableSize = ArchiveWriter::readTableSize(data + BlockHeader::SIZE,
+                                                        output.size() - offset - BlockHeader::SIZE,
+                                                        block.frequencyBits);
+        uint64_t size = BlockHeader::SIZE + tableSize + block.compressedSize;
+        index.add(inputSize, blocksSize * 8);
+        inputSize += block.originalSize;
+        blocksSize += size;
+        offset += size;
+    }
+}
+
+void StreamCompressor::emitEnd() {
+    BlockHeader block = {Common::BLOCK_END, 0, 0, 0};
+    size_t offset = output.size();
+    output.resize(offset + BlockHeader::SIZE);
+    ArchiveWriter::writeBlockHeader(output.data() + offset, block);
+    if (!blockIndex) return;
+
+    uint64_t endOffset = ArchiveHeader::SIZE + blocksSize;
+    offset = output.size();
+    output.resize(offset + index.serializedSize() + INDEX_TRAILER_SIZE);
+    offset += index.write(output.data() + offset, output.size() - offset);
+    std::memcpy(output.data() + offset, &endOffset, sizeof(endOffset));
+    std::memcpy(output.data() + offset + 8, &INDEX_TRAILER_SIGNATURE, sizeof(INDEX_TRAILER_SIGNATURE));
+}
+
+void StreamCompressor::drain(StreamBuffers& strm) {
+    size_t count = std::min(strm.availOut, output.size() - outputPos);
+    if (count == 0) return;
+    std::memcpy(strm.nextOut, output.data() + outputPos, count);
+    outputPos += count;
+    strm.nextOut += count;
+    strm.availOut -= count;
+    strm.totalOut += count;
+}
+
+StreamAppender::StreamAppender(const std::string& filename, size_t chunkSize)
+    : fd(-1), baseInput(0), appended(0), writePos(0), finished(false), compressor(chunkSize),
+      outBuf(Common::DEFAULT_BLOCK_SIZE) {
+    fd = open(filename.c_str(), O_RDWR);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open archive: " + filename + " (" + std::strerror(errno) + ")");
+    }
+    try {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            throw std::runtime_error("Archive must be a regular file: " + filename);
+        }
+        uint64_t fileSize = static_cast<uint64_t>(st.st_size);
+        if (fileSize < ArchiveHeader::SIZE + BlockHeader::SIZE) {
+            throw std::runtime_error("Archive is truncated");
+        }
+        uint8_t bytes[ArchiveHeader::SIZE];
+        readAt(0, bytes, sizeof(bytes));
+        header = ArchiveWriter::readHeader(bytes);
+        if (header.signature != Common::SIGNATURE || header.version != Common::VERSION_4) {
+            throw std::runtime_error("Not a stream archive");
+        }
+        if (header.filter != 0) {
+            throw std::runtime_error("Stream archives do not support filters");
+        }
+
+        SeekIndex existing;
+        uint64_t endOffset = locateEnd(fileSize, existing);
+
+        // Таблица последнего блока Хаффмана: с конца индекса по заголовкам блоков
+        std::vector<uint64_t> lastFreqs(Common::ALPHABET_SIZE, 0);
+        std::vector<uint8_t> table;
+        bool haveTable = false;
+        int lastBits = 0;
+        const auto& points = existing.entries();
+        for (size_t i = points.size(); i-- > 0;) {
+            uint64_t position = ArchiveHeader::SIZE + points[i].bitOffset / 8;
+            if (position + BlockHeader::SIZE > endOffset) {
+                throw std::runtime_error("Corrupted block index");
+            }
+            uint8_t blockBytes[BlockHeader::SIZE];
+            readAt(position, blockBytes, sizeof(blockBytes));
+            BlockHeader block = ArchiveWriter::readBlockHeader(blockBytes);
+            if (i + 1 == points.size()) {
+                baseInput = points[i].offset + block.originalSize;
+            }
+            if (block.type != Common::BLOCK_HUFFMAN) continue;
+            uint64_t tableStart = position + BlockHeader::SIZE;
+            table.resize(std::min<uint64_t>(ArchiveWriter::tableBound(), endOffset - tableStart));
+            readAt(tableStart, table.data(), table.size());
+            ArchiveWriter::readFrequencies(table.data(), table.size(), block.frequencyBits, lastFreqs.data());
+            lastBits = block.frequencyBits;
+            haveTable = true;
+            break;
+        }
+
+        compressor.resume(existing, endOffset - ArchiveHeader::SIZE, baseInput,
+                          haveTable ? lastFreqs.data() : nullptr, lastBits);
+        writePos = endOffset;
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+}
+
+StreamAppender::~StreamAppender() {
+    if (fd < 0) return;
+    try {
+        finish();
+    } catch (const std::exception&) {
+        // Деструктор не бросает; ошибку покажет явный вызов finish()
+    }
+    if (fd >= 0) close(fd);
+}
+
+void StreamAppender::readAt(uint64_t offset, uint8_t* dst, size_t size) {
+    while (size > 0) {
+        ssize_t n = pread(fd, dst, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            throw std::runtime_error("Archive is truncated");
+        }
+        dst += n;
+        offset += static_cast<uint64_t>(n);
+        size -= static_cast<size_t>(n);
+    }
+}
+
+void StreamAppender::writeAt(uint64_t offset, const uint8_t* src, size_t size) {
+    while (size > 0) {
+        ssize_t n = pwrite(fd, src, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("Write error: ") + std::strerror(errno));
+        }
+        src += n;
+        offset += static_cast<uint64_t>(n);
+        size -= static_cast<size_t>(n);
+    }
+}
+
+uint64_t StreamAppender::locateEnd(uint64_t fileSize, SeekIndex& existing) {
+    uint64_t endOffset = 0;
+    bool indexed = false;
+    uint64_t minimum = ArchiveHeader::SIZE + BlockHeader::SIZE + SeekIndex::HEADER_SIZE +
+                       StreamCompressor::INDEX_TRAILER_SIZE;
+    if (fileSize >= minimum) {
+        uint8_t trailer[StreamCompressor::INDEX_TRAILER_SIZE];
+        uint32_t signature;
+        readAt(fileSize - sizeof(trailer), trailer, sizeof(trailer));
+        std::memcpy(&endOffset, trailer, sizeof(endOffset));
+        std::memcpy(&signature, trailer + 8, sizeof(signature));
+        if (signature == StreamCompressor::INDEX_TRAILER_SIGNATURE) {
+            if (endOffset < ArchiveHeader::SIZE || endOffset > fileSize - minimum + ArchiveHeader::SIZE) {
+                throw std::runtime_error("Corrupted block index");
+            }
+            uint64_t indexStart = endOffset + BlockHeader::SIZE;
+            std::vector<uint8_t> bytes(fileSize - sizeof(trailer) - indexStart);
+            readAt(indexStart, bytes.data(), bytes.size());
+            if (!existing.read(bytes.data(), bytes.size())) {
+                throw std::runtime_error("Corrupted block index");
+            }
+            indexed = true;
+        }
+    }
+
+    if (!indexed) {
+        // Индекса нет: проход по заголовкам блоков до маркера конца
+        std::vector<uint8_t> table;
+        uint64_t position = ArchiveHeader::SIZE;
+        uint64_t input = 0;
+        for (;;) {
+            if (position + BlockHeader::SIZE > fileSize) {
+                throw std::runtime_error("Archive is truncated");
+            }
+            uint8_t blockBytes[BlockHeader::SIZE];
+            readAt(position, blockBytes, sizeof(blockBytes));
+            BlockHeader block = ArchiveWriter::readBlockHeader(blockBytes);
+            if (block.type == Common::BLOCK_END) break;
+            uint64_t tableStart = position + BlockHeader::SIZE;
+            table.resize(std::min<uint64_t>(ArchiveWriter::tableBound(), fileSize - tableStart));
+            readAt(tableStart, table.data(), table.size());
+            size_t tableSize = ArchiveWriter::readTableSize(table.data(), table.size(), block.frequencyBits);
+            existing.add(input, (position - ArchiveHeader::SIZE) * 8);
+            input += block.originalSize;
+            position = tableStart + tableSize + block.compressedSize;
+        }
+        endOffset = position;
+    }
+
+    uint8_t endBytes[BlockHeader::SIZE];
+    readAt(endOffset, endBytes, sizeof(endBytes));
+    if (ArchiveWriter::readBlockHeader(endBytes).type != Common::BLOCK_END) {
+        throw std::runtime_error("Stream end marker not found");
+    }
+    return endOffset;
+}
+
+void StreamAppender::pump(StreamBuffers& strm, FlushMode flush) {
+    bool done;
+    do {
+        strm.nextOut = outBuf.data();
+        strm.availOut = outBuf.size();
+        done = compressor.compress(strm, flush);
+        size_t produced = outBuf.size() - strm.availOut;
+        writeAt(writePos, outBuf.data(), produced);
+        writePos += produced;
+    } while (!done);
+}
+
+void StreamAppender::append(const uint8_t* data, size_t size) {
+    if (finished) {
+        throw std::logic_error("Append is already finished");
+    }
+    StreamBuffers strm;
+    strm.nextIn = data;
+    strm.availIn = size;
+    pump(strm, FlushMode::NONE);
+    appended += size;
+}
+
+void StreamAppender::finish() {
+    if (finished) return;
+    finished = true;
+    StreamBuffers strm;
+    pump(strm, FlushMode::FINISH);
+    if (ftruncate(fd, static_cast<off_t>(writePos)) != 0) {
+        throw std::runtime_error(std::string("Cannot truncate archive: ") + std::strerror(errno));
+    }
+
+    // Только итоговые размеры в заголовке
+    header.originalSize = baseInput + appended;
+    header.compressedSize = writePos - ArchiveHeader::SIZE;
+    uint8_t bytes[ArchiveHeader::SIZE];
+    ArchiveWriter::writeHeader(bytes, header);
+    writeAt(8, bytes + 8, 16);
+    if (close(fd) != 0) {
+        fd = -1;
+        throw std::runtime_error(std::string("Close error: ") + std::strerror(errno));
+    }
+    fd = -1;
+}
+
+StreamDecompressor::StreamDecompressor()
+    : inputPos(0), outputPos(0), headerRead(false), streamFinished(false) {}
+
+StreamDecompressor::StreamDecompressor(const ArchiveHeader& header)
+    : inputPos(0), outputPos(0), headerRead(true), streamFinished(false) {
+    if (header.signature != Common::SIGNATURE || header.version != Common::VERSION_4) {
+        throw std::runtime_error("Not a stream archive");
+    }
+    if (header.filter != 0) {
+        throw std::runtime_error("Stream archives do not support filters");
+    }
+}
+
+bool StreamDecompressor::decompress(StreamBuffers& strm) {
+    for (;;) {
+        drain(strm);
+        if (outputPos < output.size()) return false;
+        output.clear();
+        outputPos = 0;
+
+        if (streamFinished) return true;
+
+        if (strm.availIn > 0) {
+            if (inputPos > 0) {
+                input.erase(input.begin(), input.begin() + inputPos);
+                inputPos = 0;
+            }
+            input.insert(input.end(), strm.nextIn, strm.nextIn + strm.availIn);
+            strm.nextIn += strm.availIn;
+            strm.totalIn += strm.availIn;
+            strm.availIn = 0;
+        }
+
+        if (!parse()) return false;
+    }
+}
+
+bool StreamDecompressor::parse() {
+    const uint8_t* data = input.data() + inputPos;
+    size_t avail = input.size() - inputPos;
+
+    if (!headerRead) {
+        if (avail < ArchiveHeader::SIZE) return false;
+        ArchiveHeader header = ArchiveWriter::readHeader(data);
+        if (header.signature != Common::SIGNATURE) {
+            throw std::runtime_error("Invalid signature");
+        }
+        if (header.version != Common::VERSION_4) {
+            throw std::runtime_error("Unsupported stream version: " + std::to_string(header.version));
+        }
+        if (header.filter != 0) {
+            throw std::runtime_error("Stream archives do not support filters");
+        }
+        headerRead = true;
+        inputPos += ArchiveHeader::SIZE;
+        return true;
+    }
+
+    if (avail < BlockHeader::SIZE) return false;
+    BlockHeader block = ArchiveWriter::readBlockHeader(data);
+
+    if (block.type == Common::BLOCK_END) {
+        inputPos += BlockHeader::SIZE;
+        streamFinished = true;
+        return true;
+    }
+    if (block.type != Common::BLOCK_HUFFMAN && block.type != Common::BLOCK_STORED &&
+        block.type != Common::BLOCK_REPEAT) {
+        throw std::runtime_error("Unsupported block type: " + std::to_string(block.type));
+    }
+
+    size_t tableSize = 0;
+    if (!ArchiveWriter::tryReadTableSize(data + BlockHeader::SIZE, avail - BlockHeader::SIZE,
+                                         block.frequencyBits, tableSize)) {
+        return false;
+    }
+    size_t blockBytes = BlockHeader::SIZE + tableSize + block.compressedSize;
+    if (avail < blockBytes) return false;
+
+    output.resize(block.originalSize);
+    if (block.type == Common::BLOCK_REPEAT) {
+        context.decompressRepeat(data + BlockHeader::SIZE, block.compressedSize, output.data(), block.originalSize);
+        inputPos += blockBytes;
+        return true;
+    }
+    Common::Algorithm algorithm = block.type == Common::BLOCK_STORED ? Common::ALGO_STORED : Common::ALGO_HUFFMAN;
+    context.decompressBody(algorithm, block.frequencyBits, data + BlockHeader::SIZE, tableSize,
+                           block.compressedSize, output.data(), block.originalSize);
+
+    inputPos += blockBytes;
+    return true;
+}
+
+void StreamDecompressor::drain(StreamBuffers& strm) {
+    size_t count = std::min(strm.availOut, output.size() - outputPos);
+    if (count == 0) return;
+    std::memcpy(strm.nextOut, output.data() + outputPos, count);
+    outputPos += count;
+    strm.nextOut += count;
+    strm.availOut -= count;
+    strm.totalOut += count;
+}
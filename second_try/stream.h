@@ -0,0 +1,157 @@
+// stream.h - потоковое (push) сжатие в стиле z_stream
+#pragma once
+#include "common.h"
+#include "archive_format.h"
+#include "codec.h"
+#include "block_split.h"
+#include "seek_index.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Режим сброса при вызове compress()
+enum class FlushMode {
+    NONE,   // копить вход до заполнения блока
+    SYNC,   // закончить текущий блок на границе байта: получатель
+            // сможет декодировать всё, что передано до этой точки
+    FINISH  // закончить текущий блок и записать маркер конца потока
+};
+
+// Буферы вызывающей стороны. Как и в z_stream, указатели и счётчики
+// сдвигаются по мере потребления входа и заполнения выхода.
+struct StreamBuffers {
+    const uint8_t* nextIn = nullptr;
+    size_t availIn = 0;
+    uint8_t* nextOut = nullptr;
+    size_t availOut = 0;
+    uint64_t totalIn = 0;
+    uint64_t totalOut = 0;
+};
+
+// Кодирует вход произвольными порциями в формат VERSION_4:
+// заголовок архива, затем блоки Хаффмана со своими таблицами частот.
+// С setSplitBlocks(true) накопленный вход (до blockSize байт) делится
+// на блоки по стоимости (BlockSplitter), и блок может повторно
+// использовать таблицу предыдущего.
+class StreamCompressor {
+public:
+    explicit StreamCompressor(size_t blockSize = Common::DEFAULT_BLOCK_SIZE);
+
+    // Потребляет вход и выдаёт готовые данные. Возвращает true, если вход
+    // исчерпан и весь накопленный выход отдан; false - нужно больше места в nextOut.
+    bool compress(StreamBuffers& strm, FlushMode flush);
+
+    bool finished() const { return streamFinished && outputPos == output.size(); }
+
+    void setSplitBlocks(bool enabled) { splitBlocks = enabled; }
+    const BlockSplitter& splitStats() const { return splitter; }
+
+    // Индекс блоков (SeekIndex, точка на каждый блок) за маркером конца и
+    // хвост INDEX_TRAILER_SIZE байт: смещение маркера конца от начала архива
+    // (uint64) и сигнатура "HBIX". По ним StreamAppender находит конец
+    // архива и последнюю таблицу; декодер данные за маркером конца не читает.
+    void setBlockIndex(bool enabled) { blockIndex = enabled; }
+    const SeekIndex& blockIndexEntries() const { return index; }
+
+    // Продолжить существующий поток вместо нового: заголовок не пишется,
+    // блоки идут за blocksSize байт прежних блоков с inputSize байт входа,
+    // existing - их индекс. lastFreqs - частоты последнего блока
+    // BLOCK_HUFFMAN разрядности lastBits (nullptr - такого блока нет): его
+    // код может взять первый новый блок. Включает индекс и разбиение блоков.
+    void resume(const SeekIndex& existing, uint64_t blocksSize, uint64_t inputSize, const uint64_t* lastFreqs,
+                int lastBits);
+
+    static const uint32_t INDEX_TRAILER_SIGNATURE = 0x58494248; // "HBIX" в little-endian
+    static const size_t INDEX_TRAILER_SIZE = 12;
+
+private:
+    void emitHeader();
+    void emitBlock();
+    void emitEnd();
+    void indexBlocks(size_t offset);
+    void drain(StreamBuffers& strm);
+
+    size_t blockSize;
+    bool splitBlocks;
+    bool blockIndex;
+    SeekIndex index;
+    uint64_t blocksSize;    // байт блоков от конца заголовка архива
+    uint64_t inputSize;     // байт входа в этих блоках
+    CompressContext context;
+    BlockSplitter splitter;
+    std::vector<uint8_t> pending;   // вход текущего блока
+    std::vector<uint8_t> output;    // закодированные, но ещё не отданные байты
+    size_t outputPos;
+    bool headerWritten;
+    bool streamFinished;
+};
+
+// Дописывает вход в конец файла потокового архива без перекодирования
+// прежних данных. Новые блоки пишутся на место старого маркера конца, за
+// ними - маркер конца, индекс блоков и хвост; в заголовке исправляются
+// итоговые размеры. По индексу находится таблица последнего блока
+// Хаффмана, и первый новый блок может её повторно использовать. Архив без
+// индекса один раз просматривается по заголовкам блоков (без чтения
+// данных), после дописывания индекс в нём есть. Пока не вызван finish()
+// (или деструктор), архив не завершён. Испорченный архив - std::runtime_error
+class StreamAppender {
+public:
+    static const size_t DEFAULT_CHUNK_SIZE = 4 << 20;
+
+    explicit StreamAppender(const std::string& filename, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+    ~StreamAppender();
+
+    StreamAppender(const StreamAppender&) = delete;
+    StreamAppender& operator=(const StreamAppender&) = delete;
+
+    void append(const uint8_t* data, size_t size);
+    void finish();
+
+    uint64_t previousSize() const { return baseInput; }
+    uint64_t appendedBytes() const { return appended; }
+    uint64_t archiveSize() const { return writePos; }
+    const BlockSplitter& splitStats() const { return compressor.splitStats(); }
+
+private:
+    void readAt(uint64_t offset, uint8_t* dst, size_t size);
+    void writeAt(uint64_t offset, const uint8_t* src, size_t size);
+    // Находит маркер конца и индекс блоков (по хвосту или просмотром блоков)
+    uint64_t locateEnd(uint64_t fileSize, SeekIndex& existing);
+    void pump(StreamBuffers& strm, FlushMode flush);
+
+    int fd;
+    ArchiveHeader header;
+    uint64_t baseInput;
+    uint64_t appended;
+    uint64_t writePos;
+    bool finished;
+    StreamCompressor compressor;
+    std::vector<uint8_t> outBuf;
+};
+
+// Декодирует поток VERSION_4 порциями. Блок декодируется, как только
+// он получен целиком, поэтому задержка ограничена размером блока.
+class StreamDecompressor {
+public:
+    StreamDecompressor();
+    // Для случая, когда заголовок архива уже прочитан вызывающей стороной
+    explicit StreamDecompressor(const ArchiveHeader& header);
+
+    // Возвращает true, когда прочитан маркер конца потока и весь выход отдан
+    bool decompress(StreamBuffers& strm);
+
+    bool finished() const { return streamFinished && outputPos == output.size(); }
+
+private:
+    bool parse();
+    void drain(StreamBuffers& strm);
+
+    DecompressContext context;
+    std::vector<uint8_t> input;     // принятые, но ещё не разобранные байты
+    size_t inputPos;
+    std::vector<uint8_t> output;
+    size_t outputPos;
+    bool headerRead;
+    bool streamFinished;
+};
@@ -0,0 +1,122 @@
+#include "table_library.h"
+#include "archive_format.h"
+#include "container.h"
+#include "frequency.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+    // Заголовок файла: сигнатура, номер, разрядность таблицы, длина имени
+    const size_t FILE_HEADER_SIZE = 10;
+
+    std::vector<uint8_t> serializeTable(const std::vector<uint64_t>& freqs, int& bits) {
+        bits = ArchiveWriter::compactTableBits(freqs.data());
+        std::vector<uint8_t> table(ArchiveWriter::tableSize(freqs.data(), bits));
+        ArchiveWriter::writeFrequencies(table.data(), freqs.data(), bits);
+        return table;
+    }
+}
+
+PretrainedTable PretrainedTable::train(const std::string& name, const uint64_t* counts) {
+    if (name.size() > UINT8_MAX) {
+        throw std::invalid_argument("Table name is longer than 255 bytes");
+    }
+    std::vector<uint64_t> floored(counts, counts + Common::ALPHABET_SIZE);
+    for (uint64_t& count : floored) {
+        count += 1;
+    }
+
+    PretrainedTable table;
+    table.name = name;
+    table.frequencies = FrequencyNormalizer::normalizeToBits(floored, TRAINED_BITS);
+    int bits;
+    std::vector<uint8_t> serialized = serializeTable(table.frequencies, bits);
+    table.id = crc32(serialized.data(), serialized.size());
+    return table;
+}
+
+void PretrainedTable::save(const std::string& filename) const {
+    int bits;
+    std::vector<uint8_t> serialized = serializeTable(frequencies, bits);
+    uint8_t header[FILE_HEADER_SIZE];
+    std::memcpy(header, &SIGNATURE, sizeof(SIGNATURE));
+    std::memcpy(header + 4, &id, sizeof(id));
+    header[8] = static_cast<uint8_t>(bits);
+    header[9] = static_cast<uint8_t>(name.size());
+
+    std::ofstream out(filename, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(name.data(), static_cast<std::streamsize>(name.size()));
+    out.write(reinterpret_cast<const char*>(serialized.data()), static_cast<std::streamsize>(serialized.size()));
+    if (!out) {
+        throw std::runtime_error("Cannot write table file: " + filename);
+    }
+}
+
+PretrainedTable PretrainedTable::load(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open table file: " + filename);
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    uint32_t signature = 0;
+    PretrainedTable table;
+    if (data.size() >= FILE_HEADER_SIZE) {
+        std::memcpy(&signature, data.data(), sizeof(signature));
+        std::memcpy(&table.id, data.data() + 4, sizeof(table.id));
+    }
+    if (signature != SIGNATURE || data.size() < FILE_HEADER_SIZE + data[9]) {
+        throw std::runtime_error("Not a table file: " + filename);
+    }
+    int bits = data[8];
+    size_t nameSize = data[9];
+    table.name.assign(reinterpret_cast<const char*>(data.data() + FILE_HEADER_SIZE), nameSize);
+
+    const uint8_t* serialized = data.data() + FILE_HEADER_SIZE + nameSize;
+    size_t avail = data.size() - FILE_HEADER_SIZE - nameSize;
+    table.frequencies.resize(Common::ALPHABET_SIZE);
+    size_t tableSize = ArchiveWriter::readFrequencies(serialized, avail, bits, table.frequencies.data());
+    bool complete = std::find(table.frequencies.begin(), table.frequencies.end(), 0) == table.frequencies.end();
+    if (!complete || crc32(serialized, tableSize) != table.id) {
+        throw std::runtime_error("Corrupted table file: " + filename);
+    }
+    return table;
+}
+
+TableLibrary::TableLibrary(std::string directory) : directory(std::move(directory)) {}
+
+std::string TableLibrary::fileName(uint32_t id) {
+    char name[16];
+    std::snprintf(name, sizeof(name), "%08x.htab", id);
+    return name;
+}
+
+std::string TableLibrary::path(uint32_t id) const {
+    return directory + "/" + fileName(id);
+}
+
+const PretrainedTable& TableLibrary::add(PretrainedTable table) {
+    uint32_t id = table.id;
+    return tables[id] = std::move(table);
+}
+
+const PretrainedTable& TableLibrary::get(uint32_t id) {
+    auto found = tables.find(id);
+    if (found != tables.end()) {
+        return found->second;
+    }
+    if (directory.empty()) {
+        throw std::runtime_error("Unknown pretrained table " + fileName(id));
+    }
+    PretrainedTable table = PretrainedTable::load(path(id));
+    if (table.id != id) {
+        throw std::runtime_error("Table file " + path(id) + " holds another table");
+    }
+    return add(std::move(table));
+}
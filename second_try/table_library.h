@@ -0,0 +1,58 @@
+// table_library.h - обученные таблицы частот с постоянными номерами
+#pragma once
+#include "common.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Таблица частот, обученная на образцах данных. Для коротких сообщений
+// своя таблица и проход гистограммы стоят больше, чем дают точные частоты:
+// архив с обученной таблицей хранит вместо неё только номер
+// (ArchiveWriter::PRETRAINED_TABLE), а кодер не считает гистограмму.
+// Номер - crc32 записанной таблицы: одни и те же частоты всегда получают
+// один номер, а подменённый или испорченный файл не загрузится.
+// Файл таблицы: сигнатура "HTBL", номер (uint32), разрядность таблицы,
+// длина имени (uint8), имя и таблица в компактной форме (ArchiveWriter).
+struct PretrainedTable {
+    static const uint32_t SIGNATURE = 0x4C425448; // "HTBL" в little-endian
+    // Разрядность нормировки: точности хватает с запасом, а коды редких
+    // символов остаются короче PrefixCode::MAX_CODE_LENGTH
+    static const int TRAINED_BITS = 16;
+
+    uint32_t id;
+    std::string name;                   // для людей, на номер не влияет
+    std::vector<uint64_t> frequencies;  // ALPHABET_SIZE значений, все ненулевые
+
+    // Таблица по счётчикам байт образцов (ALPHABET_SIZE значений). Каждому
+    // символу добавляется 1: байт, которого не было в образцах, тоже
+    // получает код. Имя - до 255 байт (иначе std::invalid_argument)
+    static PretrainedTable train(const std::string& name, const uint64_t* counts);
+
+    void save(const std::string& filename) const;
+    // std::runtime_error, если файл не читается, испорчен или номер не
+    // совпадает с содержимым
+    static PretrainedTable load(const std::string& filename);
+};
+
+// Набор обученных таблиц по номерам: добавленные в память и файлы
+// каталога directory с именами fileName(id), читаемые при первом обращении
+class TableLibrary {
+public:
+    // Пустой каталог - только таблицы, переданные в add()
+    explicit TableLibrary(std::string directory = ".");
+
+    // "0123abcd.htab": номер в шестнадцатеричном виде
+    static std::string fileName(uint32_t id);
+    std::string path(uint32_t id) const;
+
+    const PretrainedTable& add(PretrainedTable table);
+    // Таблица с номером id; std::runtime_error, если её нет ни в памяти, ни в каталоге
+    const PretrainedTable& get(uint32_t id);
+
+private:
+    std::string directory;
+    // Узлы map не перемещаются: ссылки из get() живут, пока жива библиотека
+    std::map<uint32_t, PretrainedTable> tables;
+};
@@ -0,0 +1,158 @@
+#include "tans.h"
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+static int highBit(uint32_t value) {
+    return 31 - __builtin_clz(value);
+}
+
+TansCode::TansCode(std::pmr::memory_resource* resource)
+    : log(0), normalized(resource), next(resource), spread(resource), stateTable(resource),
+      transforms(resource), decodeTable(resource) {}
+
+void TansCode::build(const uint64_t* frequencies, size_t alphabetSize) {
+    if (alphabetSize > 256) {
+        throw std::invalid_argument("tANS alphabet is limited to 256 symbols");
+    }
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < alphabetSize; i++) {
+        total += frequencies[i];
+    }
+    if (total == 0 || (total & (total - 1)) != 0) {
+        throw std::runtime_error("tANS frequencies must sum to a power of two");
+    }
+    if (total < (1u << MIN_TABLE_LOG) || total > (1u << MAX_TABLE_LOG)) {
+        throw std::runtime_error("Unsupported tANS table size: " + std::to_string(total));
+    }
+    log = highBit(static_cast<uint32_t>(total));
+
+    const uint32_t tableSize = 1u << log;
+    normalized.assign(alphabetSize, 0);
+    next.assign(alphabetSize, 0);
+    spread.assign(tableSize, 0);
+    stateTable.assign(tableSize, 0);
+    transforms.assign(alphabetSize, SymbolTransform{0, 0});
+    decodeTable.assign(tableSize, DecodeEntry{0, 0, 0});
+
+    // Раскладка символов по таблице с нечётным шагом: каждая ячейка
+    // посещается ровно один раз, вхождения символа разнесены по таблице
+    const uint32_t mask = tableSize - 1;
+    const uint32_t step = (tableSize >> 1) + (tableSize >> 3) + 3;
+    uint32_t position = 0;
+    for (size_t s = 0; s < alphabetSize; s++) {
+        normalized[s] = static_cast<uint32_t>(frequencies[s]);
+        for (uint32_t i = 0; i < normalized[s]; i++) {
+            spread[position] = static_cast<uint8_t>(s);
+            position = (position + step) & mask;
+        }
+    }
+
+    // Переходы кодера и декодера. Состояния кодера - [tableSize, 2*tableSize),
+    // состояния декодера - индексы [0, tableSize).
+    uint32_t cumulative = 0;
+    for (size_t s = 0; s < alphabetSize; s++) {
+        uint32_t f = normalized[s];
+        next[s] = f;
+        if (f == 0) continue;
+        int maxBitsOut = f == 1 ? log : log - highBit(f - 1);
+        transforms[s].deltaNbBits = (static_cast<uint32_t>(maxBitsOut) << 16) - (f << maxBitsOut);
+        transforms[s].deltaFindState = static_cast<int32_t>(cumulative) - static_cast<int32_t>(f);
+        cumulative += f;
+    }
+
+    // next[s] пробегает [f, 2f): номер очередного вхождения символа
+    for (uint32_t u = 0; u < tableSize; u++) {
+        uint8_t s = spread[u];
+        uint32_t x = next[s]++;
+        int nbBits = log - highBit(x);
+        decodeTable[u] = {static_cast<uint16_t>((x << nbBits) - tableSize), s, static_cast<uint8_t>(nbBits)};
+        int32_t index = static_cast<int32_t>(x) + transforms[s].deltaFindState;
+        stateTable[index] = static_cast<uint16_t>(tableSize + u);
+    }
+}
+
+size_t TansCode::encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) const {
+    uint64_t buffer = 0;
+    int bitCount = 0;
+    size_t pos = 0;
+
+    // Биты копятся в 64-битном буфере и выгружаются по 4 байта:
+    // за символ добавляется не больше MAX_TABLE_LOG бит
+    auto put = [&](uint32_t value, int count) {
+        buffer |= static_cast<uint64_t>(value) << bitCount;
+        bitCount += count;
+        if (bitCount >= 32) {
+            if (capacity - pos < 4) {
+                throw std::length_error("Destination buffer too small");
+            }
+            for (int i = 0; i < 4; i++) {
+                dst[pos++] = static_cast<uint8_t>(buffer >> (8 * i));
+            }
+            buffer >>= 32;
+            bitCount -= 32;
+        }
+    };
+
+    const uint32_t tableSize = 1u << log;
+    uint32_t state = tableSize;
+    for (size_t i = size; i-- > 0;) {
+        uint8_t symbol = src[i];
+        if (symbol >= normalized.size() || normalized[symbol] == 0) {
+            throw std::invalid_argument("Symbol without frequency: " + std::to_string(symbol));
+        }
+        const SymbolTransform& t = transforms[symbol];
+        uint32_t nbBits = (state + t.deltaNbBits) >> 16;
+        put(state & ((1u << nbBits) - 1), static_cast<int>(nbBits));
+        state = stateTable[static_cast<int32_t>(state >> nbBits) + t.deltaFindState];
+    }
+
+    put(state - tableSize, log);
+    put(1, 1);
+    while (bitCount > 0) {
+        if (pos >= capacity) {
+            throw std::length_error("Destination buffer too small");
+        }
+        dst[pos++] = static_cast<uint8_t>(buffer);
+        buffer >>= 8;
+        bitCount -= 8;
+    }
+    return pos;
+}
+
+void TansCode::decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size) const {
+    if (srcSize == 0 || src[srcSize - 1] == 0) {
+        throw std::runtime_error("Corrupted tANS stream: missing end marker");
+    }
+
+    // Позиция маркера; данные лежат в битах ниже неё
+    uint64_t bitPos = (srcSize - 1) * 8ULL + highBit(src[srcSize - 1]);
+
+    // Окно из 8 байт, начиная с windowStart; перезагружается, когда
+    // чтение уходит ниже его начала (примерно раз в 4 байта данных)
+    size_t windowStart = srcSize;
+    uint64_t window = 0;
+
+    auto read = [&](int count) -> uint32_t {
+        if (static_cast<uint64_t>(count) > bitPos) {
+            throw std::runtime_error("Corrupted tANS stream: unexpected end of data");
+        }
+        bitPos -= count;
+        if (bitPos < windowStart * 8ULL) {
+            size_t byte = static_cast<size_t>(bitPos >> 3);
+            windowStart = byte >= 4 ? byte - 4 : 0;
+            window = 0;
+            std::memcpy(&window, src + windowStart, std::min<size_t>(8, srcSize - windowStart));
+        }
+        return static_cast<uint32_t>(window >> (bitPos - windowStart * 8ULL)) & ((1u << count) - 1);
+    };
+
+    uint32_t state = read(log);
+    for (size_t i = 0; i < size; i++) {
+        const DecodeEntry& entry = decodeTable[state];
+        dst[i] = entry.symbol;
+        state = entry.newState + read(entry.nbBits);
+    }
+}
@@ -0,0 +1,51 @@
+// tans.h - табличная асимметричная система счисления (tANS, как в FSE)
+#pragma once
+#include "common.h"
+#include <memory_resource>
+#include <cstdint>
+#include <cstddef>
+
+// Энтропийный кодер с дробной стоимостью символа: на символ уходит
+// log2(2^tableLog / f) бит в среднем, а декодирование - один поиск в таблице
+// на символ. Частоты должны быть нормированы так, чтобы их сумма была
+// степенью двойки (см. FrequencyNormalizer::normalizeToSum).
+//
+// Формат данных: кодер идёт по входу с конца и пишет биты младшими вперёд,
+// в конце - итоговое состояние (tableLog бит) и маркерный бит 1.
+// Декодер читает поток с конца от маркера и выдаёт символы в прямом порядке.
+class TansCode {
+public:
+    static const int TABLE_LOG = 12;
+    static const int MIN_TABLE_LOG = 5;
+    static const int MAX_TABLE_LOG = 15;
+
+    explicit TansCode(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void build(const uint64_t* frequencies, size_t alphabetSize);
+
+    int tableLog() const { return log; }
+
+    // Возвращает число записанных байт; std::length_error, если не хватает места
+    size_t encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) const;
+    void decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size) const;
+
+private:
+    struct DecodeEntry {
+        uint16_t newState;  // база следующего состояния, к ней прибавляются nbBits прочитанных бит
+        uint8_t symbol;
+        uint8_t nbBits;
+    };
+
+    struct SymbolTransform {
+        int32_t deltaFindState;  // смещение группы символа в stateTable
+        uint32_t deltaNbBits;    // (state + deltaNbBits) >> 16 - число бит на выход
+    };
+
+    int log;
+    std::pmr::vector<uint32_t> normalized;
+    std::pmr::vector<uint32_t> next;
+    std::pmr::vector<uint8_t> spread;
+    std::pmr::vector<uint16_t> stateTable;
+    std::pmr::vector<SymbolTransform> transforms;
+    std::pmr::vector<DecodeEntry> decodeTable;
+};
@@ -0,0 +1,63 @@
+#include "common.h"
+#include "table_library.h"
+#include "mapped_output.h"
+#include "prefix_code.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--name NAME] <output dir> <sample files...>" << std::endl;
+    std::cerr << "  Builds a frequency table from the byte counts of all sample files and saves it" << std::endl;
+    std::cerr << "  as <output dir>/<id>.htab; encoder --table <id> codes with it" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string name;
+    int arg = 1;
+    if (arg + 1 < argc && std::string(argv[arg]) == "--name") {
+        name = argv[arg + 1];
+        arg += 2;
+    }
+    if (argc - arg < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    std::string directory = argv[arg];
+
+    try {
+        std::vector<uint64_t> counts(Common::ALPHABET_SIZE, 0);
+        uint64_t total = 0;
+        for (int i = arg + 1; i < argc; i++) {
+            MappedInput input(argv[i]);
+            for (size_t j = 0; j < input.size(); j++) {
+                counts[input.data()[j]]++;
+            }
+            total += input.size();
+        }
+        if (name.empty()) {
+            name = argv[arg + 1];
+        }
+
+        PretrainedTable table = PretrainedTable::train(name, counts.data());
+        std::string path = directory + "/" + TableLibrary::fileName(table.id);
+        table.save(path);
+
+        // Средняя длина кода на самих образцах - нижняя граница для похожих данных
+        PrefixCode code;
+        code.buildHuffmanCodes(table.frequencies.data(), Common::ALPHABET_SIZE);
+        uint64_t bits = code.encodedBits(counts.data(), Common::ALPHABET_SIZE);
+        std::cout << "Table " << TableLibrary::fileName(table.id) << " (" << table.name << ") trained on "
+                  << argc - arg - 1 << " files, " << total << " bytes" << std::endl;
+        if (total > 0) {
+            std::cout << "Code on the samples: " << static_cast<double>(bits) / total << " bits per byte" << std::endl;
+        }
+        std::cout << "Saved to " << path << "; use encoder --table " << std::hex << table.id << std::dec
+                  << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Training error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include "utf8_code.h"
+#include "archive_format.h"
+#include "frequency.h"
+#include "bitstream.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    const uint32_t FIRST_TABLE_BASE = 0x7F;  // кодовые точки таблицы больше ASCII
+
+    // Байты UTF-8 кодовой точки в порядке записи
+    uint32_t encodeSequence(uint32_t codepoint, uint32_t& length) {
+        uint8_t bytes[4] = {0, 0, 0, 0};
+        if (codepoint < 0x800) {
+            length = 2;
+            bytes[0] = static_cast<uint8_t>(0xC0 | (codepoint >> 6));
+            bytes[1] = static_cast<uint8_t>(0x80 | (codepoint & 0x3F));
+        } else if (codepoint < 0x10000) {
+            length = 3;
+            bytes[0] = static_cast<uint8_t>(0xE0 | (codepoint >> 12));
+            bytes[1] = static_cast<uint8_t>(0x80 | ((codepoint >> 6) & 0x3F));
+            bytes[2] = static_cast<uint8_t>(0x80 | (codepoint & 0x3F));
+        } else {
+            length = 4;
+            bytes[0] = static_cast<uint8_t>(0xF0 | (codepoint >> 18));
+            bytes[1] = static_cast<uint8_t>(0x80 | ((codepoint >> 12) & 0x3F));
+            bytes[2] = static_cast<uint8_t>(0x80 | ((codepoint >> 6) & 0x3F));
+            bytes[3] = static_cast<uint8_t>(0x80 | (codepoint & 0x3F));
+        }
+        uint32_t packed;
+        std::memcpy(&packed, bytes, sizeof(packed));
+        return packed;
+    }
+}
+
+size_t Utf8Code::sequenceLength(const uint8_t* src, size_t avail, uint32_t& codepoint) {
+    uint8_t lead = src[0];
+    size_t length;
+    uint32_t minimum;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+        minimum = 0x80;
+        codepoint = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        minimum = 0x800;
+        codepoint = lead & 0x0F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        minimum = 0x10000;
+        codepoint = lead & 0x07;
+    } else {
+        return 0;
+    }
+    if (avail < length) return 0;
+    for (size_t i = 1; i < length; i++) {
+        if ((src[i] & 0xC0) != 0x80) return 0;
+        codepoint = (codepoint << 6) | (src[i] & 0x3F);
+    }
+    bool surrogate = codepoint >= 0xD800 && codepoint <= 0xDFFF;
+    if (codepoint < minimum || codepoint > MAX_CODEPOINT || surrogate) return 0;
+    return length;
+}
+
+Utf8Code::Utf8Code(std::pmr::memory_resource* resource)
+    : codepointCounts(resource),
+      touched(resource),
+      table(resource),
+      symbols(resource),
+      freqs(resource),
+      normalized(resource),
+      expansions(resource),
+      code(resource),
+      escapedBytes(0) {}
+
+void Utf8Code::countCodepoints(const uint8_t* src, size_t size) {
+    if (codepointCounts.empty()) {
+        codepointCounts.assign(MAX_CODEPOINT + 1, 0);
+    }
+    touched.clear();
+    size_t pos = 0;
+    while (pos < size) {
+        if (src[pos] < 0x80) {
+            pos++;
+            continue;
+        }
+        uint32_t codepoint;
+        size_t length = sequenceLength(src + pos, size - pos, codepoint);
+        if (length == 0) {
+            pos++;
+            continue;
+        }
+        if (codepointCounts[codepoint]++ == 0) {
+            touched.push_back(codepoint);
+        }
+        pos += length;
+    }
+}
+
+void Utf8Code::selectTable() {
+    table.clear();
+    for (uint32_t codepoint : touched) {
+        if (codepointCounts[codepoint] >= MIN_CODEPOINT_COUNT) {
+            table.push_back(codepoint);
+        }
+    }
+    if (table.size() > MAX_CODEPOINTS) {
+        std::nth_element(table.begin(), table.begin() + MAX_CODEPOINTS, table.end(),
+                         [this](uint32_t a, uint32_t b) { return codepointCounts[a] > codepointCounts[b]; });
+        table.resize(MAX_CODEPOINTS);
+    }
+    std::sort(table.begin(), table.end());
+
+    // Счётчики больше не нужны: на их месте - номера символов таблицы (0 - escape)
+    for (uint32_t codepoint : touched) {
+        codepointCounts[codepoint] = 0;
+    }
+    for (size_t i = 0; i < table.size(); i++) {
+        codepointCounts[table[i]] = static_cast<uint32_t>(Common::ALPHABET_SIZE + i);
+    }
+}
+
+void Utf8Code::tokenize(const uint8_t* src, size_t size) {
+    freqs.assign(Common::ALPHABET_SIZE + table.size(), 0);
+    symbols.resize(size);
+    escapedBytes = 0;
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos < size) {
+        uint8_t byte = src[pos];
+        if (byte >= 0x80) {
+            uint32_t codepoint;
+            size_t length = sequenceLength(src + pos, size - pos, codepoint);
+            uint32_t symbol = length != 0 ? codepointCounts[codepoint] : 0;
+            if (symbol != 0) {
+                symbols[count++] = static_cast<uint16_t>(symbol);
+                freqs[symbol]++;
+                pos += length;
+                continue;
+            }
+            escapedBytes++;
+        }
+        symbols[count++] = byte;
+        freqs[byte]++;
+        pos++;
+    }
+    symbols.resize(count);
+
+    for (uint32_t codepoint : table) {
+        codepointCounts[codepoint] = 0;
+    }
+}
+
+size_t Utf8Code::encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity,
+                        std::pmr::memory_resource* scratch) {
+    countCodepoints(src, size);
+    selectTable();
+    tokenize(src, size);
+
+    size_t offset = 0;
+    ArchiveWriter::writeVarint(dst, capacity, offset, static_cast<uint32_t>(table.size()));
+    uint32_t previous = FIRST_TABLE_BASE;
+    for (uint32_t codepoint : table) {
+        ArchiveWriter::writeVarint(dst, capacity, offset, codepoint - previous);
+        previous = codepoint;
+    }
+
+    size_t alphabet = Common::ALPHABET_SIZE + table.size();
+    normalized.resize(alphabet);
+    int bits = FrequencyAnalyzer::selectTableBits(freqs.data(), alphabet, normalized.data(), code, scratch);
+    size_t tableSize = ArchiveWriter::tableSize(normalized.data(), bits, alphabet);
+    if (capacity - offset < 1 + tableSize) {
+        throw std::length_error("Destination buffer too small");
+    }
+    dst[offset++] = static_cast<uint8_t>(bits);
+    offset += ArchiveWriter::writeFrequencies(dst + offset, normalized.data(), bits, alphabet);
+
+    BitWriter out(dst + offset, capacity - offset);
+    code.encode(symbols.data(), symbols.size(), out);
+    out.flush();
+    return offset + out.bytesWritten();
+}
+
+void Utf8Code::decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size) {
+    size_t offset = 0;
+    uint64_t count = ArchiveWriter::readVarint(src, srcSize, offset);
+    if (count > MAX_CODEPOINTS) {
+        throw std::runtime_error("Corrupted UTF-8 stream: codepoint table is too large");
+    }
+
+    expansions.resize(Common::ALPHABET_SIZE + count);
+    for (uint32_t byte = 0; byte < Common::ALPHABET_SIZE; byte++) {
+        uint8_t bytes[4] = {static_cast<uint8_t>(byte), 0, 0, 0};
+        std::memcpy(&expansions[byte].bytes, bytes, sizeof(bytes));
+        expansions[byte].length = 1;
+    }
+    uint32_t codepoint = FIRST_TABLE_BASE;
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t delta = ArchiveWriter::readVarint(src, srcSize, offset);
+        if (delta == 0 || delta > MAX_CODEPOINT - codepoint) {
+            throw std::runtime_error("Corrupted UTF-8 stream: invalid codepoint table");
+        }
+        codepoint += static_cast<uint32_t>(delta);
+        if (codepoint >= 0xD800 && codepoint <= 0xDFFF) {
+            throw std::runtime_error("Corrupted UTF-8 stream: invalid codepoint table");
+        }
+        Expansion& expansion = expansions[Common::ALPHABET_SIZE + i];
+        expansion.bytes = encodeSequence(codepoint, expansion.length);
+    }
+
+    if (offset >= srcSize) {
+        throw std::runtime_error("UTF-8 stream is truncated");
+    }
+    int bits = src[offset++];
+    size_t alphabet = Common::ALPHABET_SIZE + count;
+    freqs.resize(alphabet);
+    offset += ArchiveWriter::readFrequencies(src + offset, srcSize - offset, bits, freqs.data(), alphabet);
+    code.buildHuffman(freqs.data(), alphabet);
+
+    // Символ - до 4 байт за одно копирование; у конца буфера - только его длина
+    BitReader in(src + offset, srcSize - offset);
+    size_t pos = 0;
+    while (size - pos >= sizeof(uint32_t)) {
+        const Expansion& expansion = expansions[code.decodeSymbol(in)];
+        std::memcpy(dst + pos, &expansion.bytes, sizeof(uint32_t));
+        pos += expansion.length;
+    }
+    while (pos < size) {
+        const Expansion& expansion = expansions[code.decodeSymbol(in)];
+        if (expansion.length > size - pos) {
+            throw std::runtime_error("Corrupted UTF-8 stream: codepoint crosses the end of data");
+        }
+        std::memcpy(dst + pos, &expansion.bytes, expansion.length);
+        pos += expansion.length;
+    }
+
+    if (in.overrun()) {
+        throw std::runtime_error("Unexpected end of stream during decoding");
+    }
+}
@@ -0,0 +1,65 @@
+// utf8_code.h - код Хаффмана по кодовым точкам UTF-8
+#pragma once
+#include "common.h"
+#include "prefix_code.h"
+#include <memory_resource>
+#include <cstdint>
+#include <cstddef>
+
+// Алфавит из 256 байтовых символов и разреженной таблицы частых кодовых
+// точек не из ASCII: символ 256 + i - i-я кодовая точка таблицы. Буква
+// кириллицы кодируется одним кодом вместо двух байтовых.
+// Редкие кодовые точки (реже MIN_CODEPOINT_COUNT раз или сверх
+// MAX_CODEPOINTS) и байты, не образующие корректную последовательность UTF-8,
+// уходят в escape - байтовые символы 0x80..0xFF, поэтому сжимается любой вход.
+//
+// Формат данных: число кодовых точек таблицы (varint), сами точки по
+// возрастанию разностями (varint, первая - от 0x7F), разрядность таблицы
+// частот (1 байт), таблица частот алфавита 256 + N в формате ArchiveWriter,
+// затем поток кодов старшими битами вперёд.
+class Utf8Code {
+public:
+    static const uint32_t MAX_CODEPOINT = 0x10FFFF;
+    static const uint32_t MAX_CODEPOINTS = 4096;
+    static const uint32_t MIN_CODEPOINT_COUNT = 4;
+
+    // Длина корректной многобайтовой последовательности в начале src
+    // (кодовая точка - в codepoint) или 0, если её там нет: ASCII, обрыв,
+    // избыточная запись, суррогат или значение больше MAX_CODEPOINT
+    static size_t sequenceLength(const uint8_t* src, size_t avail, uint32_t& codepoint);
+
+    explicit Utf8Code(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Возвращает размер закодированных данных; std::length_error, если не хватает места.
+    // Временные массивы нормировки берутся из scratch.
+    size_t encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity,
+                  std::pmr::memory_resource* scratch);
+    void decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size);
+
+    // Статистика последнего encode
+    uint32_t lastCodepoints() const { return static_cast<uint32_t>(table.size()); }
+    uint64_t lastEscapedBytes() const { return escapedBytes; }
+
+private:
+    // Байты символа для декодирования: до 4 байт UTF-8 и их число
+    struct Expansion {
+        uint32_t bytes;
+        uint32_t length;
+    };
+
+    void countCodepoints(const uint8_t* src, size_t size);
+    void selectTable();
+    void tokenize(const uint8_t* src, size_t size);
+
+    // Счётчики по всем кодовым точкам, затем номера символов таблицы;
+    // между вызовами обнуляются только затронутые элементы
+    std::pmr::vector<uint32_t> codepointCounts;
+    std::pmr::vector<uint32_t> touched;
+    std::pmr::vector<uint32_t> table;
+    std::pmr::vector<uint16_t> symbols;
+    std::pmr::vector<uint64_t> freqs;
+    std::pmr::vector<uint64_t> normalized;
+    std::pmr::vector<Expansion> expansions;
+    PrefixCode code;
+    uint64_t escapedBytes;
+};
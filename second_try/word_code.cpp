@@ -0,0 +1,343 @@
+#include "word_code.h"
+#include "utf8_code.h"
+#include "archive_format.h"
+#include "bitstream.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    const size_t INITIAL_SLOTS = 4096;
+
+    bool isAsciiWordChar(uint8_t byte) {
+        return (byte >= '0' && byte <= '9') || (byte >= 'A' && byte <= 'Z') || (byte >= 'a' && byte <= 'z');
+    }
+
+    // Буквы латиницы с диакритикой, греческого алфавита и кириллицы
+    bool isLetterCodepoint(uint32_t codepoint) {
+        if (codepoint >= 0xC0 && codepoint <= 0x24F) {
+            return codepoint != 0xD7 && codepoint != 0xF7;
+        }
+        return codepoint >= 0x370 && codepoint <= 0x52F;
+    }
+
+    // Класс символа в начале src (true - часть слова) и его длина в байтах
+    bool charClass(const uint8_t* src, size_t avail, size_t& length) {
+        uint8_t byte = src[0];
+        if (byte < 0x80) {
+            length = 1;
+            return isAsciiWordChar(byte);
+        }
+        uint32_t codepoint;
+        length = Utf8Code::sequenceLength(src, avail, codepoint);
+        if (length == 0) {
+            length = 1;
+            return false;
+        }
+        return isLetterCodepoint(codepoint);
+    }
+
+    uint32_t hashToken(const uint8_t* token, size_t length) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ token[i]) * 16777619u;
+        }
+        return hash;
+    }
+}
+
+WordCode::WordCode(std::pmr::memory_resource* resource)
+    : slots(resource),
+      entries(resource),
+      tokens(resource),
+      vocabulary(resource),
+      symbols(resource),
+      freqs(resource),
+      lengths(resource),
+      words(resource),
+      expansions(resource),
+      code(resource),
+      escapedBytes(0) {}
+
+uint32_t WordCode::findEntry(const uint8_t* src, size_t position, size_t length) {
+    // Заполнение таблицы не больше половины
+    if (2 * (entries.size() + 1) > slots.size()) {
+        growSlots();
+    }
+    uint32_t hash = hashToken(src + position, length);
+    size_t mask = slots.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        uint32_t index = slots[slot];
+        if (index == 0) {
+            entries.push_back(Entry{position, hash, static_cast<uint32_t>(length), 0, 0, 0});
+            slots[slot] = static_cast<uint32_t>(entries.size());
+            return static_cast<uint32_t>(entries.size() - 1);
+        }
+        const Entry& entry = entries[index - 1];
+        if (entry.hash == hash && entry.length == length &&
+            std::memcmp(src + entry.position, src + position, length) == 0) {
+            return index - 1;
+        }
+    }
+}
+
+void WordCode::growSlots() {
+    slots.assign(slots.size() * 2, 0);
+    size_t mask = slots.size() - 1;
+    for (size_t i = 0; i < entries.size(); i++) {
+        size_t slot = entries[i].hash & mask;
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = static_cast<uint32_t>(i + 1);
+    }
+}
+
+void WordCode::tokenize(const uint8_t* src, size_t size) {
+    slots.assign(INITIAL_SLOTS, 0);
+    entries.clear();
+    tokens.clear();
+
+    size_t pos = 0;
+    while (pos < size) {
+        size_t charLength;
+        bool word = charClass(src + pos, size - pos, charLength);
+        size_t length = charLength;
+        while (pos + length < size) {
+            if (charClass(src + pos + length, size - pos - length, charLength) != word ||
+                length + charLength > MAX_TOKEN_LENGTH) {
+                break;
+            }
+            length += charLength;
+        }
+
+        uint32_t index = findEntry(src, pos, length);
+        entries[index].count++;
+        tokens.push_back(index);
+        pos += length;
+    }
+}
+
+void WordCode::selectVocabulary(const uint8_t* src, size_t size) {
+    // Энтропия байтов - оценка цены лексемы, записанной байтовыми символами
+    uint64_t byteCounts[Common::ALPHABET_SIZE] = {};
+    for (size_t i = 0; i < size; i++) {
+        byteCounts[src[i]]++;
+    }
+    double byteBits = 0;
+    for (uint64_t count : byteCounts) {
+        if (count > 0) {
+            double p = static_cast<double>(count) / size;
+            byteBits -= p * std::log2(p);
+        }
+    }
+
+    // Выигрыш слова: разница побайтовой записи и кода слова по всем
+    // вхождениям за вычетом места в словаре (в среднем половина слова
+    // приходится на общий с предыдущим префикс)
+    double tokenCount = static_cast<double>(tokens.size());
+    auto gain = [&](const Entry& entry) {
+        double wordBits = std::log2(tokenCount / entry.count) + 1;
+        return entry.count * (entry.length * byteBits - wordBits) - 8.0 * (entry.length / 2.0 + 2) - LENGTH_BITS;
+    };
+
+    vocabulary.clear();
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Entry& entry = entries[i];
+        if (entry.count >= 2 && entry.length >= 2 && gain(entry) > 0) {
+            vocabulary.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    if (vocabulary.size() > MAX_WORDS) {
+        std::nth_element(vocabulary.begin(), vocabulary.begin() + MAX_WORDS, vocabulary.end(),
+                         [&](uint32_t a, uint32_t b) { return gain(entries[a]) > gain(entries[b]); });
+        vocabulary.resize(MAX_WORDS);
+    }
+    for (uint32_t index : vocabulary) {
+        entries[index].symbol = 1;
+    }
+
+    // Частые многобайтовые символы UTF-8 из лексем вне словаря тоже
+    // становятся словами: вместо 2-4 байтовых кодов - один
+    for (size_t i = 0; i < tokens.size(); i++) {
+        size_t position = entries[tokens[i]].position;
+        size_t length = entries[tokens[i]].length;
+        if (entries[tokens[i]].symbol != 0 || length < 2) continue;
+        for (size_t pos = position; pos < position + length;) {
+            uint32_t codepoint;
+            size_t charLength = Utf8Code::sequenceLength(src + pos, position + length - pos, codepoint);
+            if (charLength == 0) {
+                pos++;
+                continue;
+            }
+            entries[findEntry(src, pos, charLength)].escapes++;
+            pos += charLength;
+        }
+    }
+    for (size_t i = 0; i < entries.size() && vocabulary.size() < MAX_WORDS; i++) {
+        Entry& entry = entries[i];
+        if (entry.symbol == 0 && entry.escapes > 0 && entry.count + entry.escapes >= MIN_CHARACTER_COUNT) {
+            vocabulary.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    // Словарь по возрастанию - для записи с общими префиксами
+    std::sort(vocabulary.begin(), vocabulary.end(), [&](uint32_t a, uint32_t b) {
+        const Entry& x = entries[a];
+        const Entry& y = entries[b];
+        int order = std::memcmp(src + x.position, src + y.position, std::min(x.length, y.length));
+        return order != 0 ? order < 0 : x.length < y.length;
+    });
+    for (size_t i = 0; i < vocabulary.size(); i++) {
+        entries[vocabulary[i]].symbol = static_cast<uint32_t>(Common::ALPHABET_SIZE + i);
+    }
+}
+
+size_t WordCode::writeVocabulary(const uint8_t* src, uint8_t* dst, size_t capacity) const {
+    size_t offset = 0;
+    ArchiveWriter::writeVarint(dst, capacity, offset, vocabulary.size());
+    const uint8_t* previous = nullptr;
+    size_t previousLength = 0;
+    for (uint32_t index : vocabulary) {
+        const Entry& entry = entries[index];
+        const uint8_t* word = src + entry.position;
+        size_t shared = 0;
+        size_t limit = std::min<size_t>(previousLength, entry.length - 1);
+        while (shared < limit && previous[shared] == word[shared]) {
+            shared++;
+        }
+        size_t suffix = entry.length - shared;
+        if (capacity - offset < 2 + suffix) {
+            throw std::length_error("Destination buffer too small");
+        }
+        dst[offset++] = static_cast<uint8_t>(shared);
+        dst[offset++] = static_cast<uint8_t>(suffix);
+        std::memcpy(dst + offset, word + shared, suffix);
+        offset += suffix;
+        previous = word;
+        previousLength = entry.length;
+    }
+    return offset;
+}
+
+size_t WordCode::encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+    tokenize(src, size);
+    selectVocabulary(src, size);
+
+    size_t alphabet = Common::ALPHABET_SIZE + vocabulary.size();
+    freqs.assign(alphabet, 0);
+    symbols.clear();
+    symbols.reserve(size);
+    escapedBytes = 0;
+    for (uint32_t index : tokens) {
+        const Entry& entry = entries[index];
+        if (entry.symbol != 0) {
+            symbols.push_back(static_cast<uint16_t>(entry.symbol));
+            freqs[entry.symbol]++;
+            continue;
+        }
+        // Лексема вне словаря: символы UTF-8 из словаря, остальное - байтами
+        size_t end = entry.position + entry.length;
+        for (size_t pos = entry.position; pos < end;) {
+            uint32_t codepoint;
+            size_t charLength = entry.length > 1 ? Utf8Code::sequenceLength(src + pos, end - pos, codepoint) : 0;
+            uint32_t symbol = charLength != 0 ? entries[findEntry(src, pos, charLength)].symbol : 0;
+            if (symbol != 0) {
+                symbols.push_back(static_cast<uint16_t>(symbol));
+                freqs[symbol]++;
+                pos += charLength;
+                continue;
+            }
+            symbols.push_back(src[pos]);
+            freqs[src[pos]]++;
+            escapedBytes += entry.length > 1 ? 1 : 0;
+            pos++;
+        }
+    }
+    code.buildLimitedHuffman(freqs.data(), alphabet, MAX_CODE_LENGTH);
+
+    size_t offset = writeVocabulary(src, dst, capacity);
+    BitWriter out(dst + offset, capacity - offset);
+    for (size_t symbol = 0; symbol < alphabet; symbol++) {
+        out.writeBits(code.hasCode(static_cast<uint32_t>(symbol)) ? code.code(static_cast<uint32_t>(symbol)).length : 0,
+                      LENGTH_BITS);
+    }
+    code.encode(symbols.data(), symbols.size(), out);
+    out.flush();
+    return offset + out.bytesWritten();
+}
+
+void WordCode::decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size) {
+    size_t offset = 0;
+    uint64_t count = ArchiveWriter::readVarint(src, srcSize, offset);
+    if (count > MAX_WORDS) {
+        throw std::runtime_error("Corrupted word stream: vocabulary is too large");
+    }
+
+    // Байтовые символы и слова подряд; запас в MAX_TOKEN_LENGTH байт
+    // позволяет копировать любой символ блоком фиксированной длины
+    size_t alphabet = Common::ALPHABET_SIZE + count;
+    expansions.resize(alphabet);
+    words.resize(Common::ALPHABET_SIZE);
+    for (uint32_t byte = 0; byte < Common::ALPHABET_SIZE; byte++) {
+        words[byte] = static_cast<uint8_t>(byte);
+        expansions[byte] = Expansion{byte, 1};
+    }
+    size_t previous = 0;
+    size_t previousLength = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (srcSize - offset < 2) {
+            throw std::runtime_error("Word stream is truncated");
+        }
+        size_t shared = src[offset++];
+        size_t suffix = src[offset++];
+        if (shared > previousLength || suffix == 0 || shared + suffix > MAX_TOKEN_LENGTH) {
+            throw std::runtime_error("Corrupted word stream: invalid vocabulary entry");
+        }
+        if (srcSize - offset < suffix) {
+            throw std::runtime_error("Word stream is truncated");
+        }
+        size_t start = words.size();
+        words.resize(start + shared + suffix);
+        std::memcpy(words.data() + start, words.data() + previous, shared);
+        std::memcpy(words.data() + start + shared, src + offset, suffix);
+        offset += suffix;
+        expansions[Common::ALPHABET_SIZE + i] = Expansion{static_cast<uint32_t>(start),
+                                                          static_cast<uint32_t>(shared + suffix)};
+        previous = start;
+        previousLength = shared + suffix;
+    }
+    words.resize(words.size() + MAX_TOKEN_LENGTH, 0);
+
+    BitReader in(src + offset, srcSize - offset);
+    lengths.resize(alphabet);
+    for (size_t symbol = 0; symbol < alphabet; symbol++) {
+        lengths[symbol] = static_cast<uint8_t>(in.peekBits(LENGTH_BITS));
+        in.skipBits(LENGTH_BITS);
+        if (lengths[symbol] > MAX_CODE_LENGTH) {
+            throw std::runtime_error("Corrupted word stream: code is too long");
+        }
+    }
+    code.buildCanonical(lengths.data(), alphabet);
+
+    // Вдали от конца буфера слово копируется блоком MAX_TOKEN_LENGTH байт
+    size_t pos = 0;
+    while (size - pos >= MAX_TOKEN_LENGTH) {
+        const Expansion& expansion = expansions[code.decodeSymbol(in)];
+        std::memcpy(dst + pos, words.data() + expansion.offset, MAX_TOKEN_LENGTH);
+        pos += expansion.length;
+    }
+    while (pos < size) {
+        const Expansion& expansion = expansions[code.decodeSymbol(in)];
+        if (expansion.length > size - pos) {
+            throw std::runtime_error("Corrupted word stream: word crosses the end of data");
+        }
+        std::memcpy(dst + pos, words.data() + expansion.offset, expansion.length);
+        pos += expansion.length;
+    }
+
+    if (in.overrun()) {
+        throw std::runtime_error("Unexpected end of stream during decoding");
+    }
+}
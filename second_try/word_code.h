@@ -0,0 +1,80 @@
+// word_code.h - код Хаффмана по словам и разделителям
+#pragma once
+#include "common.h"
+#include "prefix_code.h"
+#include <memory_resource>
+#include <cstdint>
+#include <cstddef>
+
+// Вход разбивается на чередующиеся лексемы: слова (буквы и цифры ASCII,
+// латиница, греческий алфавит и кириллица в UTF-8) и всё остальное (пробелы,
+// знаки препинания, переводы строк). Лексема длиннее MAX_TOKEN_LENGTH байт
+// режется на части. Повторяющиеся лексемы, для которых код короче их
+// побайтовой записи с учётом места в словаре, попадают в словарь
+// (не больше MAX_WORDS); символ 256 + i - i-е слово словаря. Остальные
+// лексемы кодируются по символам: частые символы UTF-8 - тоже словами
+// словаря, прочее - байтовыми символами 0..255.
+// Коды канонические, не длиннее MAX_CODE_LENGTH бит, и декодирование за
+// один поиск по таблице выдаёт целое слово.
+//
+// Формат данных: число слов словаря (varint), слова по возрастанию
+// с общим префиксом (для каждого: длина общего с предыдущим словом префикса,
+// длина остатка - по байту, затем байты остатка), затем поток старшими
+// битами вперёд: длины кодов алфавита 256 + N по LENGTH_BITS бит и коды лексем.
+class WordCode {
+public:
+    static const size_t MAX_TOKEN_LENGTH = 32;
+    static const uint32_t MAX_WORDS = 32768;
+    // Многобайтовый символ UTF-8 из лексем вне словаря получает свой код,
+    // если встречается хотя бы столько раз
+    static const uint32_t MIN_CHARACTER_COUNT = 4;
+    static const int MAX_CODE_LENGTH = 24;
+    static const int LENGTH_BITS = 5;
+
+    explicit WordCode(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Возвращает размер закодированных данных; std::length_error, если не хватает места
+    size_t encode(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity);
+    void decode(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size);
+
+    // Статистика последнего encode
+    uint32_t lastWords() const { return static_cast<uint32_t>(vocabulary.size()); }
+    uint64_t lastTokens() const { return tokens.size(); }
+    uint64_t lastEscapedBytes() const { return escapedBytes; }
+
+private:
+    // Различная лексема входа: первое вхождение, длина, число повторов,
+    // число вхождений внутри лексем вне словаря (для символов UTF-8) и символ
+    struct Entry {
+        uint64_t position;
+        uint32_t hash;
+        uint32_t length;
+        uint32_t count;
+        uint32_t escapes;
+        uint32_t symbol;
+    };
+    // Байты символа для декодирования: смещение в words и длина
+    struct Expansion {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    void tokenize(const uint8_t* src, size_t size);
+    uint32_t findEntry(const uint8_t* src, size_t position, size_t length);
+    void growSlots();
+    void selectVocabulary(const uint8_t* src, size_t size);
+    size_t writeVocabulary(const uint8_t* src, uint8_t* dst, size_t capacity) const;
+
+    // Открытая адресация: в слоте - номер записи entries + 1, 0 - пусто
+    std::pmr::vector<uint32_t> slots;
+    std::pmr::vector<Entry> entries;
+    std::pmr::vector<uint32_t> tokens;
+    std::pmr::vector<uint32_t> vocabulary;
+    std::pmr::vector<uint16_t> symbols;
+    std::pmr::vector<uint64_t> freqs;
+    std::pmr::vector<uint8_t> lengths;
+    std::pmr::vector<uint8_t> words;
+    std::pmr::vector<Expansion> expansions;
+    PrefixCode code;
+    uint64_t escapedBytes;
+};